@@ -0,0 +1,85 @@
+// Request-head parsing benchmark: scalar vs SIMD byte scanners
+// ============================================================
+// Parses header-heavy request heads (large Cookie and Authorization
+// values, as sent by browsers behind an auth proxy) in a tight loop once
+// per scanner kernel the CPU supports, and prints heads/sec, MB/s and the
+// speedup over the scalar loop.
+//
+// Usage: bench_header_scan [iterations]
+
+#define _GNU_SOURCE
+#include "src/parsers/http_parser.h"
+#include "src/parsers/http_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static size_t build_head(char *buffer, size_t size, size_t cookie_len) {
+    char *cookie = malloc(cookie_len + 1);
+    memset(cookie, 'c', cookie_len);
+    for (size_t i = 40; i < cookie_len; i += 41) cookie[i] = ';';
+    cookie[cookie_len] = '\0';
+
+    int len = snprintf(buffer, size,
+                       "GET /api/v1/users/42/orders?limit=20 HTTP/1.1\r\n"
+                       "Host: api.example.com\r\n"
+                       "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+                       "Accept: application/json, text/plain, */*\r\n"
+                       "Accept-Encoding: gzip, deflate, br\r\n"
+                       "Authorization: Bearer %.*s\r\n"
+                       "Cookie: %s\r\n"
+                       "Connection: keep-alive\r\n"
+                       "\r\n",
+                       (int)(cookie_len < 900 ? cookie_len : 900), cookie, cookie);
+    free(cookie);
+    return (size_t)len;
+}
+
+static double run_kernel(const char *head, size_t head_len, long iterations) {
+    struct timespec start, end;
+    size_t checksum = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < iterations; i++) {
+        HttpParser parser;
+        http_parser_init(&parser);
+        if (http_parser_execute(&parser, head, head_len) != HTTP_PARSE_DONE) return -1.0;
+        checksum += parser.consumed;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (checksum != head_len * (size_t)iterations) return -1.0;
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return iterations / elapsed;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 200000;
+    HttpScanKernel kernels[] = { HTTP_SCAN_SCALAR, HTTP_SCAN_SSE42, HTTP_SCAN_AVX2 };
+    size_t cookie_sizes[] = { 64, 1024, 4096 };
+    static char head[8192];
+
+    printf("=== C-Express Header Scan Benchmark ===\n");
+    printf("Iterations: %ld, auto-selected kernel: %s\n\n", iterations,
+           http_scan_kernel_name(http_scan_kernel()));
+    printf("%-8s %-8s %-14s %-10s %s\n", "Head", "Kernel", "Heads/sec", "MB/s", "Speedup");
+
+    for (size_t s = 0; s < sizeof(cookie_sizes) / sizeof(cookie_sizes[0]); s++) {
+        size_t head_len = build_head(head, sizeof(head), cookie_sizes[s]);
+        double baseline = 0.0;
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            if (http_scan_set_kernel(kernels[k]) < 0) continue;
+            double rate = run_kernel(head, head_len, iterations);
+            if (rate < 0) {
+                fprintf(stderr, "parse failed with the %s kernel\n", http_scan_kernel_name(kernels[k]));
+                return 1;
+            }
+            if (kernels[k] == HTTP_SCAN_SCALAR) baseline = rate;
+            printf("%-8zu %-8s %-14.0f %-10.1f %.2f\n", head_len, http_scan_kernel_name(kernels[k]),
+                   rate, rate * head_len / 1e6, baseline > 0 ? rate / baseline : 0.0);
+        }
+    }
+    return 0;
+}
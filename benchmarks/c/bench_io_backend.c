@@ -0,0 +1,183 @@
+// I/O backend comparison benchmark: epoll vs io_uring
+// ====================================================
+// Starts the server once per backend and drives it with keep-alive client
+// threads, each holding one connection and sending requests back to back.
+// Prints requests/sec per backend and the io_uring speedup over epoll.
+//
+// Usage: bench_io_backend [seconds_per_run] [connections]
+
+#define _GNU_SOURCE
+#include "src/core/app.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define BENCH_BASE_PORT 3300
+
+static volatile int stop_clients = 0;
+
+typedef struct {
+    int port;
+    long requests;
+    long errors;
+    pthread_t thread;
+} ClientThread;
+
+static void hello_handler(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    Response *res = (Response *)ctx->user_context;
+    res->json(res, "{\"message\":\"Hello from C-Express\"}");
+}
+
+static void run_server(int port, AppIOBackend backend) {
+    App app = create_app();
+    app.get(&app, "/", hello_handler);
+    app_set_keep_alive(&app, 30, 0);
+    app_set_io_backend(&app, backend);
+    app.listen(&app, port);
+}
+
+static int client_connect(int port) {
+    struct sockaddr_in addr;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Read one response; the fixed handler makes its size constant, so the
+// first complete response tells us how many bytes to expect
+static int client_read_response(int fd, size_t *response_len) {
+    char buffer[1024];
+    size_t total = 0;
+
+    while (*response_len == 0 || total < *response_len) {
+        ssize_t n = recv(fd, buffer + total, sizeof(buffer) - 1 - total, 0);
+        if (n <= 0) return -1;
+        total += n;
+        buffer[total] = '\0';
+
+        if (*response_len == 0) {
+            char *end = strstr(buffer, "\r\n\r\n");
+            char *length = strstr(buffer, "Content-Length: ");
+            if (end && length) {
+                *response_len = (end - buffer) + 4 + atoi(length + 16);
+            }
+        }
+    }
+    return strncmp(buffer, "HTTP/1.1 200", 12) == 0 ? 0 : -1;
+}
+
+static void *client_main(void *arg) {
+    static const char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ClientThread *client = (ClientThread *)arg;
+    size_t response_len = 0;
+    int fd = -1;
+
+    while (!stop_clients) {
+        if (fd < 0 && (fd = client_connect(client->port)) < 0) {
+            client->errors++;
+            usleep(1000);
+            continue;
+        }
+        if (send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL) < 0 ||
+            client_read_response(fd, &response_len) < 0) {
+            client->errors++;
+            close(fd);
+            fd = -1;
+            continue;
+        }
+        client->requests++;
+    }
+
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+static double run_load(int port, int n_clients, int seconds, long *errors) {
+    ClientThread *clients = calloc(n_clients, sizeof(ClientThread));
+    struct timespec start, end;
+
+    stop_clients = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < n_clients; i++) {
+        clients[i].port = port;
+        pthread_create(&clients[i].thread, NULL, client_main, &clients[i]);
+    }
+
+    sleep(seconds);
+    stop_clients = 1;
+
+    long total = 0;
+    *errors = 0;
+    for (int i = 0; i < n_clients; i++) {
+        pthread_join(clients[i].thread, NULL);
+        total += clients[i].requests;
+        *errors += clients[i].errors;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(clients);
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return total / elapsed;
+}
+
+int main(int argc, char **argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    int n_clients = argc > 2 ? atoi(argv[2]) : 64;
+    const char *names[] = { "epoll", "io_uring" };
+    AppIOBackend backends[] = { APP_IO_EPOLL, APP_IO_URING };
+    double baseline = 0.0;
+
+    printf("=== C-Express I/O Backend Benchmark ===\n");
+    printf("Keep-alive connections: %d, %ds per run\n\n", n_clients, seconds);
+    printf("%-10s %-14s %-10s %s\n", "Backend", "Requests/sec", "Speedup", "Errors");
+
+    for (int i = 0; i < 2; i++) {
+        int port = BENCH_BASE_PORT + i;
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            run_server(port, backends[i]);
+            _exit(0);
+        }
+
+        usleep(200000);  // Let the server bind and start its loop
+
+        long errors = 0;
+        double rps = run_load(port, n_clients, seconds, &errors);
+        if (i == 0) baseline = rps;
+
+        printf("%-10s %-14.0f %-10.2f %ld\n", names[i], rps,
+               baseline > 0 ? rps / baseline : 0.0, errors);
+
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+    }
+
+    printf("\nio_uring falls back to epoll when the kernel lacks support;\n");
+    printf("build with -DC_EXPRESS_DEBUG to see which loop was started.\n");
+    return 0;
+}
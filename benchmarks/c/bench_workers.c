@@ -0,0 +1,163 @@
+// Multi-core scaling benchmark for app_listen_workers
+// =======================================================
+// Starts the server with 1, 2, 4, ... worker threads and drives it with a
+// fixed pool of client threads, printing requests/sec and speedup over a
+// single worker.
+//
+// Usage: bench_workers [seconds_per_run] [max_workers]
+
+#define _GNU_SOURCE
+#include "src/core/app.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define BENCH_BASE_PORT 3200
+
+static volatile int stop_clients = 0;
+
+typedef struct {
+    int port;
+    long requests;
+    long errors;
+    pthread_t thread;
+} ClientThread;
+
+static void hello_handler(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    Response *res = (Response *)ctx->user_context;
+    res->json(res, "{\"message\":\"Hello from C-Express\"}");
+}
+
+static void run_server(int port, int workers) {
+    App app = create_app();
+    app.get(&app, "/", hello_handler);
+    app_listen_workers(&app, port, workers);
+}
+
+// One request on a fresh connection; returns 0 on a complete 200 response
+static int client_request(int port) {
+    static const char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    struct sockaddr_in addr;
+    char buffer[1024];
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    ssize_t total = 0, n;
+    while ((n = recv(fd, buffer + total, sizeof(buffer) - 1 - total, 0)) > 0) {
+        total += n;
+        if (total >= (ssize_t)sizeof(buffer) - 1) break;
+    }
+    close(fd);
+
+    buffer[total] = '\0';
+    return strncmp(buffer, "HTTP/1.1 200", 12) == 0 ? 0 : -1;
+}
+
+static void *client_main(void *arg) {
+    ClientThread *client = (ClientThread *)arg;
+    while (!stop_clients) {
+        if (client_request(client->port) == 0) {
+            client->requests++;
+        } else {
+            client->errors++;
+        }
+    }
+    return NULL;
+}
+
+static double run_load(int port, int n_clients, int seconds, long *errors) {
+    ClientThread *clients = calloc(n_clients, sizeof(ClientThread));
+    struct timespec start, end;
+
+    stop_clients = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < n_clients; i++) {
+        clients[i].port = port;
+        pthread_create(&clients[i].thread, NULL, client_main, &clients[i]);
+    }
+
+    sleep(seconds);
+    stop_clients = 1;
+
+    long total = 0;
+    *errors = 0;
+    for (int i = 0; i < n_clients; i++) {
+        pthread_join(clients[i].thread, NULL);
+        total += clients[i].requests;
+        *errors += clients[i].errors;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(clients);
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return total / elapsed;
+}
+
+int main(int argc, char **argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_workers = argc > 2 ? atoi(argv[2]) : (cpus > 0 ? (int)cpus : 1);
+    int n_clients = max_workers * 4 < 16 ? 16 : max_workers * 4;
+    double baseline = 0.0;
+
+    printf("=== C-Express Worker Scaling Benchmark ===\n");
+    printf("CPUs: %ld, clients: %d, %ds per run\n\n", cpus, n_clients, seconds);
+    printf("%-10s %-14s %-10s %s\n", "Workers", "Requests/sec", "Speedup", "Errors");
+
+    for (int workers = 1; workers <= max_workers; ) {
+        int port = BENCH_BASE_PORT + workers;
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            run_server(port, workers);
+            _exit(0);
+        }
+
+        usleep(200000);  // Let the workers bind and start their loops
+
+        long errors = 0;
+        double rps = run_load(port, n_clients, seconds, &errors);
+        if (workers == 1) baseline = rps;
+
+        printf("%-10d %-14.0f %-10.2f %ld\n", workers, rps,
+               baseline > 0 ? rps / baseline : 0.0, errors);
+
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+
+        // Double each run, always finishing with a run at max_workers
+        if (workers < max_workers && workers * 2 > max_workers) {
+            workers = max_workers;
+        } else {
+            workers *= 2;
+        }
+    }
+
+    return 0;
+}
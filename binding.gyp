@@ -10,16 +10,23 @@
         "addon/src/router_binding.cpp",
         "addon/src/utils.cpp",
         "src/core/app.c",
+        "src/core/arena.c",
         "src/core/router.c",
         "src/core/route.c",
+        "src/core/route_tree.c",
         "src/core/layer.c",
+        "src/core/event_loop.c",
+        "src/core/uring_loop.c",
         "src/http/request.c",
         "src/http/response.c",
         "src/http/error.c",
         "src/http/negotiation.c",
         "src/http/streaming.c",
+        "src/http/connection.c",
         "src/parsers/json.c",
-        "src/parsers/form.c"
+        "src/parsers/form.c",
+        "src/parsers/http_parser.c",
+        "src/parsers/http_scan.c"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
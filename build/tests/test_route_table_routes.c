@@ -0,0 +1,320 @@
+// Generated by routegen from tests/c/test_route_table.routes; do not edit.
+// 13 routes: 5 static paths, 6 parameterized routes.
+
+#include "route_table.h"
+#include "route.h"
+#include <stdint.h>
+#include <string.h>
+
+void h_root(int client_fd, void (*next)(void *), void *context);
+void h_users(int client_fd, void (*next)(void *), void *context);
+void h_users_create(int client_fd, void (*next)(void *), void *context);
+void h_user(int client_fd, void (*next)(void *), void *context);
+void h_me(int client_fd, void (*next)(void *), void *context);
+void h_item(int client_fd, void (*next)(void *), void *context);
+void h_latest(int client_fd, void (*next)(void *), void *context);
+void h_tag(int client_fd, void (*next)(void *), void *context);
+void h_files(int client_fd, void (*next)(void *), void *context);
+void h_docs(int client_fd, void (*next)(void *), void *context);
+void h_session(int client_fd, void (*next)(void *), void *context);
+void h_ping(int client_fd, void (*next)(void *), void *context);
+
+static const RouteTableEntry test_routes_routes[13] = {
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/", h_root },
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/users", h_users },
+    { HTTP_METHOD_BIT(HTTP_METHOD_POST), "/users", h_users_create },
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/users/:id", h_user },
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/users/me", h_me },
+    { HTTP_METHOD_BIT(HTTP_METHOD_POST), "/users/me", h_me },
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/items/:id:number", h_item },
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/items/latest", h_latest },
+    { HTTP_METHOD_BIT(HTTP_METHOD_PUT), "/items/:id:number/tags/:tag", h_tag },
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/files/*", h_files },
+    { HTTP_METHOD_BIT(HTTP_METHOD_GET), "/docs/:section:slug/*", h_docs },
+    { HTTP_METHOD_BIT(HTTP_METHOD_DELETE), "/sessions/:token:uuid", h_session },
+    { HTTP_METHOD_BIT(HTTP_METHOD_HEAD), "/ping", h_ping },
+};
+
+// Static paths: a displacement per bucket of the path hash, then one slot
+static const uint32_t test_routes_displace[4] = {
+    0u, 0u, 0u, 2u
+};
+
+static const struct {
+    const char *path;
+    size_t length;
+    int route[HTTP_METHOD_COUNT];   // Per method; -2: a parameterized route
+    unsigned int allowed;
+} test_routes_static[16] = {
+    { "/ping", 5, { -1, -1, 12, -1, -1, -1, -1, -1, -1, -1 }, 0x4u },
+    { NULL, 0, { 0 }, 0 },
+    { "/items/latest", 13, { -1, 7, -1, -1, -1, -1, -1, -1, -1, -1 }, 0x2u },
+    { NULL, 0, { 0 }, 0 },
+    { NULL, 0, { 0 }, 0 },
+    { NULL, 0, { 0 }, 0 },
+    { NULL, 0, { 0 }, 0 },
+    { "/", 1, { -1, 0, -1, -1, -1, -1, -1, -1, -1, -1 }, 0x2u },
+    { NULL, 0, { 0 }, 0 },
+    { NULL, 0, { 0 }, 0 },
+    { NULL, 0, { 0 }, 0 },
+    { NULL, 0, { 0 }, 0 },
+    { "/users", 6, { -1, 1, -1, 2, -1, -1, -1, -1, -1, -1 }, 0xau },
+    { "/users/me", 9, { -1, -2, -1, 5, -1, -1, -1, -1, -1, -1 }, 0xau },
+    { NULL, 0, { 0 }, 0 },
+    { NULL, 0, { 0 }, 0 },
+};
+
+// Parameterized paths, by segment count and first segment
+static int test_routes_match(HttpMethod method, const char *path, ParamSlice *slices, int *slice_count,
+                             unsigned int *allowed) {
+    const char *seg[5];
+    size_t len[5];
+    size_t pos = 0;
+    int count = 0;
+    while (count <= 4 && path_next_segment(path, &pos, &seg[count], &len[count])) count++;
+
+    switch (count) {
+    case 1:
+        switch (len[0]) {
+        case 5:
+            if (memcmp(seg[0], "files", 5) == 0) {
+                // GET /files/*
+                {
+                    if (method == HTTP_METHOD_GET) {
+                        return 9;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        }
+        break;
+    case 2:
+        switch (len[0]) {
+        case 5:
+            if (memcmp(seg[0], "users", 5) == 0) {
+                // GET /users/:id
+                if (len[1] > 0) {
+                    if (method == HTTP_METHOD_GET) {
+                        slices[0].name = "id";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        *slice_count = 1;
+                        return 3;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            if (memcmp(seg[0], "items", 5) == 0) {
+                // GET /items/:id:number
+                if (validate_parameter_slice(seg[1], len[1], PARAM_NUMBER)) {
+                    if (method == HTTP_METHOD_GET) {
+                        slices[0].name = "id";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        *slice_count = 1;
+                        return 6;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            if (memcmp(seg[0], "files", 5) == 0) {
+                // GET /files/*
+                {
+                    if (method == HTTP_METHOD_GET) {
+                        return 9;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        case 4:
+            if (memcmp(seg[0], "docs", 4) == 0) {
+                // GET /docs/:section:slug/*
+                if (validate_parameter_slice(seg[1], len[1], PARAM_SLUG)) {
+                    if (method == HTTP_METHOD_GET) {
+                        slices[0].name = "section";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        *slice_count = 1;
+                        return 10;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        case 8:
+            if (memcmp(seg[0], "sessions", 8) == 0) {
+                // DELETE /sessions/:token:uuid
+                if (validate_parameter_slice(seg[1], len[1], PARAM_UUID)) {
+                    if (method == HTTP_METHOD_DELETE) {
+                        slices[0].name = "token";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        *slice_count = 1;
+                        return 11;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_DELETE);
+                }
+                return -1;
+            }
+            break;
+        }
+        break;
+    case 3:
+        switch (len[0]) {
+        case 5:
+            if (memcmp(seg[0], "files", 5) == 0) {
+                // GET /files/*
+                {
+                    if (method == HTTP_METHOD_GET) {
+                        return 9;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        case 4:
+            if (memcmp(seg[0], "docs", 4) == 0) {
+                // GET /docs/:section:slug/*
+                if (validate_parameter_slice(seg[1], len[1], PARAM_SLUG)) {
+                    if (method == HTTP_METHOD_GET) {
+                        slices[0].name = "section";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        *slice_count = 1;
+                        return 10;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        }
+        break;
+    case 4:
+        switch (len[0]) {
+        case 5:
+            if (memcmp(seg[0], "items", 5) == 0) {
+                // PUT /items/:id:number/tags/:tag
+                if (validate_parameter_slice(seg[1], len[1], PARAM_NUMBER) &&
+                    len[2] == 4 && memcmp(seg[2], "tags", 4) == 0 &&
+                    len[3] > 0) {
+                    if (method == HTTP_METHOD_PUT) {
+                        slices[0].name = "id";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        slices[1].name = "tag";
+                        slices[1].value = seg[3];
+                        slices[1].length = len[3];
+                        *slice_count = 2;
+                        return 8;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_PUT);
+                }
+                return -1;
+            }
+            if (memcmp(seg[0], "files", 5) == 0) {
+                // GET /files/*
+                {
+                    if (method == HTTP_METHOD_GET) {
+                        return 9;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        case 4:
+            if (memcmp(seg[0], "docs", 4) == 0) {
+                // GET /docs/:section:slug/*
+                if (validate_parameter_slice(seg[1], len[1], PARAM_SLUG)) {
+                    if (method == HTTP_METHOD_GET) {
+                        slices[0].name = "section";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        *slice_count = 1;
+                        return 10;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        }
+        break;
+    default:   // More segments than any fixed route: wildcards only
+        switch (len[0]) {
+        case 5:
+            if (memcmp(seg[0], "files", 5) == 0) {
+                // GET /files/*
+                {
+                    if (method == HTTP_METHOD_GET) {
+                        return 9;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        case 4:
+            if (memcmp(seg[0], "docs", 4) == 0) {
+                // GET /docs/:section:slug/*
+                if (validate_parameter_slice(seg[1], len[1], PARAM_SLUG)) {
+                    if (method == HTTP_METHOD_GET) {
+                        slices[0].name = "section";
+                        slices[0].value = seg[1];
+                        slices[0].length = len[1];
+                        *slice_count = 1;
+                        return 10;
+                    }
+                    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_GET);
+                }
+                return -1;
+            }
+            break;
+        }
+        break;
+    }
+    return -1;
+}
+
+static int test_routes_lookup(HttpMethod method, const char *path, ParamSlice *slices, int *slice_count,
+                              unsigned int *allowed) {
+    *slice_count = 0;
+    *allowed = 0;
+    uint32_t hash = 2166136261u ^ 1u;
+    size_t length = 0;
+    for (; path[length]; length++) {
+        hash ^= (unsigned char)path[length];
+        hash *= 16777619u;
+    }
+    hash ^= test_routes_displace[hash & 3u];
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    hash *= 0x846ca68bu;
+    hash ^= hash >> 16;
+    uint32_t slot = hash & 15u;
+    if (test_routes_static[slot].length == length && test_routes_static[slot].path &&
+        memcmp(test_routes_static[slot].path, path, length) == 0) {
+        int route = test_routes_static[slot].route[method];
+        if (route != -2) {
+            if (route < 0) *allowed = test_routes_static[slot].allowed;
+            return route;
+        }
+    }
+    return test_routes_match(method, path, slices, slice_count, allowed);
+}
+
+const RouteTable test_routes = { "test_routes", test_routes_routes, 13, test_routes_lookup };
+
+void test_routes_handler(int client_fd, void (*next)(void *), void *context) {
+    route_table_dispatch(&test_routes, client_fd, next, context);
+}
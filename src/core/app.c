@@ -1,17 +1,24 @@
 #define _GNU_SOURCE
 #include "app.h"
+#include "frozen_router.h"
+#include "epoch.h"
+#include "route_snapshot.h"
+#include "event_loop.h"
+#include "uring_loop.h"
 #include "../debug.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <netinet/in.h>
+#include <sys/socket.h>
 #include <stddef.h>
+#include <pthread.h>
 
 // Default error handler
 void default_error_handler(Error *error, int client_fd, void *context) {
-    (void)context; // Suppress unused parameter warning
-    Response *res = create_response(client_fd);
+    NextContext *ctx = (NextContext *)context;
+    Response *res = create_response_in(client_fd, ctx ? ctx->arena : NULL);
     
     // Set appropriate status code
     response_status(res, error->status_code);
@@ -39,13 +46,55 @@ void default_error_handler(Error *error, int client_fd, void *context) {
     error->is_handled = true;
 }
 
+// on_complete of every chain express_init starts: runs once the last
+// handler is done, which may be after the chain was paused and resumed.
+// The context itself lives in the arena reset here.
+static void express_finish(NextContext *ctx) {
+    DEBUG_PRINT_STR("express_finish: middleware chain completed\n");
+    
+    // Clean up JSON and form resources from request if they were used
+    if (ctx->req) {
+        request_free_json(ctx->req);
+        request_free_form(ctx->req);
+        
+        // Clean up streaming resources
+        if (ctx->req->stream) {
+            DEBUG_PRINT_STR("express_finish: cleaning up streaming resources\n");
+            request_free_stream(ctx->req);
+        }
+        
+        DEBUG_PRINT_STR("express_finish: cleaned up JSON and form data resources\n");
+    }
+    
+    // Check for unhandled errors after middleware chain
+    if (error_context_has_error(ctx->error_ctx) && !ctx->error_ctx->current_error->is_handled) {
+        ERROR_PRINT("Unhandled error caught: %s\n", ctx->error_ctx->current_error->message);
+        
+        // Use custom error handler if available
+        if (ctx->app && ctx->app->error_handler) {
+            ctx->app->error_handler(ctx->error_ctx->current_error, ctx->client_fd, ctx);
+        } else {
+            default_error_handler(ctx->error_ctx->current_error, ctx->client_fd, ctx);
+        }
+    }
+    
+    destroy_error_context(ctx->error_ctx);
+    destroy_response((Response *)ctx->user_context);
+    if (ctx->arena) {
+        DEBUG_PRINT("express_finish: releasing %zu arena allocations\n", ctx->arena->allocations);
+        arena_reset(ctx->arena);
+    }
+    DEBUG_PRINT_STR("express_finish: cleanup completed\n");
+}
+
 // middleware to attach Response and ErrorContext to each request
 void express_init(int client_fd, void (*next)(void *), void *context) {
     NextContext *ctx = (NextContext *)context;
-    Response *res = malloc(sizeof(Response));
-    ErrorContext *error_ctx = create_error_context();
+    // Everything the request needs comes from its arena, released in one
+    // reset once the chain has completed
+    Response *res = create_response_in(client_fd, ctx->arena);
+    ErrorContext *error_ctx = create_error_context_in(ctx->arena);
     
-    response_init(res, client_fd);
     ctx->user_context = res;
     ctx->error_ctx = error_ctx;
     
@@ -68,251 +117,426 @@ void express_init(int client_fd, void (*next)(void *), void *context) {
         DEBUG_PRINT_STR("express_init: request is using legacy mode\n");
     }
     
+    ctx->on_complete = express_finish;
     next(ctx);
-    
-    DEBUG_PRINT_STR("express_init: middleware chain completed\n");
-    
-    // Clean up JSON and form resources from request if they were used
-    if (ctx->req) {
-        request_free_json(ctx->req);
-        request_free_form(ctx->req);
-        
-        // Clean up streaming resources
-        if (ctx->req->stream) {
-            DEBUG_PRINT_STR("express_init: cleaning up streaming resources\n");
-            request_free_stream(ctx->req);
-        }
-        
-        DEBUG_PRINT_STR("express_init: cleaned up JSON and form data resources\n");
-    }
-    
-    // Check for unhandled errors after middleware chain
-    if (error_context_has_error(error_ctx) && !error_ctx->current_error->is_handled) {
-        ERROR_PRINT("Unhandled error caught: %s\n", error_ctx->current_error->message);
-        
-        // Use custom error handler if available
-        if (ctx->app && ctx->app->error_handler) {
-            ctx->app->error_handler(error_ctx->current_error, client_fd, ctx);
-        } else {
-            default_error_handler(error_ctx->current_error, client_fd, ctx);
-        }
+}
+
+// Serializes publishers; readers never take it
+static pthread_mutex_t publish_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Whether the app dispatches on a published draft, which app->router no
+// longer feeds. Retired tables are freed under publish_lock, so the one
+// read here stays valid.
+static int app_published(App *app) {
+    pthread_mutex_lock(&publish_lock);
+    FrozenRouter *frozen = __atomic_load_n(&app->frozen, __ATOMIC_SEQ_CST);
+    int published = frozen && frozen->owned_router;
+    pthread_mutex_unlock(&publish_lock);
+    return published;
+}
+
+// Thaw before app->router changes; refused once a draft is published, as
+// the change would either be lost or drop the published routes
+static int app_edit_router(App *app, const char *caller) {
+    if (app_published(app)) {
+        ERROR_PRINT("%s: routes were published, register them on a draft (app_draft_router)\n", caller);
+        return 0;
     }
-    
-    destroy_error_context(error_ctx);
-    free(res);
-    DEBUG_PRINT_STR("express_init: cleanup completed\n");
+    app_thaw(app);
+    return 1;
 }
 
 void app_get(App *app, const char *path, Handler handler) {
     DEBUG_PRINT("app_get: path=%s\n", path);
+    if (!app_edit_router(app, "app_get")) return;
     router_add_layer(&app->router, "GET", path, handler);
 }
 
 void app_post(App *app, const char *path, Handler handler) {
     DEBUG_PRINT("app_post: path=%s\n", path);
+    if (!app_edit_router(app, "app_post")) return;
     router_add_layer(&app->router, "POST", path, handler);
 }
 
 void app_put(App *app, const char *path, Handler handler) {
     DEBUG_PRINT("app_put: path=%s\n", path);
+    if (!app_edit_router(app, "app_put")) return;
     router_add_layer(&app->router, "PUT", path, handler);
 }
 
 void app_delete(App *app, const char *path, Handler handler) {
     DEBUG_PRINT("app_delete: path=%s\n", path);
+    if (!app_edit_router(app, "app_delete")) return;
     router_add_layer(&app->router, "DELETE", path, handler);
 }
 
 void app_patch(App *app, const char *path, Handler handler) {
     DEBUG_PRINT("app_patch: path=%s\n", path);
+    if (!app_edit_router(app, "app_patch")) return;
     router_add_layer(&app->router, "PATCH", path, handler);
 }
 
 void app_options(App *app, const char *path, Handler handler) {
     DEBUG_PRINT("app_options: path=%s\n", path);
+    if (!app_edit_router(app, "app_options")) return;
     router_add_layer(&app->router, "OPTIONS", path, handler);
 }
 
 void app_use(App *app, Handler handler) {
     DEBUG_PRINT_STR("app_use: registering middleware\n");
+    if (!app_edit_router(app, "app_use")) return;
     router_add_layer(&app->router, "USE", "/", handler);
 }
 
 void app_mount(App *app, const char *prefix, Router *router) {
     DEBUG_PRINT("app_mount: mounting router at prefix=%s\n", prefix);
+    if (!app_edit_router(app, "app_mount")) return;
     router_mount(&app->router, prefix, router);
 }
 
+void app_vhost(App *app, const char *host, Router *router) {
+    DEBUG_PRINT("app_vhost: mounting router for host=%s\n", host ? host : "NULL");
+    if (!app_edit_router(app, "app_vhost")) return;
+    router_vhost(&app->router, host, router);
+}
+
+Router *app_draft_router(App *app) {
+    Router *router = create_router();
+    if (router) {
+        router->snapshot = app->router.snapshot;
+        router_add_layer(router, "USE", "/", express_init);
+    }
+    return router;
+}
+
+// Caller holds publish_lock
+static int app_reclaim_locked(App *app) {
+    int pending = 0;
+    FrozenRouter **link = &app->retired;
+    while (*link) {
+        FrozenRouter *retired = *link;
+        // Pins are only taken inside a read section, so once the sections
+        // have drained the count is final
+        if (epoch_safe(retired->retire_epoch) && __atomic_load_n(&retired->pins, __ATOMIC_ACQUIRE) == 0) {
+            DEBUG_PRINT("app_reclaim_routers: freeing table retired at epoch %lu\n", retired->retire_epoch);
+            *link = retired->retired_next;
+            frozen_router_destroy(retired);
+        } else {
+            pending++;
+            link = &retired->retired_next;
+        }
+    }
+    return pending;
+}
+
+// Queue a table swapped out of app->frozen to be freed once drained; caller
+// holds publish_lock
+static void app_retire_locked(App *app, FrozenRouter *old) {
+    if (!old) return;
+    old->retire_epoch = epoch_advance();
+    old->retired_next = app->retired;
+    app->retired = old;
+}
+
+int app_publish_router(App *app, Router *router) {
+    FrozenRouter *frozen = router_freeze(router);
+    if (!frozen) {
+        ERROR_PRINT_STR("app_publish_router: could not compile the routes\n");
+        return -1;
+    }
+    frozen->cache_entries = app->route_cache_entries;
+    frozen->owned_router = router;
+
+    pthread_mutex_lock(&publish_lock);
+    app_retire_locked(app, __atomic_exchange_n(&app->frozen, frozen, __ATOMIC_SEQ_CST));
+    int pending = app_reclaim_locked(app);
+    pthread_mutex_unlock(&publish_lock);
+    DEBUG_PRINT("app_publish_router: %d layers published, %d old tables draining\n", router->layer_count, pending);
+    (void)pending;
+    return 0;
+}
+
+int app_reclaim_routers(App *app) {
+    pthread_mutex_lock(&publish_lock);
+    int pending = app_reclaim_locked(app);
+    pthread_mutex_unlock(&publish_lock);
+    return pending;
+}
+
+void app_freeze(App *app) {
+    if (!app_edit_router(app, "app_freeze")) return;
+    FrozenRouter *frozen = router_freeze(&app->router);
+    if (!frozen) {
+        ERROR_PRINT_STR("app_freeze: could not compile the routes, dispatching unfrozen\n");
+        return;
+    }
+    frozen->cache_entries = app->route_cache_entries;
+    __atomic_store_n(&app->frozen, frozen, __ATOMIC_SEQ_CST);
+}
+
+// Retired like a replaced table: requests in flight or paused on it keep
+// it until they are done
+void app_thaw(App *app) {
+    pthread_mutex_lock(&publish_lock);
+    app_retire_locked(app, __atomic_exchange_n(&app->frozen, NULL, __ATOMIC_SEQ_CST));
+    app_reclaim_locked(app);
+    pthread_mutex_unlock(&publish_lock);
+}
+
 void app_error(App *app, ErrorHandler handler) {
     DEBUG_PRINT_STR("app_error: registering error handler\n");
     app->error_handler = handler;
 }
 
-void app_listen(App *app, int port) {
-    int server_fd, client_fd;
-    struct sockaddr_in address;
-    int addrlen = sizeof(address);
+void app_set_keep_alive(App *app, int timeout_seconds, int max_requests) {
+    DEBUG_PRINT("app_set_keep_alive: timeout=%ds, max_requests=%d\n", timeout_seconds, max_requests);
+    app->keep_alive_timeout = timeout_seconds;
+    app->max_keep_alive_requests = max_requests;
+}
 
-    // create socket
-    server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd == 0) {
-        perror("socket failed");
-        exit(EXIT_FAILURE);
-    }
+void app_set_io_backend(App *app, AppIOBackend backend) {
+    DEBUG_PRINT("app_set_io_backend: backend=%s\n", backend == APP_IO_URING ? "io_uring" : "epoll");
+    app->io_backend = backend;
+}
 
-    // bind
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port);
-    bind(server_fd, (struct sockaddr *)&address, sizeof(address));
+void app_set_route_cache(App *app, int entries) {
+    DEBUG_PRINT("app_set_route_cache: entries=%d\n", entries);
+    // A published table keeps its size; the next publish takes the new one
+    if (!app_published(app)) app_thaw(app);
+    app->route_cache_entries = entries > 0 ? entries : 0;
+}
 
-    // listen
-    listen(server_fd, 3);
-    DEBUG_PRINT("Listening on port %d\n", port);
+int app_load_route_snapshot(App *app, const char *path) {
+    RouteSnapshot *snapshot = route_snapshot_open(path);
+    if (!snapshot) return -1;
+    router_set_snapshot(&app->router, snapshot);
+    return 0;
+}
+
+int app_save_route_snapshot(App *app, const char *path) {
+    return route_snapshot_save(&app->router, path);
+}
+
+void app_route_cache_stats(App *app, RouteCacheStats *stats) {
+    epoch_enter();
+    FrozenRouter *frozen = __atomic_load_n(&app->frozen, __ATOMIC_SEQ_CST);
+    if (frozen) {
+        route_cache_stats(frozen->generation, stats);
+    } else {
+        stats->hits = 0;
+        stats->misses = 0;
+    }
+    epoch_exit();
+}
+
+// Blocking fallback: one client at a time, closed after each request
+static void app_listen_blocking(App *app, int server_fd) {
+    int client_fd;
 
     while (1) {
-        client_fd = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen);
+        client_fd = accept(server_fd, NULL, NULL);
         if (client_fd < 0) {
             perror("accept");
             continue;
         }
         DEBUG_PRINT("app_listen: accepted client_fd=%d\n", client_fd);
 
-        char headers_buffer[8192] = {0}; // Buffer for HTTP headers only
-        ssize_t headers_read = 0;
-        ssize_t bytes_read;
-        int headers_complete = 0;
-        
-        // First, read only the headers (up to \r\n\r\n)
-        while (headers_read < (ssize_t)(sizeof(headers_buffer) - 1) && !headers_complete) {
-            bytes_read = read(client_fd, headers_buffer + headers_read, 1);
-            if (bytes_read <= 0) break;
-            
-            headers_read += bytes_read;
-            headers_buffer[headers_read] = '\0';
-            
-            // Check if we have complete headers
-            if (strstr(headers_buffer, "\r\n\r\n")) {
-                headers_complete = 1;
-                break;
-            }
-        }
-        
-        if (!headers_complete) {
-            DEBUG_PRINT_STR("app_listen: incomplete headers received\n");
+        Connection *conn = connection_create(client_fd);
+        if (!conn) {
             close(client_fd);
             continue;
         }
-        
-        DEBUG_PRINT("app_listen: received headers (%zd bytes): %.500s\n", headers_read, headers_buffer);
-        
-        // Parse headers to determine if we need streaming
-        const char *content_length_header = strstr(headers_buffer, "Content-Length: ");
-        const char *transfer_encoding_header = strstr(headers_buffer, "Transfer-Encoding: ");
-        
-        int use_streaming = 0;
-        int content_length = 0;
-        
-        // Determine if we should use streaming
-        if (transfer_encoding_header && strstr(transfer_encoding_header, "chunked")) {
-            use_streaming = 1;
-            DEBUG_PRINT_STR("app_listen: chunked encoding detected, using streaming\n");
-        } else if (content_length_header) {
-            content_length = atoi(content_length_header + 16);
-            DEBUG_PRINT("app_listen: Content-Length: %d\n", content_length);
-            
-            if (content_length > MAX_BODY_SIZE) {
-                use_streaming = 1;
-                DEBUG_PRINT("app_listen: large body detected (%d bytes), using streaming\n", content_length);
-            }
+
+        // Read in bulk until the request is framed; the buffer stops at the
+        // end of the declared body so nothing past it is consumed
+        ConnectionIO io = CONN_IO_OK;
+        while (io == CONN_IO_OK && !connection_request_ready(conn)) {
+            io = connection_fill(conn);
         }
-        
-        // Create and initialize request object
-        Request *req = malloc(sizeof(Request));
-        
-        if (use_streaming) {
-            // Use streaming initialization
-            DEBUG_PRINT_STR("app_listen: initializing request with streaming\n");
-            request_init_streaming(req, client_fd, headers_buffer);
-            
-            // Stream context is set up and ready for on-demand reading
-            if (req->stream && !stream_has_error(req->stream)) {
-                DEBUG_PRINT_STR("app_listen: streaming context ready for on-demand reading\n");
-                // Don't read data automatically - let the application decide when to stream
-                req->body_complete = 0; // Mark as not complete since we haven't read it yet
-            } else if (req->stream) {
-                DEBUG_PRINT("app_listen: streaming setup failed: %s\n", stream_get_error(req->stream));
-            }
+
+        if (connection_request_ready(conn)) {
+            DEBUG_PRINT("app_listen: framed request (%zu header bytes, %zu body bytes)\n",
+                   conn->header_len, conn->body_len);
+
+            // Holding the socket open would stall every other client
+            conn->keep_alive = 0;
+            event_loop_dispatch(app, conn);
+            connection_flush(conn);
         } else {
-            // Use legacy initialization for small bodies
-            DEBUG_PRINT_STR("app_listen: using legacy body handling\n");
-            
-            char complete_request[16384] = {0};
-            size_t total_size = headers_read;
-            
-            // Copy headers to complete request buffer
-            memcpy(complete_request, headers_buffer, headers_read);
-            
-            // Read body if there's a content length
-            if (content_length > 0 && content_length < (int)(sizeof(complete_request) - headers_read - 1)) {
-                ssize_t body_read = read(client_fd, complete_request + headers_read, content_length);
-                if (body_read > 0) {
-                    total_size += body_read;
-                    complete_request[total_size] = '\0';
-                    DEBUG_PRINT("app_listen: read body (%zd bytes) for legacy processing\n", body_read);
-                }
-            }
-            
-            DEBUG_PRINT("app_listen: complete request (%zu bytes): %.500s\n", total_size, complete_request);
-            request_init(req, client_fd, complete_request);
+            DEBUG_PRINT_STR("app_listen: incomplete headers received\n");
         }
 
-        // Handle the request
-        app_handle_request(app, req->method, req->path, client_fd, req);
-        
-        // Comprehensive cleanup - free all allocated memory in request
-        request_destroy(req);
-        free(req);
+        connection_destroy(conn);
         close(client_fd);
     }
 }
 
-void app_handle_request(App *app, const char *method, const char *path, int client_fd, Request *req) {
-    Router *router = &app->router;
-    int *matches = malloc(router->layer_count * sizeof(int));
-    int match_count = 0;
-    int route_match_count = 0;
-    
-    for (int i = 0; i < router->layer_count; i++) {
-        if (layer_match(&router->layers[i], method, path)) {
-            matches[match_count++] = i;
-            if (strcmp(router->layers[i].method, "USE") != 0) {
-                route_match_count++;
-            }
+// Create a bound, listening TCP socket. With reuse_port set, several sockets
+// can bind the same port and the kernel load-balances accepts across them.
+static int app_create_listener(int port, int reuse_port) {
+    int server_fd;
+    struct sockaddr_in address;
+    int enable = 1;
+
+    // create socket
+    server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        perror("socket failed");
+        return -1;
+    }
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (reuse_port && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0) {
+        perror("setsockopt SO_REUSEPORT");
+        close(server_fd);
+        return -1;
+    }
+
+    // bind
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("bind failed");
+        close(server_fd);
+        return -1;
+    }
+
+    // listen
+    if (listen(server_fd, SOMAXCONN) < 0) {
+        perror("listen failed");
+        close(server_fd);
+        return -1;
+    }
+
+    return server_fd;
+}
+
+// Serve an already listening socket until the loop exits
+static void app_serve(App *app, int server_fd) {
+#if C_EXPRESS_HAVE_IO_URING
+    if (app->io_backend == APP_IO_URING) {
+        if (uring_loop_run(app, server_fd) == 0) {
+            close(server_fd);
+            return;
         }
+        DEBUG_PRINT_STR("app_listen: io_uring unavailable, falling back to epoll\n");
     }
-    
-    NextContext ctx = { router, app, matches, match_count, client_fd, 0, req, &route_match_count, NULL };
-    
-    if (match_count > 0) {
-        next_handler(&ctx);
-        
-        if (route_match_count == 0) {
-            Response *res = create_response(client_fd);
-            response_set_header(res, "Content-Type", "application/json");
-            response_status(res, 404);
-            response_send(res, "{\"error\":\"Not Found\",\"message\":\"The requested endpoint was not found\"}");
-            destroy_response(res);
+#endif
+
+#if C_EXPRESS_HAVE_EPOLL
+    if (event_loop_run(app, server_fd) == 0) {
+        close(server_fd);
+        return;
+    }
+    DEBUG_PRINT_STR("app_listen: epoll unavailable, falling back to blocking loop\n");
+#endif
+
+    app_listen_blocking(app, server_fd);
+}
+
+void app_listen(App *app, int port) {
+    if (!app->frozen) app_freeze(app);
+    int server_fd = app_create_listener(port, 0);
+    if (server_fd < 0) {
+        exit(EXIT_FAILURE);
+    }
+    DEBUG_PRINT("Listening on port %d\n", port);
+
+    app_serve(app, server_fd);
+}
+
+// One worker thread: its own SO_REUSEPORT listener and event loop
+typedef struct {
+    App *app;
+    int server_fd;
+    int index;
+    pthread_t thread;
+} ListenWorker;
+
+static void *app_worker_main(void *arg) {
+    ListenWorker *worker = (ListenWorker *)arg;
+    DEBUG_PRINT("app_listen_workers: worker %d serving fd=%d\n", worker->index, worker->server_fd);
+    app_serve(worker->app, worker->server_fd);
+    return NULL;
+}
+
+void app_listen_workers(App *app, int port, int n_threads) {
+    // Frozen before any worker starts reading it (unless a router was
+    // published already)
+    if (!app->frozen) app_freeze(app);
+    if (n_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (n_threads == 1) {
+        app_listen(app, port);
+        return;
+    }
+
+    ListenWorker *workers = calloc(n_threads, sizeof(ListenWorker));
+    if (!workers) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    // Bind every listener up front so port errors surface before any thread starts
+    for (int i = 0; i < n_threads; i++) {
+        workers[i].app = app;
+        workers[i].index = i;
+        workers[i].server_fd = app_create_listener(port, 1);
+        if (workers[i].server_fd < 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+    DEBUG_PRINT("Listening on port %d with %d workers\n", port, n_threads);
+
+    for (int i = 0; i < n_threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, app_worker_main, &workers[i]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
         }
-    } else {
-        Response *res = create_response(client_fd);
-        response_set_header(res, "Content-Type", "application/json");
-        response_status(res, 404);
-        response_send(res, "{\"error\":\"Not Found\",\"message\":\"The requested endpoint was not found\"}");
-        destroy_response(res);
+    }
+
+    for (int i = 0; i < n_threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    free(workers);
+}
+
+// Worker threads share one App without locking: once listening starts the
+// router is only read, and all per-request state (matches, parameter
+// slices, response, error context) lives in the request or on this stack.
+int app_handle_request(App *app, const char *method, const char *path, int client_fd, Request *req) {
+    // The table is read once per request and kept alive, for as long as
+    // this call runs, by the epoch section
+    epoch_enter();
+    FrozenRouter *frozen = req ? __atomic_load_n(&app->frozen, __ATOMIC_SEQ_CST) : NULL;
+    if (frozen) {
+        int completed = frozen_router_handle(frozen, app, method, path, client_fd, req);
+        epoch_exit();
+        return completed;
     }
     
-    free(matches);
+    Router *router = &app->router;
+    NextContext local;
+    NextContext *ctx = next_context_create(router, app, client_fd, req, &local);
+    Arena *arena = ctx->arena;
+    ctx->matches = arena ? arena_alloc(arena, router->layer_count * sizeof(LayerMatch))
+                         : malloc(router->layer_count * sizeof(LayerMatch));
+    if (req) req->route_slice_count = 0;
+    ctx->match_count = ctx->matches ? router_match(router, method, path, ctx->matches, &ctx->route_match_count, req)
+                                    : 0;
+    
+    // Once the chain completes the arena the path lives in is reset, so
+    // the methods for a 405 are collected before it runs
+    ctx->allowed = ctx->route_match_count == 0 ? router_allowed_methods(router, path, arena) : 0;
+    ctx->advance = router_advance;
+    int completed = next_run(ctx);
+    
+    next_context_release(ctx);
+    epoch_exit();
+    return completed;
 }
 
 App create_app() {
@@ -320,7 +544,15 @@ App create_app() {
     app.router.layers = NULL;
     app.router.layer_count = 0;
     app.router.capacity = 0;
+    app.router.tree = NULL;
+    app.router.snapshot = NULL;
     app.error_handler = NULL;  // Initialize error handler
+    app.keep_alive_timeout = DEFAULT_KEEP_ALIVE_TIMEOUT;
+    app.max_keep_alive_requests = DEFAULT_MAX_KEEP_ALIVE_REQUESTS;
+    app.io_backend = DEFAULT_IO_BACKEND;
+    app.frozen = NULL;
+    app.retired = NULL;
+    app.route_cache_entries = 0;
     app.get = app_get;
     app.post = app_post;
     app.put = app_put;
@@ -328,8 +560,10 @@ App create_app() {
     app.patch = app_patch;
     app.options = app_options;
     app.listen = app_listen;
+    app.listen_workers = app_listen_workers;
     app.use = app_use;
     app.mount = app_mount;
+    app.vhost = app_vhost;
     app.error = app_error;
 
     // automatically register express_init middleware
@@ -2,6 +2,7 @@
 #define APP_H
 
 #include "router.h"
+#include "route_cache.h"
 #include "../http/request.h"
 #include "../http/response.h"
 #include "../http/error.h"
@@ -9,6 +10,24 @@
 
 // Forward declaration for self-referencing pointers
 struct App;
+struct FrozenRouter;
+
+// Persistent connection defaults
+#define DEFAULT_KEEP_ALIVE_TIMEOUT 5          // Idle seconds before closing
+#define DEFAULT_MAX_KEEP_ALIVE_REQUESTS 1000  // Requests per connection
+
+// Server I/O backend used by app_listen and app_listen_workers
+typedef enum {
+    APP_IO_EPOLL,      // Readiness-based epoll loop (blocking loop where epoll is missing)
+    APP_IO_URING       // Completion-based io_uring loop, falls back to APP_IO_EPOLL
+} AppIOBackend;
+
+// Build with -DC_EXPRESS_USE_IO_URING to make io_uring the default backend
+#ifdef C_EXPRESS_USE_IO_URING
+#define DEFAULT_IO_BACKEND APP_IO_URING
+#else
+#define DEFAULT_IO_BACKEND APP_IO_EPOLL
+#endif
 
 // Error handler function type
 typedef void (*ErrorHandler)(Error *error, int client_fd, void *context);
@@ -16,6 +35,12 @@ typedef void (*ErrorHandler)(Error *error, int client_fd, void *context);
 struct App {
     struct Router router;
     ErrorHandler error_handler;  // Global error handler
+    int keep_alive_timeout;      // Idle seconds before a persistent connection closes (0 disables keep-alive)
+    int max_keep_alive_requests; // Requests served per connection before closing (0 = unlimited)
+    AppIOBackend io_backend;     // Server loop selected at listen time
+    struct FrozenRouter *frozen; // Compiled dispatch built by app_freeze (NULL until then)
+    struct FrozenRouter *retired; // Replaced tables waiting for their requests to drain
+    int route_cache_entries;     // Per-thread route lookup cache size once frozen (0 = off)
     void (*get)(struct App *, const char *path, Handler handler);
     void (*post)(struct App *, const char *path, Handler handler);
     void (*put)(struct App *, const char *path, Handler handler);
@@ -23,8 +48,10 @@ struct App {
     void (*patch)(struct App *, const char *path, Handler handler);
     void (*options)(struct App *, const char *path, Handler handler);
     void (*listen)(struct App *, int port);
+    void (*listen_workers)(struct App *, int port, int n_threads);  // Multi-core SO_REUSEPORT mode
     void (*use)(struct App*, Handler handler);
     void (*mount)(struct App*, const char *prefix, struct Router *router);  // Mount sub-router
+    void (*vhost)(struct App*, const char *host, struct Router *router);    // Router for one Host
     void (*error)(struct App*, ErrorHandler handler);  // Set error handler
 };
 
@@ -39,9 +66,64 @@ void app_patch(struct App *app, const char *path, Handler handler);
 void app_options(struct App *app, const char *path, Handler handler);
 void app_use(struct App *app, Handler handler);
 void app_mount(struct App *app, const char *prefix, Router *router);
+// Serve requests whose Host is `host` ("api.example.com", or
+// "*.example.com" for every subdomain) from `router` too, in registration
+// order with the app's own routes; other hosts never see its routes. Once
+// frozen, each request only walks the routes its Host can reach.
+void app_vhost(struct App *app, const char *host, Router *router);
 void app_error(struct App *app, ErrorHandler handler);
+void app_set_keep_alive(struct App *app, int timeout_seconds, int max_requests);
+void app_set_io_backend(struct App *app, AppIOBackend backend);
+// Cache frozen route lookups: each worker thread keeps the outcome (route,
+// parameters, 405 methods) of its `entries` most recently seen method and
+// path pairs, so a repeated path skips matching and constraint checks.
+// Off (0) by default; takes effect at the next app_freeze (or publish, once
+// a draft is published), and any freeze starts every cache afresh. Assumes constraints and validators give the
+// same answer for the same path.
+void app_set_route_cache(struct App *app, int entries);
+// Cache hits and misses across every thread since the app was last frozen
+void app_route_cache_stats(struct App *app, RouteCacheStats *stats);
+// Start from compiled patterns: routes registered afterwards take their
+// pattern from the snapshot file at `path` when it has one (see
+// route_snapshot.h), as do drafts. Returns 0, or -1 when there is no usable
+// snapshot there and routes are compiled as usual; app_save_route_snapshot
+// then writes one once they are all registered. The snapshot stays mapped
+// for the life of the process.
+int app_load_route_snapshot(struct App *app, const char *path);
+// Returns the number of patterns written, or -1
+int app_save_route_snapshot(struct App *app, const char *path);
+// Compile the routes for dispatch: mounted routers are flattened in and
+// every route gets its full middleware/handler chain. app_listen and
+// app_listen_workers call it; registering through the app drops it again
+// (app_thaw), but routes added to a mounted router afterwards need
+// another app_freeze. The dropped table is retired like a replaced one
+// (see app_publish_router).
+void app_freeze(struct App *app);
+void app_thaw(struct App *app);
+// Replacing the routes of a running app. Build the new routes on a draft
+// (a router with express_init already in place), then publish it: it is
+// frozen off to the side and swapped in atomically, so requests already
+// dispatched finish on the old table while new ones use the new one.
+// The app owns the draft once published (routers mounted in it stay the
+// caller's and must outlive it) and it must not be modified afterwards.
+// Registering on the app itself (app_get, app_use, app_mount, app_freeze...)
+// is refused from then on, as its routes no longer serve; an explicit
+// app_thaw drops the published routes and goes back to them.
+// Returns 0, or -1 when the draft could not be frozen (it stays the
+// caller's and the old routes keep serving).
+Router *app_draft_router(struct App *app);
+int app_publish_router(struct App *app, Router *router);
+// Free the replaced tables no request is using any more (publishing does
+// this too); returns how many are still in use
+int app_reclaim_routers(struct App *app);
 void app_listen(struct App *app, int port);
-void app_handle_request(struct App *app, const char *method, const char *path, int client_fd, Request *req);
+void app_listen_workers(struct App *app, int port, int n_threads);  // n_threads <= 0 uses one per CPU
+// Safe to call from any number of threads at once for the same App, as long
+// as no routes are added meanwhile (app_publish_router may run at any
+// time). Returns 1 once the request is done, 0 when a handler paused its
+// chain (see next_pause): req must then be kept until the chain is resumed
+// or completed through req->paused_chain.
+int app_handle_request(struct App *app, const char *method, const char *path, int client_fd, Request *req);
 
 App create_app();
 
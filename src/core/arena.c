@@ -0,0 +1,150 @@
+#define _GNU_SOURCE
+#include "arena.h"
+#include "../debug.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define ARENA_ALIGN 8
+
+// Spare blocks per thread; worker threads never share arenas
+static __thread ArenaBlock *arena_block_cache = NULL;
+static __thread int arena_block_cache_count = 0;
+static __thread size_t arena_thread_heap_count = 0;
+
+// Frees a thread's spare blocks when it exits
+static pthread_key_t arena_cache_key;
+static pthread_once_t arena_cache_once = PTHREAD_ONCE_INIT;
+
+static void arena_cache_release(void *unused) {
+    (void)unused;
+    while (arena_block_cache) {
+        ArenaBlock *next = arena_block_cache->next;
+        free(arena_block_cache);
+        arena_block_cache = next;
+    }
+    arena_block_cache_count = 0;
+}
+
+static void arena_cache_key_create(void) {
+    pthread_key_create(&arena_cache_key, arena_cache_release);
+}
+
+static size_t arena_align_pad(const char *ptr) {
+    return (size_t)(-(uintptr_t)ptr & (ARENA_ALIGN - 1));
+}
+
+// Take `size` bytes from a buffer with `*used` bytes taken, or NULL if full
+static void *arena_take(char *base, size_t *used, size_t capacity, size_t size) {
+    char *next = base + *used;
+    size_t pad = arena_align_pad(next);
+    if (size > capacity - *used || pad > capacity - *used - size) return NULL;
+    *used += pad + size;
+    return next + pad;
+}
+
+static ArenaBlock *arena_new_block(Arena *arena, size_t size) {
+    ArenaBlock *block;
+
+    if (size <= ARENA_BLOCK_SIZE && arena_block_cache) {
+        block = arena_block_cache;
+        arena_block_cache = block->next;
+        arena_block_cache_count--;
+    } else {
+        size_t block_size = (size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE) + ARENA_ALIGN;
+        block = malloc(sizeof(ArenaBlock) + block_size);
+        if (!block) return NULL;
+        block->size = block_size;
+        arena->heap_allocations++;
+        arena_thread_heap_count++;
+        DEBUG_PRINT("arena_new_block: allocated %zu byte block\n", block_size);
+    }
+
+    block->used = 0;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    return block;
+}
+
+void arena_init(Arena *arena, void *initial, size_t initial_size) {
+    arena->initial = initial;
+    arena->initial_size = initial ? initial_size : 0;
+    arena->initial_used = 0;
+    arena->blocks = NULL;
+    arena->allocations = 0;
+    arena->heap_allocations = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    void *ptr = NULL;
+
+    if (arena->initial) {
+        ptr = arena_take(arena->initial, &arena->initial_used, arena->initial_size, size);
+    }
+    if (!ptr && arena->blocks) {
+        ArenaBlock *block = arena->blocks;
+        ptr = arena_take(block->data, &block->used, block->size, size);
+    }
+    if (!ptr) {
+        ArenaBlock *block = arena_new_block(arena, size);
+        if (!block) return NULL;
+        ptr = arena_take(block->data, &block->used, block->size, size);
+    }
+
+    arena->allocations++;
+    return ptr;
+}
+
+void *arena_calloc(Arena *arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void *ptr = arena_alloc(arena, count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t len) {
+    char *copy = arena_alloc(arena, len + 1);
+    if (copy) {
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+char *arena_strdup(Arena *arena, const char *str) {
+    return arena_strndup(arena, str, strlen(str));
+}
+
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    if (ptr && new_size <= old_size) return ptr;
+    void *grown = arena_alloc(arena, new_size);
+    if (grown && ptr) memcpy(grown, ptr, old_size);
+    return grown;
+}
+
+void arena_reset(Arena *arena) {
+    ArenaBlock *block = arena->blocks;
+    while (block) {
+        ArenaBlock *next = block->next;
+        if (block->size == ARENA_BLOCK_SIZE + ARENA_ALIGN && arena_block_cache_count < ARENA_BLOCK_CACHE) {
+            if (!arena_block_cache) {
+                // Any non-NULL value makes the key's destructor run at thread exit
+                pthread_once(&arena_cache_once, arena_cache_key_create);
+                pthread_setspecific(arena_cache_key, &arena_block_cache);
+            }
+            block->next = arena_block_cache;
+            arena_block_cache = block;
+            arena_block_cache_count++;
+        } else {
+            free(block);
+        }
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->initial_used = 0;
+}
+
+size_t arena_thread_heap_allocations(void) {
+    return arena_thread_heap_count;
+}
@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE 16384   // Default block size; larger allocations get a block of their own
+#define ARENA_BLOCK_CACHE 8      // Spare default-size blocks each thread keeps for reuse
+
+// One malloc'd block of arena memory
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+// Bump allocator for memory that lives exactly as long as one request.
+// Allocations are never freed individually: arena_reset releases all of
+// them at once. Blocks released by a reset go to a per-thread cache, so a
+// warmed-up thread serves requests without touching the heap.
+typedef struct Arena {
+    char *initial;               // Optional caller-owned first buffer
+    size_t initial_size;
+    size_t initial_used;
+    ArenaBlock *blocks;          // Newest first
+    size_t allocations;          // Allocations served since init
+    size_t heap_allocations;     // Blocks this arena had to malloc (cache misses)
+} Arena;
+
+// `initial` may be NULL; a zeroed Arena is also valid and empty
+void arena_init(Arena *arena, void *initial, size_t initial_size);
+
+// Memory aligned for any scalar or pointer; NULL only if malloc fails
+void *arena_alloc(Arena *arena, size_t size);
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+char *arena_strdup(Arena *arena, const char *str);
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+
+// Grow an allocation; the old bytes are copied and the old space abandoned
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+
+// Release every allocation. The arena stays usable.
+void arena_reset(Arena *arena);
+
+// Arena blocks the calling thread has taken from malloc so far
+size_t arena_thread_heap_allocations(void);
+
+#endif
@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+#include "epoch.h"
+#include "../debug.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+// One per thread that has entered a section. `epoch` is the global epoch
+// the current outermost section began in, 0 outside one.
+typedef struct EpochRecord {
+    unsigned long epoch;
+    int depth;
+    struct EpochRecord *prev, *next;
+} EpochRecord;
+
+static unsigned long global_epoch = 1;
+// Set when a thread could not get a record: nothing is reclaimed after that
+static int records_lost = 0;
+static __thread EpochRecord *thread_record = NULL;
+
+// Every live record; a record leaves when its thread exits
+static EpochRecord *records = NULL;
+static pthread_mutex_t records_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t record_key;
+static pthread_once_t record_once = PTHREAD_ONCE_INIT;
+
+static void record_release(void *value) {
+    EpochRecord *record = (EpochRecord *)value;
+    pthread_mutex_lock(&records_lock);
+    if (record->prev) record->prev->next = record->next;
+    else records = record->next;
+    if (record->next) record->next->prev = record->prev;
+    pthread_mutex_unlock(&records_lock);
+    free(record);
+    thread_record = NULL;
+}
+
+static void record_key_create(void) {
+    pthread_key_create(&record_key, record_release);
+}
+
+static EpochRecord *record_get(void) {
+    EpochRecord *record = thread_record;
+    if (record) return record;
+
+    record = calloc(1, sizeof(EpochRecord));
+    if (!record) {
+        // The thread cannot announce itself, so no table is safe to free
+        ERROR_PRINT_STR("epoch_enter: out of memory, retired tables will leak\n");
+        __atomic_store_n(&records_lost, 1, __ATOMIC_SEQ_CST);
+        return NULL;
+    }
+    pthread_once(&record_once, record_key_create);
+    pthread_mutex_lock(&records_lock);
+    record->next = records;
+    if (records) records->prev = record;
+    records = record;
+    pthread_mutex_unlock(&records_lock);
+    pthread_setspecific(record_key, record);
+    thread_record = record;
+    return record;
+}
+
+void epoch_enter(void) {
+    EpochRecord *record = record_get();
+    if (!record || record->depth++ > 0) return;
+    // Sequentially consistent: a writer that advances the epoch after this
+    // store sees it, and the pointer the section loads next is at least
+    // as new as the epoch announced
+    __atomic_store_n(&record->epoch, __atomic_load_n(&global_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+}
+
+void epoch_exit(void) {
+    EpochRecord *record = thread_record;
+    if (!record || record->depth == 0) return;
+    if (--record->depth == 0) __atomic_store_n(&record->epoch, 0, __ATOMIC_RELEASE);
+}
+
+unsigned long epoch_advance(void) {
+    return __atomic_add_fetch(&global_epoch, 1, __ATOMIC_SEQ_CST);
+}
+
+int epoch_safe(unsigned long retired) {
+    int safe = !__atomic_load_n(&records_lost, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&records_lock);
+    for (EpochRecord *record = records; record && safe; record = record->next) {
+        unsigned long epoch = __atomic_load_n(&record->epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < retired) safe = 0;
+    }
+    pthread_mutex_unlock(&records_lock);
+    return safe;
+}
@@ -0,0 +1,21 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+// Epoch-based reclamation for tables that are swapped while other threads
+// read them. A reader brackets its use of a published pointer with
+// epoch_enter()/epoch_exit(); a writer publishes the replacement, then
+// calls epoch_advance() and keeps the old table until epoch_safe() says
+// that every section that could have seen it has ended.
+
+// Start / end a read-side section on the calling thread (sections nest)
+void epoch_enter(void);
+void epoch_exit(void);
+
+// Called after publishing a replacement: the epoch to retire the old
+// table under
+unsigned long epoch_advance(void);
+
+// 1 when no thread is still in a section begun before `retired`
+int epoch_safe(unsigned long retired);
+
+#endif
@@ -0,0 +1,288 @@
+#define _GNU_SOURCE
+#include "event_loop.h"
+#include "app.h"
+#include "../debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#if C_EXPRESS_HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+// Build a Request from the framed bytes in conn->in_buf and run it through the app.
+// Anything the handlers send is queued on the connection for the loop to flush,
+// apart from the part of a large response written while it was sent.
+void event_loop_dispatch(App *app, Connection *conn) {
+    conn->state = CONN_DISPATCHING;
+    conn->requests_served++;
+
+    // Streamed bodies may be left half-read on the socket, so those connections
+    // are never reused; otherwise apply the app's keep-alive limits
+    if (conn->use_streaming || app->keep_alive_timeout <= 0 ||
+        (app->max_keep_alive_requests > 0 && conn->requests_served >= app->max_keep_alive_requests)) {
+        conn->keep_alive = 0;
+    }
+
+    // Small enough to live on the stack; large parts spill to request storage
+    Request request;
+    Request *req = &request;
+
+    // Earlier pipelined responses may still be queued ahead of this one
+    size_t handed = conn->out_total;
+
+    // The head was parsed while framing; the request views point into in_buf
+    if (conn->use_streaming) {
+        DEBUG_PRINT_STR("event_loop_dispatch: initializing request with streaming\n");
+        request_init_parsed(req, conn->fd, conn->in_buf, &conn->parser, NULL, 0);
+        request_start_stream(req);
+
+        // Body bytes that arrived with the head seed the stream's reader
+        if (req->stream && !stream_has_error(req->stream)) {
+            stream_prefill(req->stream, conn->in_buf + conn->header_len,
+                           conn->in_len - conn->header_len);
+            req->body_complete = 0;
+        } else if (req->stream) {
+            DEBUG_PRINT("event_loop_dispatch: streaming setup failed: %s\n", stream_get_error(req->stream));
+        }
+    } else {
+        request_init_parsed(req, conn->fd, conn->in_buf, &conn->parser,
+                            conn->in_buf + conn->header_len, conn->body_len);
+    }
+
+    connection_set_active(conn);
+    if (!app_handle_request(app, req->method, req->path, conn->fd, req)) {
+        // The request lives on this stack and its connection moves on to
+        // the next one, so a chain cannot stay paused here
+        ERROR_PRINT("event_loop_dispatch: chain paused on fd=%d; completing it\n", conn->fd);
+        next_complete(req->paused_chain);
+    }
+    connection_set_active(NULL);
+
+    request_destroy(req);
+
+    // Without a framed response the client cannot find the end of it
+    if (conn->out_total == handed) {
+        conn->keep_alive = 0;
+    }
+
+    conn->state = CONN_WRITING;
+}
+
+long event_loop_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)now.tv_sec;
+}
+
+#if C_EXPRESS_HAVE_EPOLL
+
+// Reactor state for one thread
+typedef struct {
+    App *app;
+    int epoll_fd;
+    int server_fd;
+    ConnectionList idle;    // Open connections, least recently active first
+} EventLoop;
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Stamp activity and move the connection to the most-recent end of the list
+static void idle_list_touch(EventLoop *loop, Connection *conn) {
+    connection_list_touch(&loop->idle, conn, event_loop_now());
+}
+
+static void event_loop_close(EventLoop *loop, Connection *conn) {
+    DEBUG_PRINT("event_loop_close: fd=%d after %d requests\n", conn->fd, conn->requests_served);
+    connection_list_remove(&loop->idle, conn);
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    connection_destroy(conn);
+}
+
+// Close connections idle for longer than the keep-alive timeout
+static void event_loop_expire_idle(EventLoop *loop) {
+    long timeout = loop->app->keep_alive_timeout > 0 ? loop->app->keep_alive_timeout : DEFAULT_KEEP_ALIVE_TIMEOUT;
+    long now = event_loop_now();
+
+    while (loop->idle.head && now - loop->idle.head->last_active >= timeout) {
+        Connection *conn = loop->idle.head;
+        if (connection_has_pending_output(conn)) {
+            // Still draining responses to a slow reader; give it another period
+            idle_list_touch(loop, conn);
+            continue;
+        }
+        DEBUG_PRINT("event_loop_expire_idle: closing idle fd=%d\n", conn->fd);
+        event_loop_close(loop, conn);
+    }
+}
+
+// Accept every pending client (edge-triggered: drain until EAGAIN)
+static void event_loop_accept(EventLoop *loop) {
+    for (;;) {
+        int client_fd = accept4(loop->server_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept");
+            }
+            return;
+        }
+
+        Connection *conn = connection_create(client_fd);
+        if (!conn) {
+            close(client_fd);
+            continue;
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn;
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            perror("epoll_ctl");
+            close(client_fd);
+            connection_destroy(conn);
+            continue;
+        }
+        idle_list_touch(loop, conn);
+        DEBUG_PRINT("event_loop_accept: accepted client_fd=%d\n", client_fd);
+    }
+}
+
+// Still reading (or about to dispatch) requests, as opposed to winding down
+static int event_loop_reading(Connection *conn) {
+    return conn->state != CONN_WRITING && conn->state != CONN_CLOSING;
+}
+
+// Advance one connection's state machine as far as the socket allows.
+// Every complete request already buffered is dispatched before writing, so
+// pipelined requests get their responses queued in order and sent together.
+static void event_loop_service(EventLoop *loop, Connection *conn, uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        event_loop_close(loop, conn);
+        return;
+    }
+    idle_list_touch(loop, conn);
+
+    for (;;) {
+        ConnectionIO io = CONN_IO_OK;
+        if (event_loop_reading(conn) && !connection_request_ready(conn) &&
+            !connection_output_full(conn)) {
+            io = connection_fill(conn);
+            if (io == CONN_IO_ERROR) {
+                event_loop_close(loop, conn);
+                return;
+            }
+        }
+
+        while (event_loop_reading(conn) && connection_request_ready(conn) &&
+               !connection_output_full(conn)) {
+            event_loop_dispatch(loop->app, conn);
+            if (conn->state == CONN_WRITING && conn->keep_alive) {
+                // Frame whatever the client already sent after this request
+                connection_reset(conn);
+            }
+        }
+
+        if (connection_has_pending_output(conn)) {
+            ConnectionIO out = connection_flush(conn);
+            if (out == CONN_IO_AGAIN) {
+                return;  // EPOLLOUT will resume the flush
+            }
+            if (out == CONN_IO_ERROR) {
+                event_loop_close(loop, conn);
+                return;
+            }
+        }
+
+        if (!event_loop_reading(conn)) {
+            event_loop_close(loop, conn);
+            return;
+        }
+
+        // Wait for more bytes, unless a buffered request was held back by the output cap
+        if (!connection_request_ready(conn)) {
+            if (io == CONN_IO_CLOSED) {
+                event_loop_close(loop, conn);
+                return;
+            }
+            if (io == CONN_IO_AGAIN) {
+                return;
+            }
+        }
+    }
+}
+
+int event_loop_run(App *app, int server_fd) {
+    EventLoop loop;
+    memset(&loop, 0, sizeof(loop));
+    loop.app = app;
+    loop.server_fd = server_fd;
+
+    loop.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop.epoll_fd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+
+    if (set_nonblocking(server_fd) < 0) {
+        perror("fcntl");
+        close(loop.epoll_fd);
+        return -1;
+    }
+
+    // The listening socket is the only entry without a Connection attached
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, server_fd, &ev) < 0) {
+        perror("epoll_ctl");
+        close(loop.epoll_fd);
+        return -1;
+    }
+
+    DEBUG_PRINT("event_loop_run: epoll reactor started on fd=%d\n", server_fd);
+
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    for (;;) {
+        // Wake at least once a second to expire idle keep-alive connections
+        int ready = epoll_wait(loop.epoll_fd, events, EVENT_LOOP_MAX_EVENTS, 1000);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            Connection *conn = (Connection *)events[i].data.ptr;
+            if (!conn) {
+                event_loop_accept(&loop);
+            } else {
+                event_loop_service(&loop, conn, events[i].events);
+            }
+        }
+
+        event_loop_expire_idle(&loop);
+    }
+
+    close(loop.epoll_fd);
+    return 0;
+}
+
+#else
+
+int event_loop_run(App *app, int server_fd) {
+    (void)app;
+    (void)server_fd;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "../http/connection.h"
+
+// Forward declaration for App
+struct App;
+
+#define EVENT_LOOP_MAX_EVENTS 256
+
+// epoll is the default server backend on Linux; define C_EXPRESS_NO_EPOLL
+// to fall back to the blocking accept loop.
+#if defined(__linux__) && !defined(C_EXPRESS_NO_EPOLL)
+#define C_EXPRESS_HAVE_EPOLL 1
+#else
+#define C_EXPRESS_HAVE_EPOLL 0
+#endif
+
+// Run an edge-triggered epoll reactor on an already listening socket.
+// Returns -1 if epoll is unavailable so the caller can fall back.
+int event_loop_run(struct App *app, int server_fd);
+
+// Build a Request from a fully framed connection buffer and dispatch it
+void event_loop_dispatch(struct App *app, Connection *conn);
+
+// Monotonic clock in seconds, for keep-alive idle tracking
+long event_loop_now(void);
+
+#endif
@@ -0,0 +1,552 @@
+#define _GNU_SOURCE
+#include "frozen_router.h"
+#include "route_cache.h"
+#include "vhost.h"
+#include "../debug.h"
+#include "../http/response.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// Freeze-time marks on a layer while one route's chain is built
+#define MARK_PATH0 1     // Matches the route's (first) literal path
+#define MARK_PATH1 2     // Matches its second literal path
+#define MARK_MAYBE 4     // Might match some path the route matches
+
+typedef enum { METHOD_NEVER, METHOD_MAYBE, METHOD_SURE } MethodRelation;
+
+// Scratch shared by every chain built in one freeze
+typedef struct {
+    unsigned char *marks;    // Per FrozenLayer
+    int *touched;            // FrozenLayers with a mark, to clear them again
+    int touched_count;
+    int *candidates;         // Room for the largest router's layers
+} ChainBuilder;
+
+// The path a layer in a router mounted at `prefix` sees, or NULL when the
+// request is outside the mount; as in router_enter_mount, an empty rest is "/"
+static const char *frozen_sub_path(const char *prefix, size_t prefix_len, const char *path) {
+    if (prefix_len == 0) return path;
+    if (strncmp(path, prefix, prefix_len) != 0) return NULL;
+    return path[prefix_len] ? path + prefix_len : "/";
+}
+
+// Does the layer's handler replace the request's parameters? Middleware on
+// a plain path leaves them alone (see router_advance)
+static int layer_sets_params(const Layer *layer) {
+    const RoutePattern *pattern = (const RoutePattern *)layer->pattern;
+    return pattern && !(layer->type == LAYER_MIDDLEWARE && pattern->is_static);
+}
+
+static int layer_captures(const Layer *layer) {
+    const RoutePattern *pattern = (const RoutePattern *)layer->pattern;
+    return pattern && !pattern->is_static;
+}
+
+static void *grow(void *items, int *capacity, int count, size_t item_size) {
+    if (count < *capacity) return items;
+    int new_capacity = *capacity == 0 ? 8 : *capacity * 2;
+    void *grown = realloc(items, new_capacity * item_size);
+    if (grown) *capacity = new_capacity;
+    return grown;
+}
+
+static int freeze_group(FrozenRouter *frozen, int *group_capacity, int *layer_capacity, Router *router,
+                        const char *prefix, int depth) {
+    if (depth > FROZEN_MAX_MOUNT_DEPTH) {
+        ERROR_PRINT("router_freeze: mounts nested deeper than %d at '%s'\n", FROZEN_MAX_MOUNT_DEPTH, prefix);
+        return -1;
+    }
+    FrozenGroup *groups = grow(frozen->groups, group_capacity, frozen->group_count, sizeof(FrozenGroup));
+    if (!groups) return -1;
+    frozen->groups = groups;
+
+    int index = frozen->group_count++;
+    FrozenGroup *group = &frozen->groups[index];
+    group->router = router;
+    group->prefix = strdup(prefix);
+    group->prefix_len = strlen(prefix);
+    group->flat = malloc((router->layer_count > 0 ? router->layer_count : 1) * sizeof(int));
+    if (!group->prefix || !group->flat) return -1;
+    if (router->layer_count > frozen->max_router_layers) frozen->max_router_layers = router->layer_count;
+
+    for (int i = 0; i < router->layer_count; i++) {
+        Layer *layer = &router->layers[i];
+        if (layer->type == LAYER_ROUTER) {
+            frozen->groups[index].flat[i] = -1;
+            // A virtual host's router belongs in the tables of the hosts it takes
+            if (layer->host && !(frozen->host && vhost_pattern_covers(layer->host, frozen->host))) continue;
+            size_t mount_len = strlen(layer->mount_prefix);
+            char *joined = malloc(strlen(prefix) + mount_len + 1);
+            if (!joined) return -1;
+            memcpy(joined, prefix, strlen(prefix));
+            memcpy(joined + strlen(prefix), layer->mount_prefix, mount_len + 1);
+            int result = freeze_group(frozen, group_capacity, layer_capacity, layer->data.router, joined, depth + 1);
+            free(joined);
+            if (result < 0) return -1;
+            continue;
+        }
+
+        FrozenLayer *layers = grow(frozen->layers, layer_capacity, frozen->layer_count, sizeof(FrozenLayer));
+        if (!layers) return -1;
+        frozen->layers = layers;
+        FrozenLayer *flat = &frozen->layers[frozen->layer_count];
+        flat->layer = layer;
+        flat->prefix = frozen->groups[index].prefix;
+        flat->prefix_len = frozen->groups[index].prefix_len;
+        flat->group = index;
+        frozen->groups[index].flat[i] = frozen->layer_count++;
+    }
+    return 0;
+}
+
+// Can a later handler `other` run for a request `route` took, by method?
+static MethodRelation method_relation(const Layer *other, const Layer *route) {
+    unsigned int extension = HTTP_METHOD_BIT(HTTP_METHOD_OTHER);
+    if (!(other->methods & route->methods)) return METHOD_NEVER;
+    if (other->methods == extension && route->methods == extension) {
+        return strcmp(other->method, route->method) == 0 ? METHOD_SURE : METHOD_NEVER;
+    }
+    return (route->methods & ~other->methods) == 0 ? METHOD_SURE : METHOD_MAYBE;
+}
+
+static void builder_mark(ChainBuilder *builder, int flat, unsigned char mark) {
+    if (!builder->marks[flat]) builder->touched[builder->touched_count++] = flat;
+    builder->marks[flat] |= mark;
+}
+
+// Mark the layers that match one literal path exactly
+static void mark_literal_path(const FrozenRouter *frozen, ChainBuilder *builder, const char *path,
+                              unsigned char mark) {
+    for (int g = 0; g < frozen->group_count; g++) {
+        const FrozenGroup *group = &frozen->groups[g];
+        const char *sub = frozen_sub_path(group->prefix, group->prefix_len, path);
+        if (!sub) continue;
+
+        int count = route_tree_candidates(group->router->tree, sub, builder->candidates);
+        for (int i = 0; i < count; i++) {
+            int flat = group->flat[builder->candidates[i]];
+            ParamSlice slices[REQUEST_MAX_ROUTE_SLICES];
+            int slice_count = 0;
+            if (flat >= 0 && layer_match_path(frozen->layers[flat].layer, sub, slices, REQUEST_MAX_ROUTE_SLICES,
+                                              &slice_count, NULL)) {
+                builder_mark(builder, flat, mark);
+            }
+        }
+    }
+}
+
+// Can a path `pattern` matches start with `rest`, the part of a deeper
+// mount's prefix past the route's own? Only a leading literal is compared.
+static int pattern_may_start_with(const RoutePattern *pattern, const char *rest) {
+    if (rest[0] != '/' || pattern->segment_count == 0 || pattern->segments[0].type != SEGMENT_LITERAL) return 1;
+    const char *segment = rest + 1;
+    size_t length = strcspn(segment, "/");
+    const char *literal = pattern->segments[0].literal_value;
+    // Mount prefixes are string prefixes: "/api" also reaches "/apiary"
+    if (segment[length] == '\0') return strncmp(literal, segment, length) == 0;
+    return strlen(literal) == length && strncmp(literal, segment, length) == 0;
+}
+
+// Mark the layers that might match some path a parameterised route matches
+static void mark_overlapping(const FrozenRouter *frozen, ChainBuilder *builder, const FrozenLayer *route) {
+    const RoutePattern *pattern = (const RoutePattern *)route->layer->pattern;
+    for (int g = 0; g < frozen->group_count; g++) {
+        const FrozenGroup *group = &frozen->groups[g];
+        size_t common = group->prefix_len < route->prefix_len ? group->prefix_len : route->prefix_len;
+        if (strncmp(group->prefix, route->prefix, common) != 0) continue;
+        if (group->prefix_len > route->prefix_len &&
+            !pattern_may_start_with(pattern, group->prefix + route->prefix_len)) {
+            continue;
+        }
+
+        // Same prefix: the route's pattern can be laid over this router's
+        // tree. Otherwise every layer under the prefix is a candidate.
+        int count = -1;
+        if (group->prefix_len == route->prefix_len) {
+            count = route_tree_overlapping(group->router->tree, pattern, group->router->layer_count, builder->candidates);
+        }
+        if (count < 0) {
+            count = group->router->layer_count;
+            for (int i = 0; i < count; i++) builder->candidates[i] = i;
+        }
+        for (int i = 0; i < count; i++) {
+            int flat = group->flat[builder->candidates[i]];
+            if (flat >= 0) builder_mark(builder, flat, MARK_MAYBE);
+        }
+    }
+}
+
+static int compare_ints(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+static int build_route_chain(FrozenRouter *frozen, ChainBuilder *builder, int index) {
+    const FrozenLayer *route = &frozen->layers[index];
+    const Layer *route_layer = route->layer;
+    const RoutePattern *pattern = (const RoutePattern *)route_layer->pattern;
+    FrozenChain *chain = &frozen->chains[index];
+    unsigned char all_paths = MARK_PATH0;
+
+    // Handlers without a path never match
+    if (!pattern) return 0;
+
+    if (pattern->is_static) {
+        // A plain path matches one request path, two when it is the root of
+        // a mount ("/api" and "/api/"): every layer is decided here
+        size_t path_len = strlen(route_layer->path);
+        char *path = malloc(route->prefix_len + path_len + 2);
+        if (!path) return -1;
+        memcpy(path, route->prefix, route->prefix_len);
+        if (route->prefix_len > 0 && strcmp(route_layer->path, "/") == 0) {
+            path[route->prefix_len] = '\0';
+            mark_literal_path(frozen, builder, path, MARK_PATH0);
+            memcpy(path + route->prefix_len, "/", 2);
+            mark_literal_path(frozen, builder, path, MARK_PATH1);
+            all_paths |= MARK_PATH1;
+        } else {
+            memcpy(path + route->prefix_len, route_layer->path, path_len + 1);
+            mark_literal_path(frozen, builder, path, MARK_PATH0);
+        }
+        free(path);
+    } else {
+        mark_overlapping(frozen, builder, route);
+    }
+    builder_mark(builder, index, MARK_PATH0);
+
+    qsort(builder->touched, builder->touched_count, sizeof(int), compare_ints);
+    chain->steps = malloc(builder->touched_count * sizeof(FrozenStep));
+    if (!chain->steps) return -1;
+
+    for (int i = 0; i < builder->touched_count; i++) {
+        int flat = builder->touched[i];
+        const FrozenLayer *other = &frozen->layers[flat];
+        unsigned char marks = builder->marks[flat];
+        builder->marks[flat] = 0;
+
+        FrozenStepKind kind;
+        if (flat == index) {
+            kind = STEP_ROUTE;
+        } else if (other->layer->type == LAYER_MIDDLEWARE) {
+            // Plain-path middleware runs for every request inside its mount
+            int inside = other->prefix_len <= route->prefix_len;
+            int sure = (marks & all_paths) == all_paths || ((marks & MARK_MAYBE) && inside);
+            kind = sure && !layer_captures(other->layer) ? STEP_ALWAYS : STEP_CHECK;
+        } else {
+            // Earlier routes never match: this one is the first that does
+            MethodRelation method = method_relation(other->layer, route_layer);
+            if (flat < index || method == METHOD_NEVER) continue;
+            int sure = (marks & all_paths) == all_paths && method == METHOD_SURE;
+            kind = sure && !layer_captures(other->layer) ? STEP_ALWAYS : STEP_CHECK;
+        }
+        chain->steps[chain->step_count].layer = other;
+        chain->steps[chain->step_count].kind = kind;
+        chain->step_count++;
+    }
+    builder->touched_count = 0;
+    return 0;
+}
+
+static int build_unmatched_chain(FrozenRouter *frozen) {
+    FrozenChain *chain = &frozen->unmatched;
+    chain->steps = malloc((frozen->layer_count > 0 ? frozen->layer_count : 1) * sizeof(FrozenStep));
+    if (!chain->steps) return -1;
+    for (int i = 0; i < frozen->layer_count; i++) {
+        const FrozenLayer *flat = &frozen->layers[i];
+        if (flat->layer->type != LAYER_MIDDLEWARE) continue;
+        chain->steps[chain->step_count].layer = flat;
+        chain->steps[chain->step_count].kind =
+            flat->prefix_len == 0 && !layer_captures(flat->layer) ? STEP_ALWAYS : STEP_CHECK;
+        chain->step_count++;
+    }
+    return 0;
+}
+
+// The table for requests to hosts `host` takes (NULL: hosts no virtual
+// host takes)
+static FrozenRouter *freeze_table(Router *router, const char *host, int table, unsigned long generation) {
+    FrozenRouter *frozen = calloc(1, sizeof(FrozenRouter));
+    int group_capacity = 0, layer_capacity = 0;
+    if (!frozen) return NULL;
+    frozen->generation = generation;
+    frozen->host = host;
+    frozen->table = table;
+
+    if (freeze_group(frozen, &group_capacity, &layer_capacity, router, "", 0) < 0 ||
+        build_unmatched_chain(frozen) < 0) {
+        frozen_router_destroy(frozen);
+        return NULL;
+    }
+
+    int count = frozen->layer_count > 0 ? frozen->layer_count : 1;
+    ChainBuilder builder = { calloc(count, 1), malloc(count * sizeof(int)), 0,
+                             malloc((frozen->max_router_layers > 0 ? frozen->max_router_layers : 1) * sizeof(int)) };
+    frozen->chains = calloc(count, sizeof(FrozenChain));
+    int ok = builder.marks && builder.touched && builder.candidates && frozen->chains;
+
+    size_t steps = 0;
+    for (int i = 0; ok && i < frozen->layer_count; i++) {
+        if (frozen->layers[i].layer->type != LAYER_HANDLER) continue;
+        ok = build_route_chain(frozen, &builder, i) == 0;
+        steps += frozen->chains[i].step_count;
+    }
+    free(builder.marks);
+    free(builder.touched);
+    free(builder.candidates);
+    if (!ok) {
+        frozen_router_destroy(frozen);
+        return NULL;
+    }
+    DEBUG_PRINT("router_freeze: %s: %d layers in %d routers, %zu chain steps\n", host ? host : "default",
+                frozen->layer_count, frozen->group_count, steps);
+    return frozen;
+}
+
+// Every distinct host pattern mounted anywhere under the router
+static int collect_hosts(Router *router, const char ***hosts, int *count, int *capacity, int depth) {
+    if (depth > FROZEN_MAX_MOUNT_DEPTH) return 0;  // freeze_group reports it
+    for (int i = 0; i < router->layer_count; i++) {
+        Layer *layer = &router->layers[i];
+        if (layer->type != LAYER_ROUTER) continue;
+        if (layer->host) {
+            int known = 0;
+            for (int h = 0; h < *count && !known; h++) known = strcmp((*hosts)[h], layer->host) == 0;
+            if (!known) {
+                const char **grown = grow(*hosts, capacity, *count, sizeof(const char *));
+                if (!grown) return -1;
+                *hosts = grown;
+                (*hosts)[(*count)++] = layer->host;
+            }
+        }
+        if (collect_hosts(layer->data.router, hosts, count, capacity, depth + 1) < 0) return -1;
+    }
+    return 0;
+}
+
+static FrozenHost *host_slot(const FrozenRouter *frozen, const char *key, size_t key_len, int wildcard,
+                             unsigned long hash) {
+    unsigned long mask = (unsigned long)frozen->host_slots - 1;
+    for (unsigned long i = hash & mask;; i = (i + 1) & mask) {
+        FrozenHost *slot = &frozen->hosts[i];
+        if (!slot->table || (slot->hash == hash && slot->wildcard == wildcard && slot->key_len == key_len &&
+                             strncasecmp(slot->key, key, key_len) == 0)) {
+            return slot;
+        }
+    }
+}
+
+FrozenRouter *router_freeze(Router *router) {
+    unsigned long generation = route_cache_next_generation();
+    FrozenRouter *frozen = freeze_table(router, NULL, 0, generation);
+    const char **hosts = NULL;
+    int host_count = 0, host_capacity = 0;
+    if (!frozen) return NULL;
+    if (collect_hosts(router, &hosts, &host_count, &host_capacity, 0) < 0) goto fail;
+    if (host_count == 0) return frozen;
+
+    // At most half full, so probes stay short and always reach a free slot
+    frozen->host_slots = 4;
+    while (frozen->host_slots < host_count * 2) frozen->host_slots *= 2;
+    frozen->hosts = calloc(frozen->host_slots, sizeof(FrozenHost));
+    if (!frozen->hosts) goto fail;
+    for (int h = 0; h < host_count; h++) {
+        int wildcard = hosts[h][0] == '*';
+        const char *key = hosts[h] + wildcard;
+        size_t key_len = strlen(key);
+        unsigned long hash = vhost_hash(key, key_len);
+        FrozenHost *slot = host_slot(frozen, key, key_len, wildcard, hash);
+        slot->table = freeze_table(router, hosts[h], h + 1, generation);
+        if (!slot->table) goto fail;
+        slot->key = key;
+        slot->key_len = key_len;
+        slot->wildcard = wildcard;
+        slot->hash = hash;
+    }
+    free(hosts);
+    return frozen;
+
+fail:
+    free(hosts);
+    frozen_router_destroy(frozen);
+    return NULL;
+}
+
+void frozen_router_destroy(FrozenRouter *frozen) {
+    if (!frozen) return;
+    if (frozen->chains) {
+        for (int i = 0; i < frozen->layer_count; i++) free(frozen->chains[i].steps);
+        free(frozen->chains);
+    }
+    free(frozen->unmatched.steps);
+    for (int i = 0; i < frozen->group_count; i++) {
+        free(frozen->groups[i].prefix);
+        free(frozen->groups[i].flat);
+    }
+    free(frozen->groups);
+    free(frozen->layers);
+    for (int i = 0; i < frozen->host_slots; i++) frozen_router_destroy(frozen->hosts[i].table);
+    free(frozen->hosts);
+    destroy_router(frozen->owned_router);
+    free(frozen);
+}
+
+// Index of the first route that takes the request, with its parameters
+// left in req->route_slices; -1 when none does
+static int frozen_lookup(const FrozenRouter *frozen, HttpMethod method_id, const char *method,
+                         const char *path, Request *req) {
+    int *candidates = arena_alloc(&req->arena, (frozen->max_router_layers > 0 ? frozen->max_router_layers : 1) *
+                                               sizeof(int));
+    int route = -1;
+    if (!candidates) return -1;
+
+    for (int g = 0; g < frozen->group_count; g++) {
+        const FrozenGroup *group = &frozen->groups[g];
+        const char *sub = frozen_sub_path(group->prefix, group->prefix_len, path);
+        if (!sub) continue;
+
+        int count = route_tree_candidates(group->router->tree, sub, candidates);
+        for (int i = 0; i < count; i++) {
+            int flat = group->flat[candidates[i]];
+            if (flat < 0) continue;
+            if (route >= 0 && flat > route) break;
+
+            Layer *layer = frozen->layers[flat].layer;
+            ParamSlice slices[REQUEST_MAX_ROUTE_SLICES];
+            int slice_count = 0;
+            if (layer->type == LAYER_HANDLER &&
+                layer_match_slices(layer, method_id, method, sub, slices, REQUEST_MAX_ROUTE_SLICES,
+                                   &slice_count, &req->arena)) {
+                route = flat;
+                memcpy(req->route_slices, slices, slice_count * sizeof(ParamSlice));
+                req->route_slice_count = slice_count;
+                break;
+            }
+        }
+    }
+    return route;
+}
+
+// NextContext.advance for a frozen chain
+static int frozen_advance(NextContext *ctx) {
+    Request *req = ctx->req;
+
+    while (ctx->idx < ctx->chain->step_count) {
+        const FrozenStep *step = &ctx->chain->steps[ctx->idx++];
+        Layer *layer = step->layer->layer;
+
+        const char *sub = frozen_sub_path(step->layer->prefix, step->layer->prefix_len, req->path);
+        if (step->kind == STEP_CHECK) {
+            // Parameters of other layers go after the route's own
+            ParamSlice *slices = req->route_slices + req->route_slice_count;
+            int slice_count = 0;
+            if (!sub || !layer_match_slices(layer, req->method_id, req->method, sub, slices,
+                                            REQUEST_MAX_ROUTE_SLICES - req->route_slice_count,
+                                            &slice_count, ctx->arena)) {
+                continue;
+            }
+            if (layer_sets_params(layer)) request_set_route_slices(req, slices, slice_count);
+        } else if (layer_sets_params(layer)) {
+            int slice_count = step->kind == STEP_ROUTE ? req->route_slice_count : 0;
+            request_set_route_slices(req, req->route_slices, slice_count);
+        }
+
+        ctx->path = sub ? sub : req->path;
+        DEBUG_PRINT("frozen_advance: step %d of %d (%s)\n", ctx->idx, ctx->chain->step_count,
+                    layer->path ? layer->path : "NULL");
+        layer->data.handler(ctx->client_fd, next_handler, ctx);
+        return 1;
+    }
+    DEBUG_PRINT_STR("frozen_advance: end of chain\n");
+    return 0;
+}
+
+unsigned int frozen_router_allowed_methods(const FrozenRouter *frozen, const char *path, Arena *arena) {
+    int *candidates = arena ? arena_alloc(arena, (frozen->max_router_layers > 0 ? frozen->max_router_layers : 1) *
+                                                 sizeof(int))
+                            : malloc((frozen->max_router_layers > 0 ? frozen->max_router_layers : 1) * sizeof(int));
+    unsigned int allowed = 0;
+    if (!candidates) return 0;
+
+    for (int g = 0; g < frozen->group_count; g++) {
+        const FrozenGroup *group = &frozen->groups[g];
+        const char *sub = frozen_sub_path(group->prefix, group->prefix_len, path);
+        if (!sub) continue;
+
+        int count = route_tree_candidates(group->router->tree, sub, candidates);
+        for (int i = 0; i < count; i++) {
+            Layer *layer = &group->router->layers[candidates[i]];
+            ParamSlice slices[REQUEST_MAX_ROUTE_SLICES];
+            int slice_count = 0;
+            if (layer->type == LAYER_HANDLER && (allowed | layer->methods) != allowed &&
+                layer_match_path(layer, sub, slices, REQUEST_MAX_ROUTE_SLICES, &slice_count, arena)) {
+                allowed |= layer->methods;
+            }
+        }
+    }
+    if (!arena) free(candidates);
+    return allowed;
+}
+
+// The table for the request's Host: its exact name's, else the wildcard
+// with the longest suffix taking it, else the app's own
+static const FrozenRouter *frozen_host_table(const FrozenRouter *frozen, Request *req) {
+    const char *host = req->get_header(req, "Host");
+    size_t len = vhost_host_length(host);
+    if (len == 0) return frozen;
+
+    const FrozenHost *slot = host_slot(frozen, host, len, 0, vhost_hash(host, len));
+    for (size_t i = 1; !slot->table && i < len; i++) {
+        if (host[i] == '.') slot = host_slot(frozen, host + i, len - i, 1, vhost_hash(host + i, len - i));
+    }
+    DEBUG_PRINT("frozen_host_table: %.*s -> %s\n", (int)len, host, slot->table ? slot->table->host : "default");
+    return slot->table ? slot->table : frozen;
+}
+
+int frozen_router_handle(FrozenRouter *frozen, struct App *app, const char *method, const char *path,
+                         int client_fd, Request *req) {
+    const FrozenRouter *table = frozen->hosts ? frozen_host_table(frozen, req) : frozen;
+    HttpMethod method_id = method == req->method ? req->method_id
+                         : method ? http_method_parse(method, strlen(method)) : HTTP_METHOD_OTHER;
+    req->route_slice_count = 0;
+
+    // Extension methods match by name, which the cache does not key on
+    RouteCacheShard *shard = frozen->cache_entries > 0 && method_id != HTTP_METHOD_OTHER
+                           ? route_cache_shard(frozen->generation, frozen->cache_entries) : NULL;
+    size_t path_len = shard ? strlen(path) : 0;
+    const RouteCacheResult *cached = shard ? route_cache_get(shard, table->table, method_id, path, path_len) : NULL;
+    int route;
+    unsigned int allowed;
+    if (cached) {
+        route = cached->route;
+        allowed = cached->allowed;
+        for (int i = 0; i < cached->slice_count; i++) {
+            ParamSlice *slice = &req->route_slices[i];
+            slice->name = cached->slices[i].name;
+            slice->value = path + cached->slices[i].offset;
+            slice->length = cached->slices[i].length;
+        }
+        req->route_slice_count = cached->slice_count;
+    } else {
+        route = frozen_lookup(table, method_id, method, path, req);
+        // Collected before the chain runs: the arena the path lives in is
+        // reset once it completes
+        allowed = route < 0 ? frozen_router_allowed_methods(table, path, &req->arena) : 0;
+        if (shard) {
+            route_cache_put(shard, table->table, method_id, path, path_len, route, allowed, req->route_slices,
+                            req->route_slice_count);
+        }
+    }
+    const FrozenChain *chain = route >= 0 ? &table->chains[route] : &table->unmatched;
+    DEBUG_PRINT("frozen_router_handle: %s %s -> route %d, %d steps%s\n", method, path, route, chain->step_count,
+                cached ? " (cached)" : "");
+
+    NextContext local;
+    NextContext *ctx = next_context_create(table->groups[0].router, app, client_fd, req, &local);
+    ctx->match_count = chain->step_count;
+    ctx->chain = chain;
+    ctx->route_match_count = route >= 0;
+    ctx->allowed = allowed;
+    ctx->advance = frozen_advance;
+    ctx->pin = &frozen->pins;   // Hosts' tables live and die with the app's
+    return next_run(ctx);
+}
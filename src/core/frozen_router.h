@@ -0,0 +1,91 @@
+#ifndef FROZEN_ROUTER_H
+#define FROZEN_ROUTER_H
+
+#include "router.h"
+
+#define FROZEN_MAX_MOUNT_DEPTH 16    // Deeper (or cyclic) mounts are not frozen
+
+// How a step of a frozen chain decides whether its layer runs
+typedef enum {
+    STEP_ALWAYS,     // Runs for every request that reaches the chain, unchecked
+    STEP_CHECK,      // Matched against the request when reached (captures parameters)
+    STEP_ROUTE       // The route the chain belongs to, already matched by the lookup
+} FrozenStepKind;
+
+// A layer of the app's router or of a router mounted in it
+typedef struct {
+    Layer *layer;
+    const char *prefix;      // Mount prefixes leading to the layer, joined ("" at the top)
+    size_t prefix_len;
+    int group;               // FrozenGroup the layer came from
+} FrozenLayer;
+
+typedef struct {
+    const FrozenLayer *layer;
+    FrozenStepKind kind;
+} FrozenStep;
+
+// Every layer that may run once a request reaches it, in order
+typedef struct FrozenChain {
+    FrozenStep *steps;
+    int step_count;
+} FrozenChain;
+
+// One router reachable from the app, at one joined prefix
+typedef struct {
+    Router *router;
+    char *prefix;
+    size_t prefix_len;
+    int *flat;               // Router layer -> FrozenLayer index (-1 for mounts)
+} FrozenGroup;
+
+// A virtual host's table, keyed by its name or, for "*.suffix", by ".suffix"
+typedef struct {
+    const char *key;         // Into the mount layer's pattern
+    size_t key_len;
+    int wildcard;
+    unsigned long hash;      // vhost_hash of the key
+    struct FrozenRouter *table; // NULL for a free slot
+} FrozenHost;
+
+// An app's routers compiled for dispatch: mounted routers are expanded in
+// place, and each route has the ordered list of layers that can follow
+// it already worked out, so a request costs one route lookup and a walk
+// over one array. Built once all routes are registered; read-only after.
+typedef struct FrozenRouter {
+    FrozenLayer *layers;     // Every layer in dispatch order, mounts expanded
+    int layer_count;
+    FrozenGroup *groups;
+    int group_count;
+    FrozenChain *chains;     // Per FrozenLayer: its chain when it is a route
+    FrozenChain unmatched;   // Middleware only, for requests no route takes
+    int max_router_layers;   // Largest router, for the lookup scratch
+    unsigned long generation; // Unique per freeze: tags route cache entries
+    int cache_entries;       // Per-thread route cache size (0: no cache)
+    // Swapping tables at runtime (app_publish_router)
+    Router *owned_router;    // Destroyed with the table: a published draft
+    unsigned int pins;       // Paused chains still walking the table
+    unsigned long retire_epoch;
+    struct FrozenRouter *retired_next;
+    // Virtual hosts (router_vhost): the table frozen for the app holds one
+    // more per host pattern, with the layers that pattern's hosts see
+    FrozenHost *hosts;       // Open addressing over host_slots (a power of two)
+    int host_slots;
+    const char *host;        // Pattern of a host's table, NULL for the app's
+    int table;               // Tells the tables apart in the route cache (0: the app's)
+} FrozenRouter;
+
+// NULL when out of memory or when mounts nest too deeply
+FrozenRouter *router_freeze(Router *router);
+void frozen_router_destroy(FrozenRouter *frozen);
+
+// Dispatch a request: pick the table for its Host, then run the chain of
+// the first route matching the method and path, or the middleware and then
+// a 404/405 when none does. Returns
+// what app_handle_request does; a paused chain pins the table.
+int frozen_router_handle(FrozenRouter *frozen, struct App *app, const char *method, const char *path,
+                         int client_fd, Request *req);
+// router_allowed_methods over every router the app reaches
+unsigned int frozen_router_allowed_methods(const FrozenRouter *frozen, const char *path, Arena *arena);
+
+#endif
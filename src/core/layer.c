@@ -27,7 +27,8 @@ const char* get_next_segment(const char *path, int *pos, char *buffer, int buffe
     return buffer;
 }
 
-// Legacy simple pattern matching (for backwards compatibility)
+// Legacy simple pattern matching (for backwards compatibility). Layers
+// never come here: their patterns are compiled when they are registered.
 int path_matches_pattern(const char *pattern, const char *path) {
     if (!pattern || !path) return 0;
     
@@ -36,112 +37,83 @@ int path_matches_pattern(const char *pattern, const char *path) {
         return strcmp(pattern, path) == 0;
     }
     
-    // Use advanced pattern matching for complex patterns
     RoutePattern *compiled = compile_route_pattern(pattern);
-    if (!compiled) return 0;
-    
-    RouteMatch match = route_pattern_match(compiled, path);
-    int result = match.matched;
-    
-    free_route_match(&match);
+    int result = route_pattern_matches(compiled, path);
     free_route_pattern(compiled);
-    
     return result;
 }
 
-// Get the last match result from a layer (for parameter access)
-void* layer_get_match_result(Layer *layer) {
-    return layer ? layer->last_match : NULL;
+// Match a layer without keeping its parameters. Layers are shared by every
+// thread serving the app, so nothing about a request is stored on them.
+int layer_match(Layer *layer, const char *method, const char *path) {
+    ParamSlice slices[MAX_PARAMS];
+    int slice_count = 0;
+    HttpMethod method_id = method ? http_method_parse(method, strlen(method)) : HTTP_METHOD_OTHER;
+    return layer_match_slices(layer, method_id, method, path, slices, MAX_PARAMS, &slice_count, NULL);
 }
 
-int layer_match(Layer *layer, const char *method, const char *path) {
-    // Clear previous match result
-    if (layer->last_match) {
-        free_route_match((RouteMatch*)layer->last_match);
-        free(layer->last_match);
-        layer->last_match = NULL;
-    }
-    
-    if (layer->method && strcmp(layer->method, "USE") == 0) {
-        DEBUG_PRINT("layer_match: middleware matched for method=%s, path=%s\n", method, path);
-        
-        // For middleware with patterns, still check the path
-        if (layer->pattern) {
-            RouteMatch match = route_pattern_match((RoutePattern*)layer->pattern, path);
-            if (match.matched) {
-                layer->last_match = duplicate_route_match(&match);
-                free_route_match(&match);
-                return 1;
-            } else {
-                free_route_match(&match);
-                return 0;
-            }
-        }
-        
-        return 1; // Always match for middleware without patterns
-    }
+// Prefix check for mounted routers
+static int layer_match_mount(const Layer *layer, const char *path) {
+    size_t prefix_len = strlen(layer->mount_prefix);
+    int match = strncmp(path, layer->mount_prefix, prefix_len) == 0;
+    DEBUG_PRINT("layer_match: router match=%d for path=%s, mount_prefix=%s\n",
+           match, path, layer->mount_prefix);
+    return match;
+}
 
-    // Handle mounted routers
-    if (layer->type == LAYER_ROUTER && layer->mount_prefix) {
-        // Check if path starts with mount prefix
-        size_t prefix_len = strlen(layer->mount_prefix);
-        if (strncmp(path, layer->mount_prefix, prefix_len) == 0) {
-            // Path matches prefix, this router should handle it
-            DEBUG_PRINT("layer_match: router match=1 for method=%s, path=%s, mount_prefix=%s\n",
-                   method, path, layer->mount_prefix);
-            return 1;
-        } else {
-            DEBUG_PRINT("layer_match: router match=0 for method=%s, path=%s, mount_prefix=%s\n",
-                   method, path, layer->mount_prefix);
-            return 0;
-        }
+int layer_allows_method(const Layer *layer, HttpMethod method, const char *method_name) {
+    if (layer->type != LAYER_HANDLER) return 1;
+    if (!(layer->methods & HTTP_METHOD_BIT(method))) return 0;
+    // Extension methods share one bit; tell them apart by name
+    if (method == HTTP_METHOD_OTHER && layer->method) {
+        return method_name && strcmp(layer->method, method_name) == 0;
     }
+    return 1;
+}
+
+// Parameters past max_slices were neither kept nor checked against their
+// constraints, so a layer capturing more does not match
+static int layer_slices_fit(const Layer *layer, int captured, int max_slices) {
+    if (captured <= max_slices) return 1;
+    DEBUG_PRINT("layer_match_path: no room for %d parameters of '%s'\n", captured, layer->path);
+    (void)layer;
+    return 0;
+}
 
-    // Handle regular handlers
-    int method_match = layer->method ? strcmp(layer->method, method) == 0 : 1;
-    int path_match = 0;
+int layer_match_path(Layer *layer, const char *path, ParamSlice *slices, int max_slices,
+                     int *slice_count, Arena *arena) {
+    RoutePattern *pattern = (RoutePattern*)layer->pattern;
+    int captured = 0;
+    *slice_count = 0;
     
-    if (layer->pattern) {
-        // Use advanced pattern matching
-        RouteMatch match = route_pattern_match((RoutePattern*)layer->pattern, path);
-        path_match = match.matched;
-        
-        if (path_match) {
-            // Validate constraints if this is a route handler (not middleware)
-            if (layer->method && strcmp(layer->method, "USE") != 0) {
-                ValidationError *errors = NULL;
-                int error_count = 0;
-                
-                if (!validate_route_match(&match, &errors, &error_count)) {
-                    DEBUG_PRINT("layer_match: constraint validation failed (%d errors)\n", error_count);
-                    
-                    // Free validation errors
-                    for (int i = 0; i < error_count; i++) {
-                        free_validation_error(&errors[i]);
-                    }
-                    free(errors);
-                    
-                    free_route_match(&match);
-                    return 0; // Constraint validation failed
-                }
-            }
-            
-            // Store match result for parameter access
-            layer->last_match = duplicate_route_match(&match);
-            DEBUG_PRINT("layer_match: advanced pattern matched with %d parameters\n", match.param_count);
-            free_route_match(&match);
-        } else {
-            free_route_match(&match);
+    if (layer->type == LAYER_MIDDLEWARE) {
+        // Middleware with parameters or a wildcard still has to match the
+        // path; a plain path (or none) applies to every request
+        if (pattern && !pattern->is_static) {
+            captured = route_pattern_match_slices(pattern, path, slices, max_slices);
+            if (captured < 0 || !layer_slices_fit(layer, captured, max_slices)) return 0;
+            *slice_count = captured;
         }
-    } else if (layer->path) {
-        // Use legacy pattern matching
-        path_match = path_matches_pattern(layer->path, path);
+        return 1;
     }
     
-    int match = method_match && path_match;
+    if (layer->type == LAYER_ROUTER && layer->mount_prefix) {
+        return layer_match_mount(layer, path);
+    }
     
-    DEBUG_PRINT("layer_match: route match=%d for method=%s, path=%s, layer_method=%s, layer_path=%s\n",
-           match, method, path, layer->method ? layer->method : "NULL", layer->path ? layer->path : "NULL");
+    if (!pattern || pattern->is_static) return route_pattern_matches(pattern, path);
     
-    return match;
-}
\ No newline at end of file
+    captured = route_pattern_match_slices(pattern, path, slices, max_slices);
+    if (captured < 0 || !layer_slices_fit(layer, captured, max_slices)) return 0;
+    if (!validate_route_slices(pattern, slices, captured, arena)) return 0;
+    
+    *slice_count = captured;
+    return 1;
+}
+
+int layer_match_slices(Layer *layer, HttpMethod method, const char *method_name, const char *path,
+                       ParamSlice *slices, int max_slices, int *slice_count, Arena *arena) {
+    *slice_count = 0;
+    if (!layer_allows_method(layer, method, method_name)) return 0;
+    return layer_match_path(layer, path, slices, max_slices, slice_count, arena);
+}
@@ -10,24 +10,37 @@ struct Router;
 
 typedef enum {
     LAYER_HANDLER,    // Regular handler
+    LAYER_MIDDLEWARE, // Handler registered with use(): runs for every method
     LAYER_ROUTER      // Mounted sub-router
 } LayerType;
 
 typedef struct {
     const char *path;
     const char *method;
+    unsigned int methods;     // HTTP_METHOD_BIT mask of `method`, set when added
     LayerType type;
     union {
         Handler handler;      // For LAYER_HANDLER
         struct Router *router;       // For LAYER_ROUTER  
     } data;
     const char *mount_prefix; // For mounted routers
+    char *host;               // Host pattern of a virtual host's router (router_vhost), else NULL
     void *pattern;            // Compiled pattern for advanced matching (RoutePattern*)
-    void *last_match;         // Store last match result for parameter access (RouteMatch*)
 } Layer;
 
 int layer_match(Layer *layer, const char *method, const char *path);
+// Layers are read-only while requests are served: matching records the
+// parameters in caller-owned `slices` (*slice_count of them), never on the
+// layer. `arena` only holds copies of constrained values while they are
+// checked (heap when NULL). The method is tested against the layer's mask;
+// `method_name` is only compared for extension methods.
+int layer_match_slices(Layer *layer, HttpMethod method, const char *method_name, const char *path,
+                       ParamSlice *slices, int max_slices, int *slice_count, Arena *arena);
+// The path half of layer_match_slices, for every method
+int layer_match_path(Layer *layer, const char *path, ParamSlice *slices, int max_slices,
+                     int *slice_count, Arena *arena);
+// Does the layer accept this method?
+int layer_allows_method(const Layer *layer, HttpMethod method, const char *method_name);
 int path_matches_pattern(const char *pattern, const char *path);
-void* layer_get_match_result(Layer *layer);
 
 #endif
\ No newline at end of file
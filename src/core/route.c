@@ -4,11 +4,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <regex.h>
 
+// Match-time allocation: from the request arena when there is one
+static void *route_alloc(Arena *arena, size_t size) {
+    return arena ? arena_alloc(arena, size) : malloc(size);
+}
+
+static char *route_strdup(Arena *arena, const char *str) {
+    return arena ? arena_strdup(arena, str) : strdup(str);
+}
+
+static void route_release(Arena *arena, void *ptr) {
+    if (!arena) free(ptr);
+}
+
 // Helper function to split path into segments
 char **split_path_segments(const char *path, int *count) {
+    return split_path_segments_in(path, count, NULL);
+}
+
+char **split_path_segments_in(const char *path, int *count, Arena *arena) {
     if (!path || strlen(path) == 0) {
         *count = 0;
         return NULL;
@@ -16,8 +32,8 @@ char **split_path_segments(const char *path, int *count) {
     
     // Handle root path "/"
     if (strcmp(path, "/") == 0) {
-        char **segments = malloc(sizeof(char*));
-        segments[0] = strdup("");
+        char **segments = route_alloc(arena, sizeof(char*));
+        segments[0] = route_strdup(arena, "");
         *count = 1;
         return segments;
     }
@@ -52,7 +68,7 @@ char **split_path_segments(const char *path, int *count) {
     }
     
     // Second pass: extract segments
-    char **segments = malloc(segment_count * sizeof(char*));
+    char **segments = route_alloc(arena, segment_count * sizeof(char*));
     int segment_idx = 0;
     p = start;
     seg_start = start;
@@ -61,7 +77,7 @@ char **split_path_segments(const char *path, int *count) {
         if (*p == '/') {
             if (p > seg_start) {  // Non-empty segment
                 int len = p - seg_start;
-                segments[segment_idx] = malloc(len + 1);
+                segments[segment_idx] = route_alloc(arena, len + 1);
                 strncpy(segments[segment_idx], seg_start, len);
                 segments[segment_idx][len] = '\0';
                 segment_idx++;
@@ -74,7 +90,7 @@ char **split_path_segments(const char *path, int *count) {
     // Add final segment if non-empty
     if (p > seg_start) {
         int len = p - seg_start;
-        segments[segment_idx] = malloc(len + 1);
+        segments[segment_idx] = route_alloc(arena, len + 1);
         strncpy(segments[segment_idx], seg_start, len);
         segments[segment_idx][len] = '\0';
         segment_idx++;
@@ -116,6 +132,8 @@ ParameterType parse_parameter_type_and_constraints(char *param_name, RouteParam
     if (constraint_start) {
         *constraint_start = '\0';
         constraint_start++; // Move past opening parenthesis
+        char *constraint_end = strrchr(constraint_start, ')');
+        if (constraint_end) *constraint_end = '\0';
     }
     
     // Determine parameter type
@@ -136,8 +154,10 @@ ParameterType parse_parameter_type_and_constraints(char *param_name, RouteParam
 void parse_parameter_constraints(const char *constraint_str, RouteParam *param) {
     if (!constraint_str || !param) return;
     
+    // Reentrant tokenizing: the enum values below are split inside this loop
     char *constraints_copy = strdup(constraint_str);
-    char *constraint = strtok(constraints_copy, ",");
+    char *constraints_save = NULL;
+    char *constraint = strtok_r(constraints_copy, ",", &constraints_save);
     
     while (constraint) {
         // Trim whitespace
@@ -180,11 +200,12 @@ void parse_parameter_constraints(const char *constraint_str, RouteParam *param)
             
             const char **values = malloc((count + 1) * sizeof(char*));
             char *enum_copy = strdup(enum_str);
-            char *value = strtok(enum_copy, "|");
+            char *enum_save = NULL;
+            char *value = strtok_r(enum_copy, "|", &enum_save);
             int i = 0;
             while (value && i < count) {
                 values[i++] = strdup(value);
-                value = strtok(NULL, "|");
+                value = strtok_r(NULL, "|", &enum_save);
             }
             values[i] = NULL;
             
@@ -199,7 +220,7 @@ void parse_parameter_constraints(const char *constraint_str, RouteParam *param)
             free(enum_copy);
         }
         
-        constraint = strtok(NULL, ",");
+        constraint = strtok_r(NULL, ",", &constraints_save);
     }
     
     free(constraints_copy);
@@ -217,38 +238,7 @@ ParameterType parse_parameter_type(char *param_name) {
 // Validate parameter value based on type
 int validate_parameter_value(const char *value, ParameterType type) {
     if (!value) return 0;
-    
-    switch (type) {
-        case PARAM_NUMBER: {
-            char *endptr;
-            strtol(value, &endptr, 10);
-            return *endptr == '\0';  // Valid if entire string was consumed
-        }
-        
-        case PARAM_SLUG: {
-            // Slug: alphanumeric, hyphens, underscores
-            for (const char *p = value; *p; p++) {
-                if (!isalnum(*p) && *p != '-' && *p != '_') return 0;
-            }
-            return strlen(value) > 0;
-        }
-        
-        case PARAM_UUID: {
-            // Simple UUID pattern check
-            regex_t regex;
-            int ret = regcomp(&regex, "^[0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12}$", REG_EXTENDED);
-            if (ret) return 0;
-            
-            ret = regexec(&regex, value, 0, NULL, 0);
-            regfree(&regex);
-            return ret == 0;
-        }
-        
-        case PARAM_STRING:
-        case PARAM_ANY:
-        default:
-            return strlen(value) > 0;
-    }
+    return validate_parameter_slice(value, strlen(value), type);
 }
 
 // Calculate route priority (lower = higher priority)
@@ -292,6 +282,8 @@ RoutePattern *compile_route_pattern(const char *pattern) {
     route_pattern->original_pattern = strdup(pattern);
     route_pattern->has_wildcards = 0;
     route_pattern->param_count = 0;
+    route_pattern->is_static = !strchr(pattern, ':') && !strchr(pattern, '*');
+    route_pattern->in_snapshot = 0;
     
     // Split pattern into segments
     int segment_count;
@@ -369,8 +361,18 @@ RoutePattern *compile_route_pattern(const char *pattern) {
     return route_pattern;
 }
 
+// Constraints written in the pattern, e.g. ":id:number(min=1)", are always
+// parsed, and regexes compiled, by compile_route_pattern
+RoutePattern* compile_route_pattern_with_constraints(const char *pattern) {
+    return compile_route_pattern(pattern);
+}
+
 // Match path against compiled route pattern
 RouteMatch route_pattern_match(RoutePattern *pattern, const char *path) {
+    return route_pattern_match_in(pattern, path, NULL);
+}
+
+RouteMatch route_pattern_match_in(RoutePattern *pattern, const char *path, Arena *arena) {
     RouteMatch match = { 0 };
     
     if (!pattern || !path) {
@@ -381,15 +383,16 @@ RouteMatch route_pattern_match(RoutePattern *pattern, const char *path) {
     
     // Split incoming path into segments
     int path_segment_count;
-    char **path_segments = split_path_segments(path, &path_segment_count);
+    char **path_segments = split_path_segments_in(path, &path_segment_count, arena);
     
     // Prepare match result
     match.params = NULL;
     match.param_count = 0;
     match.wildcard_path = NULL;
+    match.arena = arena;
     
     if (pattern->param_count > 0) {
-        match.params = malloc(pattern->param_count * sizeof(RouteParam));
+        match.params = route_alloc(arena, pattern->param_count * sizeof(RouteParam));
     }
     
     int path_idx = 0;
@@ -427,10 +430,11 @@ RouteMatch route_pattern_match(RoutePattern *pattern, const char *path) {
                 }
                 
                 // Store parameter
-                match.params[param_idx].name = strdup(seg->param->name);
+                match.params[param_idx].name = route_strdup(arena, seg->param->name);
                 match.params[param_idx].type = seg->param->type;
                 match.params[param_idx].is_optional = seg->param->is_optional;
-                match.params[param_idx].value = strdup(value);
+                match.params[param_idx].value = route_strdup(arena, value);
+                match.params[param_idx].constraints = seg->param->constraints;  // Borrowed from pattern
                 param_idx++;
                 path_idx++;
                 
@@ -444,10 +448,11 @@ RouteMatch route_pattern_match(RoutePattern *pattern, const char *path) {
                     char *value = path_segments[path_idx];
                     if (validate_parameter_value(value, seg->param->type)) {
                         // Optional parameter present and valid
-                        match.params[param_idx].name = strdup(seg->param->name);
+                        match.params[param_idx].name = route_strdup(arena, seg->param->name);
                         match.params[param_idx].type = seg->param->type;
                         match.params[param_idx].is_optional = seg->param->is_optional;
-                        match.params[param_idx].value = strdup(value);
+                        match.params[param_idx].value = route_strdup(arena, value);
+                        match.params[param_idx].constraints = seg->param->constraints;
                         param_idx++;
                         path_idx++;
                         
@@ -469,7 +474,7 @@ RouteMatch route_pattern_match(RoutePattern *pattern, const char *path) {
                         total_len += strlen(path_segments[i]) + 1; // +1 for '/'
                     }
                     
-                    match.wildcard_path = malloc(total_len + 1);
+                    match.wildcard_path = route_alloc(arena, total_len + 1);
                     match.wildcard_path[0] = '\0';
                     
                     for (int i = path_idx; i < path_segment_count; i++) {
@@ -503,15 +508,15 @@ no_match:
     DEBUG_PRINT_STR("route_pattern_match: NO MATCH\n");
     // Free any allocated memory from partial match
     if (match.params) {
-        for (int i = 0; i < match.param_count; i++) {
-            if (match.params[i].name) free(match.params[i].name);
-            if (match.params[i].value) free(match.params[i].value);
+        for (int i = 0; i < param_idx; i++) {
+            route_release(arena, match.params[i].name);
+            route_release(arena, match.params[i].value);
         }
-        free(match.params);
+        route_release(arena, match.params);
         match.params = NULL;
     }
     if (match.wildcard_path) {
-        free(match.wildcard_path);
+        route_release(arena, match.wildcard_path);
         match.wildcard_path = NULL;
     }
     match.matched = 0;
@@ -519,17 +524,193 @@ no_match:
     
 cleanup:
     // Free path segments
-    for (int i = 0; i < path_segment_count; i++) {
-        free(path_segments[i]);
+    if (!arena) {
+        for (int i = 0; i < path_segment_count; i++) {
+            free(path_segments[i]);
+        }
+        free(path_segments);
     }
-    free(path_segments);
     
     return match;
 }
 
+// Step to the next segment of `path` after *pos, without copying it.
+// Segments come out exactly as split_path_segments would produce them.
+int path_next_segment(const char *path, size_t *pos, const char **segment, size_t *length) {
+    // The root path is a single empty segment
+    if (*pos == 0 && path[0] == '/' && path[1] == '\0') {
+        *segment = path + 1;
+        *length = 0;
+        *pos = 1;
+        return 1;
+    }
+    
+    size_t i = *pos;
+    while (path[i] == '/') i++;
+    if (path[i] == '\0') {
+        *pos = i;
+        return 0;
+    }
+    
+    size_t start = i;
+    while (path[i] && path[i] != '/') i++;
+    *segment = path + start;
+    *length = i - start;
+    *pos = i;
+    return 1;
+}
+
+// Character classes for the typed parameters, independent of the locale
+static int route_is_digit(unsigned char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int route_is_blank(unsigned char c) {
+    return c == ' ' || c == '\t';
+}
+
+static int route_is_hex(unsigned char c) {
+    return route_is_digit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+static int route_is_slug(unsigned char c) {
+    return route_is_digit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '-' || c == '_';
+}
+
+// Validate a parameter value held in `length` bytes (not terminated)
+int validate_parameter_slice(const char *value, size_t length, ParameterType type) {
+    switch (type) {
+        case PARAM_NUMBER: {
+            // What strtol accepts in full: optional blanks (space, tab) and
+            // sign, then digits; an empty value converts nothing and is accepted
+            if (length == 0) return 1;
+            size_t i = 0;
+            while (i < length && route_is_blank((unsigned char)value[i])) i++;
+            if (i < length && (value[i] == '+' || value[i] == '-')) i++;
+            if (i == length) return 0;
+            for (; i < length; i++) {
+                if (!route_is_digit((unsigned char)value[i])) return 0;
+            }
+            return 1;
+        }
+        
+        case PARAM_SLUG:
+            // Slug: alphanumeric, hyphens, underscores
+            for (size_t i = 0; i < length; i++) {
+                if (!route_is_slug((unsigned char)value[i])) return 0;
+            }
+            return length > 0;
+        
+        case PARAM_UUID:
+            // 8-4-4-4-12 hex digits
+            if (length != 36) return 0;
+            for (size_t i = 0; i < length; i++) {
+                if (i == 8 || i == 13 || i == 18 || i == 23) {
+                    if (value[i] != '-') return 0;
+                } else if (!route_is_hex((unsigned char)value[i])) {
+                    return 0;
+                }
+            }
+            return 1;
+        
+        case PARAM_STRING:
+        case PARAM_ANY:
+        default:
+            return length > 0;
+    }
+}
+
+// Match path against compiled route pattern, writing parameters as slices
+// of `path`; follows route_pattern_match_in segment for segment
+int route_pattern_match_slices(const RoutePattern *pattern, const char *path, ParamSlice *slices, int max_slices) {
+    if (!pattern || !path) return -1;
+    
+    size_t pos = 0;
+    const char *segment = NULL;
+    size_t length = 0;
+    int have = path_next_segment(path, &pos, &segment, &length);
+    int captured = 0;
+    
+    for (int pattern_idx = 0; pattern_idx < pattern->segment_count; pattern_idx++) {
+        const RouteSegment *seg = &pattern->segments[pattern_idx];
+        
+        switch (seg->type) {
+            case SEGMENT_LITERAL:
+                if (!have || strncmp(seg->literal_value, segment, length) != 0 ||
+                    seg->literal_value[length] != '\0') {
+                    return -1;
+                }
+                break;
+            
+            case SEGMENT_PARAMETER:
+            case SEGMENT_OPTIONAL:
+                if (!have || !validate_parameter_slice(segment, length, seg->param->type)) {
+                    // A missing or invalid optional parameter is skipped
+                    if (seg->type == SEGMENT_OPTIONAL) continue;
+                    return -1;
+                }
+                if (captured < max_slices) {
+                    slices[captured].name = seg->param->name;
+                    slices[captured].value = segment;
+                    slices[captured].length = length;
+                }
+                captured++;
+                break;
+            
+            case SEGMENT_WILDCARD:
+                // Wildcard matches everything remaining
+                have = 0;
+                continue;
+        }
+        have = path_next_segment(path, &pos, &segment, &length);
+    }
+    
+    if (have && !pattern->has_wildcards) return -1;
+    DEBUG_PRINT("route_pattern_match_slices: '%s' matched '%s' with %d parameters\n",
+           path, pattern->original_pattern, captured);
+    return captured;
+}
+
+int route_pattern_matches(const RoutePattern *pattern, const char *path) {
+    if (!pattern || !path) return 0;
+    if (pattern->is_static) return strcmp(pattern->original_pattern, path) == 0;
+    return route_pattern_match_slices(pattern, path, NULL, 0) >= 0;
+}
+
+// Check slices captured by route_pattern_match_slices against their
+// parameters' constraints. Only constrained values need terminating, so
+// only those are copied.
+int validate_route_slices(const RoutePattern *pattern, const ParamSlice *slices, int count, Arena *arena) {
+    int slice_idx = 0;
+    
+    for (int i = 0; i < pattern->segment_count && slice_idx < count; i++) {
+        const RouteParam *param = pattern->segments[i].param;
+        if (!param || slices[slice_idx].name != param->name) continue;
+        
+        const ParamSlice *slice = &slices[slice_idx++];
+        if (!param->constraints) continue;
+        
+        char *value = arena ? arena_strndup(arena, slice->value, slice->length)
+                            : strndup(slice->value, slice->length);
+        if (!value) return 0;
+        
+        RouteParam checked = *param;
+        checked.value = value;
+        ValidationError error = {0};
+        int valid = validate_parameter_constraints(&checked, &error);
+        if (!valid) {
+            DEBUG_PRINT("validate_route_slices: '%s' failed its constraints\n", param->name);
+            free_validation_error(&error);
+        }
+        route_release(arena, value);
+        if (!valid) return 0;
+    }
+    return 1;
+}
+
 // Free route pattern
 void free_route_pattern(RoutePattern *pattern) {
-    if (!pattern) return;
+    if (!pattern || pattern->in_snapshot) return;
     
     free(pattern->original_pattern);
     
@@ -545,6 +726,7 @@ void free_route_pattern(RoutePattern *pattern) {
             if (seg->param->value) {
                 free(seg->param->value);
             }
+            free_constraint(seg->param->constraints);
             free(seg->param);
         }
     }
@@ -555,7 +737,7 @@ void free_route_pattern(RoutePattern *pattern) {
 
 // Free route match
 void free_route_match(RouteMatch *match) {
-    if (!match) return;
+    if (!match || match->arena) return;
     
     if (match->params) {
         for (int i = 0; i < match->param_count; i++) {
@@ -572,34 +754,40 @@ void free_route_match(RouteMatch *match) {
 
 // Helper function to duplicate a RouteMatch structure
 RouteMatch* duplicate_route_match(const RouteMatch* original) {
+    return duplicate_route_match_in(original, NULL);
+}
+
+RouteMatch* duplicate_route_match_in(const RouteMatch* original, Arena *arena) {
     if (!original || !original->matched) return NULL;
     
-    RouteMatch* copy = malloc(sizeof(RouteMatch));
+    RouteMatch* copy = route_alloc(arena, sizeof(RouteMatch));
     if (!copy) return NULL;
     
     copy->matched = original->matched;
     copy->param_count = original->param_count;
+    copy->arena = arena;
     
     // Duplicate parameters
     if (original->param_count > 0 && original->params) {
-        copy->params = malloc(original->param_count * sizeof(RouteParam));
+        copy->params = route_alloc(arena, original->param_count * sizeof(RouteParam));
         if (!copy->params) {
-            free(copy);
+            route_release(arena, copy);
             return NULL;
         }
         
         for (int i = 0; i < original->param_count; i++) {
-            copy->params[i].name = original->params[i].name ? strdup(original->params[i].name) : NULL;
-            copy->params[i].value = original->params[i].value ? strdup(original->params[i].value) : NULL;
+            copy->params[i].name = original->params[i].name ? route_strdup(arena, original->params[i].name) : NULL;
+            copy->params[i].value = original->params[i].value ? route_strdup(arena, original->params[i].value) : NULL;
             copy->params[i].type = original->params[i].type;
             copy->params[i].is_optional = original->params[i].is_optional;
+            copy->params[i].constraints = original->params[i].constraints;
         }
     } else {
         copy->params = NULL;
     }
     
     // Duplicate wildcard path
-    copy->wildcard_path = original->wildcard_path ? strdup(original->wildcard_path) : NULL;
+    copy->wildcard_path = original->wildcard_path ? route_strdup(arena, original->wildcard_path) : NULL;
     
     return copy;
 }
@@ -614,6 +802,8 @@ RouteConstraint* create_min_constraint(long min_value, const char *error_msg) {
     constraint->constraint.range.max_value = 0; // Not used for MIN
     constraint->error_message = error_msg ? strdup(error_msg) : strdup("Value is too small");
     constraint->context = NULL;
+    constraint->compiled_regex = NULL;
+    constraint->regex_deferred = 0;
     constraint->next = NULL;
     
     return constraint;
@@ -628,6 +818,8 @@ RouteConstraint* create_max_constraint(long max_value, const char *error_msg) {
     constraint->constraint.range.max_value = max_value;
     constraint->error_message = error_msg ? strdup(error_msg) : strdup("Value is too large");
     constraint->context = NULL;
+    constraint->compiled_regex = NULL;
+    constraint->regex_deferred = 0;
     constraint->next = NULL;
     
     return constraint;
@@ -642,6 +834,8 @@ RouteConstraint* create_range_constraint(long min_value, long max_value, const c
     constraint->constraint.range.max_value = max_value;
     constraint->error_message = error_msg ? strdup(error_msg) : strdup("Value is out of range");
     constraint->context = NULL;
+    constraint->compiled_regex = NULL;
+    constraint->regex_deferred = 0;
     constraint->next = NULL;
     
     return constraint;
@@ -655,8 +849,17 @@ RouteConstraint* create_regex_constraint(const char *pattern, const char *error_
     constraint->constraint.regex_pattern = strdup(pattern);
     constraint->error_message = error_msg ? strdup(error_msg) : strdup("Invalid format");
     constraint->context = NULL;
+    constraint->regex_deferred = 0;
     constraint->next = NULL;
     
+    // Compile once here; requests only run regexec
+    constraint->compiled_regex = malloc(sizeof(regex_t));
+    if (constraint->compiled_regex && regcomp(constraint->compiled_regex, pattern, REG_EXTENDED | REG_NOSUB) != 0) {
+        ERROR_PRINT("create_regex_constraint: invalid pattern '%s'\n", pattern);
+        free(constraint->compiled_regex);
+        constraint->compiled_regex = NULL;
+    }
+    
     return constraint;
 }
 
@@ -678,6 +881,8 @@ RouteConstraint* create_enum_constraint(const char **values, const char *error_m
     constraint->type = CONSTRAINT_ENUM;
     constraint->error_message = error_msg ? strdup(error_msg) : strdup("Invalid value");
     constraint->context = NULL;
+    constraint->compiled_regex = NULL;
+    constraint->regex_deferred = 0;
     constraint->next = NULL;
     
     return constraint;
@@ -691,6 +896,8 @@ RouteConstraint* create_custom_constraint(CustomValidator validator, void *conte
     constraint->constraint.validator = validator;
     constraint->error_message = error_msg ? strdup(error_msg) : strdup("Validation failed");
     constraint->context = context;
+    constraint->compiled_regex = NULL;
+    constraint->regex_deferred = 0;
     constraint->next = NULL;
     
     return constraint;
@@ -712,6 +919,30 @@ void add_parameter_constraint(RouteParam *param, RouteConstraint *constraint) {
     }
 }
 
+// A regex constraint's compiled form. Those mapped from a route snapshot
+// are compiled by the first request that needs them; a thread losing the
+// race frees its copy.
+static regex_t *constraint_regex(RouteConstraint *constraint) {
+    regex_t *compiled = __atomic_load_n(&constraint->compiled_regex, __ATOMIC_ACQUIRE);
+    if (compiled || !constraint->regex_deferred) return compiled;
+
+    compiled = malloc(sizeof(regex_t));
+    if (!compiled) return NULL;
+    if (regcomp(compiled, constraint->constraint.regex_pattern, REG_EXTENDED | REG_NOSUB) != 0) {
+        ERROR_PRINT("constraint_regex: invalid pattern '%s'\n", constraint->constraint.regex_pattern);
+        free(compiled);
+        return NULL;
+    }
+    regex_t *published = NULL;
+    if (!__atomic_compare_exchange_n(&constraint->compiled_regex, &published, compiled, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        regfree(compiled);
+        free(compiled);
+        return published;
+    }
+    return compiled;
+}
+
 // Validate parameter against its constraints
 int validate_parameter_constraints(const RouteParam *param, ValidationError *error) {
     if (!param || !param->constraints) return 1; // No constraints = valid
@@ -758,15 +989,9 @@ int validate_parameter_constraints(const RouteParam *param, ValidationError *err
             }
             
             case CONSTRAINT_REGEX: {
-                regex_t regex;
-                int ret = regcomp(&regex, constraint->constraint.regex_pattern, REG_EXTENDED);
-                if (ret == 0) {
-                    ret = regexec(&regex, param->value, 0, NULL, 0);
-                    valid = (ret == 0);
-                    regfree(&regex);
-                } else {
-                    valid = 0; // Invalid regex = fail
-                }
+                // Invalid regex = fail
+                regex_t *compiled = constraint_regex(constraint);
+                valid = compiled && regexec(compiled, param->value, 0, NULL, 0) == 0;
                 break;
             }
             
@@ -815,26 +1040,31 @@ int validate_route_match(const RouteMatch *match, ValidationError **errors, int
     
     if (match->param_count == 0) return 1;
     
-    // Allocate array for potential errors
-    ValidationError *error_array = malloc(match->param_count * sizeof(ValidationError));
+    // The error array is only allocated once something fails
+    ValidationError *error_array = NULL;
     int actual_errors = 0;
     
     for (int i = 0; i < match->param_count; i++) {
         ValidationError error = {0};
         if (!validate_parameter_constraints(&match->params[i], &error)) {
+            if (!error_array) {
+                error_array = malloc(match->param_count * sizeof(ValidationError));
+                if (!error_array) {
+                    free_validation_error(&error);
+                    return 0;
+                }
+            }
             error_array[actual_errors] = error;
             actual_errors++;
         }
     }
     
     if (actual_errors > 0) {
-        *errors = realloc(error_array, actual_errors * sizeof(ValidationError));
+        *errors = error_array;
         *error_count = actual_errors;
         return 0;
-    } else {
-        free(error_array);
-        return 1;
     }
+    return 1;
 }
 
 // Free constraint
@@ -848,6 +1078,10 @@ void free_constraint(RouteConstraint *constraint) {
     switch (constraint->type) {
         case CONSTRAINT_REGEX:
             free(constraint->constraint.regex_pattern);
+            if (constraint->compiled_regex) {
+                regfree(constraint->compiled_regex);
+                free(constraint->compiled_regex);
+            }
             break;
         case CONSTRAINT_ENUM:
             for (int i = 0; constraint->constraint.enum_values[i]; i++) {
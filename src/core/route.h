@@ -2,6 +2,7 @@
 #define ROUTE_H
 
 #include "layer.h"
+#include <regex.h>
 
 // Route parameter types
 typedef enum {
@@ -45,6 +46,8 @@ typedef struct RouteConstraint {
         char **enum_values;      // NULL-terminated array
         CustomValidator validator;
     } constraint;
+    regex_t *compiled_regex;     // CONSTRAINT_REGEX: compiled at creation (NULL if invalid)
+    int regex_deferred;          // From a route snapshot: compiled_regex is built on first use
     char *error_message;         // Custom error message
     void *context;              // Context for custom validators
     struct RouteConstraint *next; // For constraint chaining
@@ -82,6 +85,8 @@ typedef struct {
     int priority;         // Lower number = higher priority
     int has_wildcards;
     int param_count;
+    int is_static;        // Written without ':' or '*': matched by exact string compare
+    int in_snapshot;      // Mapped from a route snapshot (route_snapshot.h): freed with it
 } RoutePattern;
 
 // Route matching result
@@ -90,6 +95,7 @@ typedef struct {
     RouteParam *params;
     int param_count;
     char *wildcard_path;  // Captured wildcard portion
+    Arena *arena;         // Owner of params and wildcard_path (NULL = heap)
 } RouteMatch;
 
 // Route metadata structures
@@ -138,7 +144,24 @@ RouteMatch route_pattern_match(RoutePattern *pattern, const char *path);
 void free_route_pattern(RoutePattern *pattern);
 void free_route_match(RouteMatch *match);
 RouteMatch* duplicate_route_match(const RouteMatch* original);
+
+// Arena variants: results live until the arena is reset and need no freeing
+char **split_path_segments_in(const char *path, int *count, Arena *arena);
+RouteMatch route_pattern_match_in(RoutePattern *pattern, const char *path, Arena *arena);
+RouteMatch* duplicate_route_match_in(const RouteMatch* original, Arena *arena);
 int validate_parameter_value(const char *value, ParameterType type);
+
+// Allocation-free matching: the path is walked in place and each captured
+// parameter is written to `slices` (up to max_slices). Returns how many
+// parameters the pattern captured, or -1 when the path does not match.
+int route_pattern_match_slices(const RoutePattern *pattern, const char *path, ParamSlice *slices, int max_slices);
+// Does `path` match? Static patterns compare the whole string, others match
+// segment by segment like route_pattern_match_slices
+int route_pattern_matches(const RoutePattern *pattern, const char *path);
+int validate_route_slices(const RoutePattern *pattern, const ParamSlice *slices, int count, Arena *arena);
+int validate_parameter_slice(const char *value, size_t length, ParameterType type);
+// Next segment of `path` from *pos as a slice; returns 0 past the last one
+int path_next_segment(const char *path, size_t *pos, const char **segment, size_t *length);
 int calculate_route_priority(RoutePattern *pattern);
 
 // Constraint and validation functions
@@ -0,0 +1,216 @@
+#define _GNU_SOURCE
+#include "route_cache.h"
+#include "../debug.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct {
+    RouteCacheResult result;
+    unsigned long hash;
+    int bucket_next;             // Next entry in the same bucket, or -1
+    int lru_prev, lru_next;      // Towards the most / least recently used
+    int table;
+    HttpMethod method;
+    size_t path_len;
+    char path[ROUTE_CACHE_MAX_PATH];
+} RouteCacheEntry;
+
+struct RouteCacheShard {
+    // Read by route_cache_stats on other threads; only the owner writes them
+    unsigned long generation;
+    unsigned long hits;
+    unsigned long misses;
+
+    int capacity;
+    int count;
+    unsigned long bucket_mask;
+    int *buckets;                // Entry heading each chain, or -1
+    RouteCacheEntry *entries;
+    int lru_head, lru_tail;      // Most and least recently used
+    struct RouteCacheShard *prev, *next;  // Every live shard, for the stats
+};
+
+static __thread RouteCacheShard *thread_shard = NULL;
+static unsigned long generation_counter = 0;
+
+// Registry of every thread's shard; a shard leaves it when its thread exits
+static RouteCacheShard *shards = NULL;
+static pthread_mutex_t shards_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t shard_key;
+static pthread_once_t shard_once = PTHREAD_ONCE_INIT;
+
+static void shard_release(void *value) {
+    RouteCacheShard *shard = (RouteCacheShard *)value;
+    pthread_mutex_lock(&shards_lock);
+    if (shard->prev) shard->prev->next = shard->next;
+    else shards = shard->next;
+    if (shard->next) shard->next->prev = shard->prev;
+    pthread_mutex_unlock(&shards_lock);
+    free(shard->buckets);
+    free(shard->entries);
+    free(shard);
+    thread_shard = NULL;
+}
+
+static void shard_key_create(void) {
+    pthread_key_create(&shard_key, shard_release);
+}
+
+unsigned long route_cache_next_generation(void) {
+    return __atomic_add_fetch(&generation_counter, 1, __ATOMIC_RELAXED);
+}
+
+static unsigned long route_cache_hash(int table, HttpMethod method, const char *path, size_t path_len) {
+    // FNV-1a
+    unsigned long hash = (14695981039346656037UL ^ (unsigned long)method) + ((unsigned long)table << 8);
+    for (size_t i = 0; i < path_len; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+// Empty the shard for another generation, resizing it if needed
+static int shard_reset(RouteCacheShard *shard, unsigned long generation, int capacity) {
+    if (shard->capacity != capacity) {
+        unsigned long bucket_count = 1;
+        while (bucket_count < (unsigned long)capacity * 2) bucket_count <<= 1;
+        int *buckets = malloc(bucket_count * sizeof(int));
+        RouteCacheEntry *entries = malloc(capacity * sizeof(RouteCacheEntry));
+        if (!buckets || !entries) {
+            free(buckets);
+            free(entries);
+            return -1;
+        }
+        free(shard->buckets);
+        free(shard->entries);
+        shard->buckets = buckets;
+        shard->entries = entries;
+        shard->capacity = capacity;
+        shard->bucket_mask = bucket_count - 1;
+    }
+    memset(shard->buckets, 0xff, (shard->bucket_mask + 1) * sizeof(int));
+    shard->count = 0;
+    shard->lru_head = shard->lru_tail = -1;
+    __atomic_store_n(&shard->hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&shard->misses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&shard->generation, generation, __ATOMIC_RELAXED);
+    return 0;
+}
+
+RouteCacheShard *route_cache_shard(unsigned long generation, int capacity) {
+    RouteCacheShard *shard = thread_shard;
+    if (shard && shard->generation == generation) return shard;
+
+    if (!shard) {
+        shard = calloc(1, sizeof(RouteCacheShard));
+        if (!shard) return NULL;
+        pthread_once(&shard_once, shard_key_create);
+        pthread_mutex_lock(&shards_lock);
+        shard->next = shards;
+        if (shards) shards->prev = shard;
+        shards = shard;
+        pthread_mutex_unlock(&shards_lock);
+        pthread_setspecific(shard_key, shard);
+        thread_shard = shard;
+    }
+    DEBUG_PRINT("route_cache_shard: generation %lu, %d entries\n", generation, capacity);
+    if (shard_reset(shard, generation, capacity) != 0) {
+        // Never matches a generation, so the next request tries again
+        __atomic_store_n(&shard->generation, 0, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    return shard;
+}
+
+static void lru_unlink(RouteCacheShard *shard, int index) {
+    RouteCacheEntry *entry = &shard->entries[index];
+    if (entry->lru_prev >= 0) shard->entries[entry->lru_prev].lru_next = entry->lru_next;
+    else shard->lru_head = entry->lru_next;
+    if (entry->lru_next >= 0) shard->entries[entry->lru_next].lru_prev = entry->lru_prev;
+    else shard->lru_tail = entry->lru_prev;
+}
+
+static void lru_push_front(RouteCacheShard *shard, int index) {
+    RouteCacheEntry *entry = &shard->entries[index];
+    entry->lru_prev = -1;
+    entry->lru_next = shard->lru_head;
+    if (shard->lru_head >= 0) shard->entries[shard->lru_head].lru_prev = index;
+    shard->lru_head = index;
+    if (shard->lru_tail < 0) shard->lru_tail = index;
+}
+
+const RouteCacheResult *route_cache_get(RouteCacheShard *shard, int table, HttpMethod method, const char *path,
+                                        size_t path_len) {
+    if (path_len <= ROUTE_CACHE_MAX_PATH) {
+        unsigned long hash = route_cache_hash(table, method, path, path_len);
+        for (int i = shard->buckets[hash & shard->bucket_mask]; i >= 0; i = shard->entries[i].bucket_next) {
+            RouteCacheEntry *entry = &shard->entries[i];
+            if (entry->hash == hash && entry->table == table && entry->method == method && entry->path_len == path_len &&
+                memcmp(entry->path, path, path_len) == 0) {
+                if (shard->lru_head != i) {
+                    lru_unlink(shard, i);
+                    lru_push_front(shard, i);
+                }
+                __atomic_store_n(&shard->hits, shard->hits + 1, __ATOMIC_RELAXED);
+                return &entry->result;
+            }
+        }
+    }
+    __atomic_store_n(&shard->misses, shard->misses + 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+void route_cache_put(RouteCacheShard *shard, int table, HttpMethod method, const char *path, size_t path_len,
+                     int route, unsigned int allowed, const ParamSlice *slices, int slice_count) {
+    if (path_len > ROUTE_CACHE_MAX_PATH || slice_count > ROUTE_CACHE_MAX_SLICES) return;
+    for (int i = 0; i < slice_count; i++) {
+        if (slices[i].value < path || slices[i].value + slices[i].length > path + path_len) return;
+    }
+
+    int index;
+    if (shard->count < shard->capacity) {
+        index = shard->count++;
+    } else {
+        // Evict the least recently used entry
+        index = shard->lru_tail;
+        RouteCacheEntry *old = &shard->entries[index];
+        int *link = &shard->buckets[old->hash & shard->bucket_mask];
+        while (*link != index) link = &shard->entries[*link].bucket_next;
+        *link = old->bucket_next;
+        lru_unlink(shard, index);
+    }
+
+    RouteCacheEntry *entry = &shard->entries[index];
+    entry->hash = route_cache_hash(table, method, path, path_len);
+    entry->table = table;
+    entry->method = method;
+    entry->path_len = path_len;
+    memcpy(entry->path, path, path_len);
+    entry->result.route = route;
+    entry->result.allowed = allowed;
+    entry->result.slice_count = slice_count;
+    for (int i = 0; i < slice_count; i++) {
+        entry->result.slices[i].name = slices[i].name;
+        entry->result.slices[i].offset = (unsigned short)(slices[i].value - path);
+        entry->result.slices[i].length = (unsigned short)slices[i].length;
+    }
+
+    int *bucket = &shard->buckets[entry->hash & shard->bucket_mask];
+    entry->bucket_next = *bucket;
+    *bucket = index;
+    lru_push_front(shard, index);
+}
+
+void route_cache_stats(unsigned long generation, RouteCacheStats *stats) {
+    stats->hits = 0;
+    stats->misses = 0;
+    pthread_mutex_lock(&shards_lock);
+    for (RouteCacheShard *shard = shards; shard; shard = shard->next) {
+        if (__atomic_load_n(&shard->generation, __ATOMIC_RELAXED) != generation) continue;
+        stats->hits += __atomic_load_n(&shard->hits, __ATOMIC_RELAXED);
+        stats->misses += __atomic_load_n(&shard->misses, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&shards_lock);
+}
@@ -0,0 +1,52 @@
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include <stddef.h>
+#include "../http/request.h"
+
+#define ROUTE_CACHE_MAX_PATH 128     // Longer paths are looked up every time
+#define ROUTE_CACHE_MAX_SLICES 8     // As are routes capturing more parameters
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+} RouteCacheStats;
+
+// A parameter as its place in the cached path
+typedef struct {
+    const char *name;
+    unsigned short offset;
+    unsigned short length;
+} RouteCacheSlice;
+
+// The outcome of one (method, path) lookup
+typedef struct {
+    int route;               // FrozenLayer of the route, or -1 for none
+    unsigned int allowed;    // Methods for the 405 when there is none
+    int slice_count;
+    RouteCacheSlice slices[ROUTE_CACHE_MAX_SLICES];
+} RouteCacheResult;
+
+// One thread's cache: only that thread reads and writes it, so lookups
+// take no lock. Shards are tied to the generation of the frozen router
+// they were filled from and start over when a new one is dispatched.
+typedef struct RouteCacheShard RouteCacheShard;
+
+// Routers get a new generation each time they are frozen
+unsigned long route_cache_next_generation(void);
+
+// The calling thread's shard for `generation`, emptied (and resized to
+// `capacity` entries) when it last served another; NULL when out of memory
+RouteCacheShard *route_cache_shard(unsigned long generation, int capacity);
+// The cached outcome for the request, or NULL (counted as a miss).
+// `table` tells apart the tables of one generation (a virtual host's).
+const RouteCacheResult *route_cache_get(RouteCacheShard *shard, int table, HttpMethod method, const char *path,
+                                        size_t path_len);
+// Remember an outcome, evicting the least recently used entry when full.
+// The slices must point into `path`.
+void route_cache_put(RouteCacheShard *shard, int table, HttpMethod method, const char *path, size_t path_len,
+                     int route, unsigned int allowed, const ParamSlice *slices, int slice_count);
+// Hits and misses summed over every thread's shard for `generation`
+void route_cache_stats(unsigned long generation, RouteCacheStats *stats);
+
+#endif
@@ -0,0 +1,467 @@
+#define _GNU_SOURCE
+#include "route_snapshot.h"
+#include "router.h"
+#include "../debug.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SNAPSHOT_MAGIC "CXROUTES"
+#define SNAPSHOT_ALIGN 8             // Enough for every struct in the image
+#define SNAPSHOT_MAX_MOUNT_DEPTH 16
+
+// At the start of the file. Offsets are from the start of the file; the
+// image (the patterns) follows the header, then the tables below.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t layout;         // snapshot_layout() of the writer
+    uint64_t hash;           // snapshot_hash of everything after the header
+    uint64_t size;           // Of the whole file, a multiple of 8
+    uint64_t index;          // index_slots pattern offsets by path hash (0: free slot)
+    uint64_t relocs;         // Offsets of the pointers in the image
+    uint64_t regexes;        // Offsets of the regex constraints to free on close
+    uint32_t index_slots;    // A power of two
+    uint32_t pattern_count;
+    uint32_t reloc_count;
+    uint32_t regex_count;
+} SnapshotHeader;
+
+struct RouteSnapshot {
+    unsigned char *base;
+    size_t size;
+    const SnapshotHeader *header;
+    const uint64_t *index;
+};
+
+// An image under construction: everything is addressed by offset, as the
+// buffer moves while it grows
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    uint64_t *relocs;
+    size_t reloc_count;
+    size_t reloc_capacity;
+    uint64_t *regexes;
+    size_t regex_count;
+    size_t regex_capacity;
+    int failed;
+} SnapshotWriter;
+
+#define AT(w, offset, type) ((type *)((w)->data + (offset)))
+
+// The image is only valid for the struct layout that wrote it
+static uint32_t snapshot_layout(void) {
+    const size_t sizes[] = {
+        sizeof(void *), sizeof(long), sizeof(RoutePattern), sizeof(RouteSegment), sizeof(RouteParam),
+        sizeof(RouteConstraint), offsetof(RoutePattern, in_snapshot), offsetof(RouteConstraint, regex_deferred),
+        offsetof(RouteConstraint, next)
+    };
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        hash = (hash ^ (uint32_t)sizes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Checked over the whole file on every open, so eight bytes at a time in
+// four independent lanes
+static uint64_t snapshot_hash(const unsigned char *data, size_t size) {
+    uint64_t lanes[4] = { 14695981039346656037ull, 1, 2, 3 };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t word;
+            memcpy(&word, data + i + l * 8, sizeof(word));
+            lanes[l] = (lanes[l] ^ word) * 1099511628211ull;
+            lanes[l] ^= lanes[l] >> 29;
+        }
+    }
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        lanes[0] = (lanes[0] ^ word) * 1099511628211ull;
+    }
+    uint64_t hash = 0;
+    for (int l = 0; l < 4; l++) hash = (hash ^ lanes[l]) * 1099511628211ull ^ (hash >> 31);
+    return hash;
+}
+
+static uint64_t path_hash(const char *path) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        hash = (hash ^ *p) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static int offsets_push(uint64_t **items, size_t *count, size_t *capacity, uint64_t value) {
+    if (*count == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 256;
+        uint64_t *grown = realloc(*items, new_capacity * sizeof(uint64_t));
+        if (!grown) return -1;
+        *items = grown;
+        *capacity = new_capacity;
+    }
+    (*items)[(*count)++] = value;
+    return 0;
+}
+
+// Zeroed room for `size` bytes aligned to `align` (a power of two); 0 once
+// out of memory
+static uint64_t image_place(SnapshotWriter *w, size_t size, size_t align) {
+    if (w->failed) return 0;
+    size_t offset = (w->size + align - 1) & ~(align - 1);
+    if (offset + size > w->capacity) {
+        size_t new_capacity = w->capacity ? w->capacity : 4096;
+        while (offset + size > new_capacity) new_capacity *= 2;
+        unsigned char *grown = realloc(w->data, new_capacity);
+        if (!grown) {
+            w->failed = 1;
+            return 0;
+        }
+        w->data = grown;
+        w->capacity = new_capacity;
+    }
+    memset(w->data + w->size, 0, offset + size - w->size);
+    w->size = offset + size;
+    return offset;
+}
+
+static uint64_t image_alloc(SnapshotWriter *w, size_t size) {
+    return image_place(w, size, SNAPSHOT_ALIGN);
+}
+
+static uint64_t image_string(SnapshotWriter *w, const char *str) {
+    if (!str) return 0;
+    size_t length = strlen(str) + 1;
+    uint64_t offset = image_place(w, length, 1);
+    if (offset) memcpy(w->data + offset, str, length);
+    return offset;
+}
+
+// Point the pointer at `slot` to `target` (NULL when 0), to be relocated
+// when the file is mapped
+static void image_pointer(SnapshotWriter *w, uint64_t slot, uint64_t target) {
+    if (w->failed || !target) return;
+    uintptr_t value = (uintptr_t)target;
+    memcpy(w->data + slot, &value, sizeof(value));
+    if (offsets_push(&w->relocs, &w->reloc_count, &w->reloc_capacity, slot) < 0) w->failed = 1;
+}
+
+static uint64_t write_constraints(SnapshotWriter *w, const RouteConstraint *constraint) {
+    uint64_t first = 0, link = 0;
+    for (; constraint; constraint = constraint->next) {
+        uint64_t offset = image_alloc(w, sizeof(RouteConstraint));
+        if (!offset) return 0;
+        AT(w, offset, RouteConstraint)->type = constraint->type;
+
+        switch (constraint->type) {
+            case CONSTRAINT_REGEX:
+                image_pointer(w, offset + offsetof(RouteConstraint, constraint.regex_pattern),
+                              image_string(w, constraint->constraint.regex_pattern));
+                // An invalid regex stays uncompiled, and fails every value
+                if (constraint->compiled_regex) {
+                    AT(w, offset, RouteConstraint)->regex_deferred = 1;
+                    if (offsets_push(&w->regexes, &w->regex_count, &w->regex_capacity, offset) < 0) w->failed = 1;
+                }
+                break;
+            case CONSTRAINT_ENUM: {
+                int count = 0;
+                while (constraint->constraint.enum_values[count]) count++;
+                uint64_t values = image_alloc(w, (count + 1) * sizeof(char *));
+                for (int i = 0; i < count && values; i++) {
+                    image_pointer(w, values + i * sizeof(char *), image_string(w, constraint->constraint.enum_values[i]));
+                }
+                image_pointer(w, offset + offsetof(RouteConstraint, constraint.enum_values), values);
+                break;
+            }
+            default:
+                AT(w, offset, RouteConstraint)->constraint.range = constraint->constraint.range;
+                break;
+        }
+        image_pointer(w, offset + offsetof(RouteConstraint, error_message), image_string(w, constraint->error_message));
+
+        if (link) image_pointer(w, link, offset);
+        else first = offset;
+        link = offset + offsetof(RouteConstraint, next);
+    }
+    return first;
+}
+
+static uint64_t write_pattern(SnapshotWriter *w, const RoutePattern *pattern) {
+    uint64_t offset = image_alloc(w, sizeof(RoutePattern));
+    if (!offset) return 0;
+    RoutePattern *copy = AT(w, offset, RoutePattern);
+    copy->segment_count = pattern->segment_count;
+    copy->priority = pattern->priority;
+    copy->has_wildcards = pattern->has_wildcards;
+    copy->param_count = pattern->param_count;
+    copy->is_static = pattern->is_static;
+    copy->in_snapshot = 1;
+    image_pointer(w, offset + offsetof(RoutePattern, original_pattern), image_string(w, pattern->original_pattern));
+    if (pattern->segment_count == 0) return offset;
+
+    uint64_t segments = image_alloc(w, pattern->segment_count * sizeof(RouteSegment));
+    for (int i = 0; i < pattern->segment_count && segments; i++) {
+        const RouteSegment *seg = &pattern->segments[i];
+        uint64_t slot = segments + i * sizeof(RouteSegment);
+        AT(w, slot, RouteSegment)->type = seg->type;
+        image_pointer(w, slot + offsetof(RouteSegment, literal_value), image_string(w, seg->literal_value));
+        if (!seg->param) continue;
+
+        uint64_t param = image_alloc(w, sizeof(RouteParam));
+        if (!param) return 0;
+        AT(w, param, RouteParam)->type = seg->param->type;
+        AT(w, param, RouteParam)->is_optional = seg->param->is_optional;
+        image_pointer(w, param + offsetof(RouteParam, name), image_string(w, seg->param->name));
+        image_pointer(w, param + offsetof(RouteParam, constraints), write_constraints(w, seg->param->constraints));
+        image_pointer(w, slot + offsetof(RouteSegment, param), param);
+    }
+    image_pointer(w, offset + offsetof(RoutePattern, segments), segments);
+    return offset;
+}
+
+// Custom validators are code: a pattern using one is compiled every time
+static int pattern_storable(const RoutePattern *pattern) {
+    for (int i = 0; i < pattern->segment_count; i++) {
+        const RouteParam *param = pattern->segments[i].param;
+        for (const RouteConstraint *c = param ? param->constraints : NULL; c; c = c->next) {
+            if (c->type == CONSTRAINT_CUSTOM) return 0;
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    const RoutePattern **items;
+    size_t count;
+    size_t capacity;
+} PatternList;
+
+static int collect_patterns(Router *router, PatternList *list, int depth) {
+    if (depth > SNAPSHOT_MAX_MOUNT_DEPTH) return 0;
+    for (int i = 0; i < router->layer_count; i++) {
+        Layer *layer = &router->layers[i];
+        if (layer->type == LAYER_ROUTER) {
+            if (collect_patterns(layer->data.router, list, depth + 1) < 0) return -1;
+            continue;
+        }
+        const RoutePattern *pattern = layer->pattern;
+        if (!pattern || !pattern_storable(pattern)) continue;
+        if (list->count == list->capacity) {
+            size_t new_capacity = list->capacity ? list->capacity * 2 : 64;
+            const RoutePattern **grown = realloc(list->items, new_capacity * sizeof(*grown));
+            if (!grown) return -1;
+            list->items = grown;
+            list->capacity = new_capacity;
+        }
+        list->items[list->count++] = pattern;
+    }
+    return 0;
+}
+
+static int compare_patterns(const void *a, const void *b) {
+    return strcmp((*(const RoutePattern *const *)a)->original_pattern,
+                  (*(const RoutePattern *const *)b)->original_pattern);
+}
+
+// Append an array of offsets to the image
+static uint64_t write_offsets(SnapshotWriter *w, const uint64_t *items, size_t count) {
+    uint64_t offset = image_alloc(w, count * sizeof(uint64_t));
+    if (offset && count) memcpy(w->data + offset, items, count * sizeof(uint64_t));
+    return offset;
+}
+
+static int write_file(const char *path, const unsigned char *data, size_t size) {
+    char temp[4096];
+    if ((size_t)snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long)getpid()) >= sizeof(temp)) return -1;
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = write(fd, data + written, size - written);
+        if (n <= 0) break;
+        written += (size_t)n;
+    }
+    if (close(fd) != 0 || written < size || rename(temp, path) != 0) {
+        unlink(temp);
+        return -1;
+    }
+    return 0;
+}
+
+int route_snapshot_save(Router *router, const char *path) {
+    if (!router || !path) return -1;
+    PatternList list = { NULL, 0, 0 };
+    SnapshotWriter w;
+    memset(&w, 0, sizeof(w));
+    int written = -1;
+
+    if (collect_patterns(router, &list, 0) < 0) goto done;
+    if (list.count) qsort(list.items, list.count, sizeof(*list.items), compare_patterns);
+
+    uint32_t slots = 2;
+    while (slots < list.count * 2) slots *= 2;
+    uint64_t *index = calloc(slots, sizeof(uint64_t));
+    if (!index) goto done;
+    image_alloc(&w, sizeof(SnapshotHeader));
+    uint32_t pattern_count = 0;
+    for (size_t i = 0; i < list.count && !w.failed; i++) {
+        // Routes registered under several methods share their path's pattern
+        if (i > 0 && compare_patterns(&list.items[i - 1], &list.items[i]) == 0) continue;
+        uint64_t offset = write_pattern(&w, list.items[i]);
+        if (!offset) break;
+        uint32_t slot = (uint32_t)(path_hash(list.items[i]->original_pattern) & (slots - 1));
+        while (index[slot]) slot = (slot + 1) & (slots - 1);
+        index[slot] = offset;
+        pattern_count++;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = ROUTE_SNAPSHOT_VERSION;
+    header.layout = snapshot_layout();
+    header.index_slots = slots;
+    header.pattern_count = pattern_count;
+    header.reloc_count = (uint32_t)w.reloc_count;
+    header.regex_count = (uint32_t)w.regex_count;
+    header.index = write_offsets(&w, index, slots);
+    header.regexes = write_offsets(&w, w.regexes, w.regex_count);
+    // The relocations come last: nothing after them needs relocating
+    header.relocs = write_offsets(&w, w.relocs, w.reloc_count);
+    image_alloc(&w, 0);
+    free(index);
+    if (w.failed) goto done;
+
+    header.size = w.size;
+    header.hash = snapshot_hash(w.data + sizeof(header), w.size - sizeof(header));
+    memcpy(w.data, &header, sizeof(header));
+    if (write_file(path, w.data, w.size) < 0) {
+        ERROR_PRINT("route_snapshot_save: cannot write %s\n", path);
+        goto done;
+    }
+    DEBUG_PRINT("route_snapshot_save: %u patterns, %zu bytes to %s\n", pattern_count, w.size, path);
+    written = (int)pattern_count;
+
+done:
+    free(list.items);
+    free(w.data);
+    free(w.relocs);
+    free(w.regexes);
+    return written;
+}
+
+// Are `count` items of `size` bytes at `offset` inside the file?
+static int snapshot_holds(size_t file_size, uint64_t offset, uint64_t count, size_t size) {
+    return offset <= file_size && count <= (file_size - offset) / size;
+}
+
+// Check the header and tables, then turn offsets into pointers
+static int snapshot_load(unsigned char *base, size_t size) {
+    const SnapshotHeader *header = (const SnapshotHeader *)base;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ROUTE_SNAPSHOT_VERSION || header->layout != snapshot_layout()) {
+        DEBUG_PRINT_STR("route_snapshot_open: written by another version or build\n");
+        return -1;
+    }
+    if (header->size != size || size % 8 != 0 ||
+        header->hash != snapshot_hash(base + sizeof(*header), size - sizeof(*header))) {
+        ERROR_PRINT_STR("route_snapshot_open: content hash mismatch, ignoring the snapshot\n");
+        return -1;
+    }
+    if (header->index_slots == 0 || (header->index_slots & (header->index_slots - 1)) != 0 ||
+        !snapshot_holds(size, header->index, header->index_slots, sizeof(uint64_t)) ||
+        !snapshot_holds(size, header->relocs, header->reloc_count, sizeof(uint64_t)) ||
+        !snapshot_holds(size, header->regexes, header->regex_count, sizeof(uint64_t))) {
+        ERROR_PRINT_STR("route_snapshot_open: malformed tables\n");
+        return -1;
+    }
+
+    const uint64_t *relocs = (const uint64_t *)(base + header->relocs);
+    for (uint32_t i = 0; i < header->reloc_count; i++) {
+        uintptr_t target;
+        if (relocs[i] < sizeof(*header) || !snapshot_holds(size, relocs[i], 1, sizeof(void *))) return -1;
+        memcpy(&target, base + relocs[i], sizeof(target));
+        if (target < sizeof(*header) || target >= header->relocs) return -1;
+        void *pointer = base + target;
+        memcpy(base + relocs[i], &pointer, sizeof(pointer));
+    }
+    const uint64_t *index = (const uint64_t *)(base + header->index);
+    for (uint32_t i = 0; i < header->index_slots; i++) {
+        if (index[i] && !snapshot_holds(size, index[i], 1, sizeof(RoutePattern))) return -1;
+    }
+    const uint64_t *regexes = (const uint64_t *)(base + header->regexes);
+    for (uint32_t i = 0; i < header->regex_count; i++) {
+        if (!snapshot_holds(size, regexes[i], 1, sizeof(RouteConstraint))) return -1;
+    }
+    return 0;
+}
+
+RouteSnapshot *route_snapshot_open(const char *path) {
+    int fd = path ? open(path, O_RDONLY | O_CLOEXEC) : -1;
+    if (fd < 0) {
+        DEBUG_PRINT("route_snapshot_open: no snapshot at %s\n", path ? path : "NULL");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    // Private: relocating writes to our copy of the pages, never the file
+    unsigned char *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    RouteSnapshot *snapshot = malloc(sizeof(RouteSnapshot));
+    if (!snapshot || snapshot_load(base, size) < 0) {
+        free(snapshot);
+        munmap(base, size);
+        return NULL;
+    }
+    snapshot->base = base;
+    snapshot->size = size;
+    snapshot->header = (const SnapshotHeader *)base;
+    snapshot->index = (const uint64_t *)(base + snapshot->header->index);
+    DEBUG_PRINT("route_snapshot_open: %u patterns from %s\n", snapshot->header->pattern_count, path);
+    return snapshot;
+}
+
+RoutePattern *route_snapshot_find(const RouteSnapshot *snapshot, const char *pattern) {
+    if (!snapshot || !pattern) return NULL;
+    uint32_t mask = snapshot->header->index_slots - 1;
+    for (uint32_t slot = (uint32_t)(path_hash(pattern) & mask);; slot = (slot + 1) & mask) {
+        if (!snapshot->index[slot]) return NULL;
+        RoutePattern *found = (RoutePattern *)(snapshot->base + snapshot->index[slot]);
+        if (strcmp(found->original_pattern, pattern) == 0) return found;
+    }
+}
+
+int route_snapshot_count(const RouteSnapshot *snapshot) {
+    return snapshot ? (int)snapshot->header->pattern_count : 0;
+}
+
+void route_snapshot_close(RouteSnapshot *snapshot) {
+    if (!snapshot) return;
+    // Regexes compiled since the snapshot was opened
+    const uint64_t *regexes = (const uint64_t *)(snapshot->base + snapshot->header->regexes);
+    for (uint32_t i = 0; i < snapshot->header->regex_count; i++) {
+        RouteConstraint *constraint = (RouteConstraint *)(snapshot->base + regexes[i]);
+        if (constraint->compiled_regex) {
+            regfree(constraint->compiled_regex);
+            free(constraint->compiled_regex);
+        }
+    }
+    munmap(snapshot->base, snapshot->size);
+    free(snapshot);
+}
@@ -0,0 +1,42 @@
+#ifndef ROUTE_SNAPSHOT_H
+#define ROUTE_SNAPSHOT_H
+
+#include "route.h"
+
+// Compiled route patterns saved to a file and mapped back at startup, so a
+// process registering thousands of routes does not parse them (and their
+// constraints) again on every boot.
+//
+// The file is an image of the patterns as compile_route_pattern builds
+// them, with every pointer stored as an offset into the file and a list of
+// where those are. Opening it maps the file privately, checks its content
+// hash and the struct layout it was written with, and turns the offsets
+// back into pointers. A router given a snapshot (router_set_snapshot) then
+// takes the pattern for each path it registers from it, compiling only
+// paths the snapshot does not have. Regex constraints are compiled by the
+// first request that reaches them.
+
+#define ROUTE_SNAPSHOT_VERSION 1
+
+typedef struct RouteSnapshot RouteSnapshot;
+
+struct Router;
+
+// Write the patterns of `router`'s layers, and those of routers mounted in
+// it, to `path` (replaced atomically). Patterns with custom validators are
+// left out. Returns the number of patterns written, -1 on error.
+int route_snapshot_save(struct Router *router, const char *path);
+
+// NULL when the file is missing, corrupt, from another version or written
+// with another struct layout: the routes are then compiled as usual
+RouteSnapshot *route_snapshot_open(const char *path);
+
+// The pattern compiled for `pattern`, or NULL. Owned by the snapshot:
+// free_route_pattern leaves it alone.
+RoutePattern *route_snapshot_find(const RouteSnapshot *snapshot, const char *pattern);
+int route_snapshot_count(const RouteSnapshot *snapshot);
+
+// Unmap the snapshot; every router using it must be destroyed first
+void route_snapshot_close(RouteSnapshot *snapshot);
+
+#endif
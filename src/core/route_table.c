@@ -0,0 +1,30 @@
+#include "route_table.h"
+#include "router.h"
+#include "../debug.h"
+
+void route_table_dispatch(const RouteTable *table, int client_fd, void (*next)(void *), void *context) {
+    NextContext *ctx = (NextContext *)context;
+    Request *req = ctx->req;
+    if (!req) {
+        next(context);
+        return;
+    }
+
+    // In a mounted router the routes are relative to the mount
+    const char *path = ctx->path ? ctx->path : req->path;
+    ParamSlice slices[REQUEST_MAX_ROUTE_SLICES];
+    int slice_count = 0;
+    unsigned int allowed = 0;
+    int route = table->lookup(req->method_id, path, slices, &slice_count, &allowed);
+    if (route < 0) {
+        DEBUG_PRINT("route_table_dispatch: %s: no route for %s\n", table->name, path);
+        next_allow(context, allowed);
+        next(context);
+        return;
+    }
+
+    DEBUG_PRINT("route_table_dispatch: %s: %s -> %s\n", table->name, path, table->routes[route].path);
+    request_set_route_slices(req, slices, slice_count);
+    next_take(context);
+    table->routes[route].handler(client_fd, next, context);
+}
@@ -0,0 +1,44 @@
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+
+#include "layer.h"
+
+// Routes compiled to C ahead of time by routegen (tools/routegen.c) from a
+// manifest of "METHOD /path handler" lines. Static paths resolve through a
+// perfect hash, with the winning route for every method worked out when
+// the table is generated; parameterized paths through generated
+// per-segment comparisons. Nothing is compiled or allocated at startup.
+//
+// A table is served by one middleware layer, its generated <name>_handler:
+//     app.use(&app, api_handler);
+// Its routes then run where that layer sits in the chain, first match in
+// manifest order, as if registered there one by one. In a mounted router
+// they match the path relative to the mount, as that router's own do.
+
+typedef struct {
+    unsigned int methods;    // HTTP_METHOD_BIT mask
+    const char *path;        // As written in the manifest
+    Handler handler;
+} RouteTableEntry;
+
+typedef struct RouteTable {
+    const char *name;
+    const RouteTableEntry *routes;  // In manifest order
+    int route_count;
+    // Index of the first route taking the request, with its parameters in
+    // `slices` (as slices of `path`); -1 when none does, with *allowed set
+    // to the methods of the routes taking the path
+    int (*lookup)(HttpMethod method, const char *path, ParamSlice *slices, int *slice_count,
+                  unsigned int *allowed);
+} RouteTable;
+
+// What a generated <name>_handler does: run the table's route for the
+// request behind `context`, or call next() when it has none
+void route_table_dispatch(const RouteTable *table, int client_fd, void (*next)(void *), void *context);
+
+// Declarations for the code using a generated table
+#define ROUTE_TABLE_DECLARE(name) \
+    extern const RouteTable name; \
+    void name##_handler(int client_fd, void (*next)(void *), void *context)
+
+#endif
@@ -0,0 +1,440 @@
+#define _GNU_SOURCE
+#include "route_tree.h"
+#include "../debug.h"
+#include <stdlib.h>
+#include <string.h>
+
+// One segment of a layer path, as inserted into the tree
+typedef struct {
+    SegmentType type;
+    ParameterType param_type;
+    const char *literal;
+} TreeSegment;
+
+// Make room for one more item; returns the (possibly moved) array or NULL
+static void *grow_array(void *items, int *capacity, int count, size_t item_size) {
+    if (count < *capacity) return items;
+    int new_capacity = *capacity == 0 ? 4 : *capacity * 2;
+    void *grown = realloc(items, new_capacity * item_size);
+    if (grown) *capacity = new_capacity;
+    return grown;
+}
+
+static RouteTreeNode *node_create(SegmentType type, ParameterType param_type) {
+    RouteTreeNode *node = calloc(1, sizeof(RouteTreeNode));
+    if (!node) return NULL;
+    node->type = type;
+    node->param_type = param_type;
+    return node;
+}
+
+static void node_destroy(RouteTreeNode *node) {
+    if (!node) return;
+    for (int i = 0; i < node->label_count; i++) free(node->labels[i]);
+    for (int i = 0; i < node->static_count; i++) node_destroy(node->statics[i]);
+    for (int i = 0; i < node->dynamic_count; i++) node_destroy(node->dynamics[i]);
+    free(node->labels);
+    free(node->statics);
+    free(node->dynamics);
+    free(node->layers);
+    free(node);
+}
+
+// strcmp between a label and `length` bytes of the path
+static int compare_label(const char *label, const char *segment, size_t length) {
+    int cmp = strncmp(label, segment, length);
+    if (cmp != 0) return cmp;
+    return label[length] != '\0';
+}
+
+// Binary search the literal children for one starting with `segment`;
+// returns the child's index, or the insertion point as -(point + 1)
+static int find_static(const RouteTreeNode *node, const char *segment, size_t length) {
+    int low = 0, high = node->static_count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int cmp = compare_label(node->statics[mid]->labels[0], segment, length);
+        if (cmp == 0) return mid;
+        if (cmp < 0) low = mid + 1;
+        else high = mid - 1;
+    }
+    return -(low + 1);
+}
+
+static int add_static(RouteTreeNode *node, RouteTreeNode *child, int position) {
+    RouteTreeNode **statics = grow_array(node->statics, &node->static_capacity, node->static_count,
+                                         sizeof(RouteTreeNode *));
+    if (!statics) return -1;
+    node->statics = statics;
+    memmove(&node->statics[position + 1], &node->statics[position],
+            (node->static_count - position) * sizeof(RouteTreeNode *));
+    node->statics[position] = child;
+    node->static_count++;
+    return 0;
+}
+
+// Split a literal edge after its first `keep` labels; the lower half takes
+// over the node's children and layers
+static int split_static(RouteTreeNode *node, int keep) {
+    RouteTreeNode *tail = node_create(SEGMENT_LITERAL, PARAM_STRING);
+    if (!tail) return -1;
+    tail->labels = malloc((node->label_count - keep) * sizeof(char *));
+    if (!tail->labels) {
+        free(tail);
+        return -1;
+    }
+    memcpy(tail->labels, node->labels + keep, (node->label_count - keep) * sizeof(char *));
+    tail->label_count = node->label_count - keep;
+
+    tail->statics = node->statics;
+    tail->static_count = node->static_count;
+    tail->static_capacity = node->static_capacity;
+    tail->dynamics = node->dynamics;
+    tail->dynamic_count = node->dynamic_count;
+    tail->dynamic_capacity = node->dynamic_capacity;
+    tail->layers = node->layers;
+    tail->layer_count = node->layer_count;
+    tail->layer_capacity = node->layer_capacity;
+
+    node->label_count = keep;
+    node->statics = NULL;
+    node->static_count = node->static_capacity = 0;
+    node->dynamics = NULL;
+    node->dynamic_count = node->dynamic_capacity = 0;
+    node->layers = NULL;
+    node->layer_count = node->layer_capacity = 0;
+    return add_static(node, tail, 0);
+}
+
+static int node_insert(RouteTreeNode *node, const TreeSegment *segs, int count, int index) {
+    while (count > 0) {
+        if (segs[0].type == SEGMENT_LITERAL) {
+            // Length of the literal run at the front of the path
+            int run = 0;
+            while (run < count && segs[run].type == SEGMENT_LITERAL) run++;
+
+            int found = find_static(node, segs[0].literal, strlen(segs[0].literal));
+            if (found < 0) {
+                RouteTreeNode *child = node_create(SEGMENT_LITERAL, PARAM_STRING);
+                if (!child) return -1;
+                child->labels = malloc(run * sizeof(char *));
+                if (!child->labels) {
+                    free(child);
+                    return -1;
+                }
+                for (int i = 0; i < run; i++) {
+                    child->labels[i] = strdup(segs[i].literal);
+                    child->label_count++;
+                    if (!child->labels[i]) {
+                        node_destroy(child);
+                        return -1;
+                    }
+                }
+                if (add_static(node, child, -found - 1) < 0) {
+                    node_destroy(child);
+                    return -1;
+                }
+                node = child;
+                segs += run;
+                count -= run;
+                continue;
+            }
+
+            RouteTreeNode *child = node->statics[found];
+            int common = 1;
+            while (common < child->label_count && common < run &&
+                   strcmp(child->labels[common], segs[common].literal) == 0) {
+                common++;
+            }
+            if (common < child->label_count && split_static(child, common) < 0) return -1;
+            node = child;
+            segs += common;
+            count -= common;
+            continue;
+        }
+
+        RouteTreeNode *child = NULL;
+        for (int i = 0; i < node->dynamic_count; i++) {
+            RouteTreeNode *candidate = node->dynamics[i];
+            if (candidate->type == segs[0].type &&
+                (segs[0].type == SEGMENT_WILDCARD || candidate->param_type == segs[0].param_type)) {
+                child = candidate;
+                break;
+            }
+        }
+        if (!child) {
+            RouteTreeNode **dynamics = grow_array(node->dynamics, &node->dynamic_capacity,
+                                                  node->dynamic_count, sizeof(RouteTreeNode *));
+            if (!dynamics) return -1;
+            node->dynamics = dynamics;
+            child = node_create(segs[0].type, segs[0].param_type);
+            if (!child) return -1;
+            node->dynamics[node->dynamic_count++] = child;
+        }
+        node = child;
+        segs++;
+        count--;
+    }
+
+    int *layers = grow_array(node->layers, &node->layer_capacity, node->layer_count, sizeof(int));
+    if (!layers) return -1;
+    node->layers = layers;
+    node->layers[node->layer_count++] = index;
+    return 0;
+}
+
+RouteTree *route_tree_create(void) {
+    RouteTree *tree = calloc(1, sizeof(RouteTree));
+    if (!tree) return NULL;
+    tree->root = node_create(SEGMENT_LITERAL, PARAM_STRING);
+    if (!tree->root) {
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+void route_tree_destroy(RouteTree *tree) {
+    if (!tree) return;
+    node_destroy(tree->root);
+    free(tree->unkeyed);
+    free(tree);
+}
+
+int route_tree_insert(RouteTree *tree, const Layer *layer, int index) {
+    RoutePattern *pattern = (RoutePattern *)layer->pattern;
+
+    // Layers that do not match on the path segments: middleware without
+    // parameters matches everything and mounted routers match on a string
+    // prefix
+    if (layer->type == LAYER_ROUTER || (layer->type == LAYER_MIDDLEWARE && (!pattern || pattern->is_static))) {
+        int *unkeyed = grow_array(tree->unkeyed, &tree->unkeyed_capacity, tree->unkeyed_count, sizeof(int));
+        if (!unkeyed) return -1;
+        tree->unkeyed = unkeyed;
+        tree->unkeyed[tree->unkeyed_count++] = index;
+        return 0;
+    }
+
+    // Handlers without a path can never match
+    if (!pattern) return 0;
+
+    // Static paths match by string compare; they are indexed by the same
+    // segments, and the layer does the exact compare
+    int count = pattern->segment_count;
+    TreeSegment *segs = malloc((count > 0 ? count : 1) * sizeof(TreeSegment));
+    if (!segs) return -1;
+    for (int i = 0; i < count; i++) {
+        RouteSegment *seg = &pattern->segments[i];
+        segs[i].type = seg->type;
+        segs[i].param_type = seg->param ? seg->param->type : PARAM_STRING;
+        segs[i].literal = seg->literal_value;
+    }
+    int result = node_insert(tree->root, segs, count, index);
+
+    free(segs);
+    DEBUG_PRINT("route_tree_insert: layer %d (%s %s) indexed\n", index,
+           layer->method ? layer->method : "NULL", layer->path);
+    return result;
+}
+
+typedef struct {
+    const char *path;
+    size_t end;         // Cursor past the last segment
+    int *out;
+    int found;
+} TreeLookup;
+
+// Follows route_pattern_match exactly: parameters must pass their type
+// check, an optional parameter takes the segment whenever it is valid (it
+// never backtracks), and a wildcard takes everything that is left. `pos`
+// is a cursor into the path; segments are compared in place.
+static void node_lookup(const RouteTreeNode *node, TreeLookup *lookup, size_t pos) {
+    const char *segment = NULL;
+    size_t length = 0;
+    size_t next = pos;
+    int have = path_next_segment(lookup->path, &next, &segment, &length);
+    
+    if (!have) {
+        for (int i = 0; i < node->layer_count; i++) {
+            lookup->out[lookup->found++] = node->layers[i];
+        }
+    }
+
+    if (have && node->static_count > 0) {
+        int found = find_static(node, segment, length);
+        if (found >= 0) {
+            const RouteTreeNode *child = node->statics[found];
+            size_t cursor = next;
+            int matched = 1;
+            for (int i = 1; matched && i < child->label_count; i++) {
+                const char *label_segment;
+                size_t label_length;
+                matched = path_next_segment(lookup->path, &cursor, &label_segment, &label_length) &&
+                          compare_label(child->labels[i], label_segment, label_length) == 0;
+            }
+            if (matched) node_lookup(child, lookup, cursor);
+        }
+    }
+
+    for (int i = 0; i < node->dynamic_count; i++) {
+        const RouteTreeNode *child = node->dynamics[i];
+        int valid = have && validate_parameter_slice(segment, length, child->param_type);
+
+        switch (child->type) {
+            case SEGMENT_PARAMETER:
+                if (valid) node_lookup(child, lookup, next);
+                break;
+            case SEGMENT_OPTIONAL:
+                node_lookup(child, lookup, valid ? next : pos);
+                break;
+            case SEGMENT_WILDCARD:
+                node_lookup(child, lookup, lookup->end);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Registration order for the short candidate lists
+static void sort_layers(int *out, int count) {
+    for (int i = 1; i < count; i++) {
+        int value = out[i];
+        int j = i - 1;
+        while (j >= 0 && out[j] > value) {
+            out[j + 1] = out[j];
+            j--;
+        }
+        out[j + 1] = value;
+    }
+}
+
+int route_tree_candidates(const RouteTree *tree, const char *path, int *out) {
+    if (!tree || !path) return 0;
+
+    TreeLookup lookup = { path, strlen(path), out, 0 };
+
+    for (int i = 0; i < tree->unkeyed_count; i++) {
+        out[lookup.found++] = tree->unkeyed[i];
+    }
+    node_lookup(tree->root, &lookup, 0);
+
+    // Layers run in registration order; the candidate list is short
+    sort_layers(out, lookup.found);
+    return lookup.found;
+}
+
+typedef struct {
+    const RoutePattern *pattern;
+    unsigned char *seen;    // Per layer, so branches that meet again add nothing
+    int *out;
+    int found;
+} TreeOverlap;
+
+static void overlap_add(TreeOverlap *overlap, const RouteTreeNode *node) {
+    for (int i = 0; i < node->layer_count; i++) {
+        if (overlap->seen[node->layers[i]]) continue;
+        overlap->seen[node->layers[i]] = 1;
+        overlap->out[overlap->found++] = node->layers[i];
+    }
+}
+
+static void overlap_subtree(TreeOverlap *overlap, const RouteTreeNode *node) {
+    overlap_add(overlap, node);
+    for (int i = 0; i < node->static_count; i++) overlap_subtree(overlap, node->statics[i]);
+    for (int i = 0; i < node->dynamic_count; i++) overlap_subtree(overlap, node->dynamics[i]);
+}
+
+// Could a path segment equal to `label` fill pattern segment `seg`?
+static int segment_accepts(const RouteSegment *seg, const char *label) {
+    if (seg->type == SEGMENT_LITERAL) return strcmp(seg->literal_value, label) == 0;
+    if (seg->type == SEGMENT_WILDCARD || !seg->param) return 1;
+    return validate_parameter_slice(label, strlen(label), seg->param->type);
+}
+
+static void overlap_node(TreeOverlap *overlap, const RouteTreeNode *node, int seg);
+
+// The rest of a literal edge, from label `label`, against pattern segment `seg`
+static void overlap_labels(TreeOverlap *overlap, const RouteTreeNode *node, int label, int seg) {
+    const RoutePattern *pattern = overlap->pattern;
+    if (label == node->label_count) {
+        overlap_node(overlap, node, seg);
+        return;
+    }
+    if (seg == pattern->segment_count) return;
+
+    const RouteSegment *segment = &pattern->segments[seg];
+    if (segment->type == SEGMENT_WILDCARD) {
+        overlap_subtree(overlap, node);
+        return;
+    }
+    if (segment->type == SEGMENT_OPTIONAL) overlap_labels(overlap, node, label, seg + 1);
+    if (segment_accepts(segment, node->labels[label])) overlap_labels(overlap, node, label + 1, seg + 1);
+}
+
+// Walks the tree with pattern segments in place of path segments, taking
+// every branch some path could take
+static void overlap_node(TreeOverlap *overlap, const RouteTreeNode *node, int seg) {
+    const RoutePattern *pattern = overlap->pattern;
+    if (seg == pattern->segment_count) {
+        // Optional and wildcard edges also match when nothing is left
+        overlap_add(overlap, node);
+        for (int i = 0; i < node->dynamic_count; i++) {
+            if (node->dynamics[i]->type != SEGMENT_PARAMETER) overlap_node(overlap, node->dynamics[i], seg);
+        }
+        return;
+    }
+
+    const RouteSegment *segment = &pattern->segments[seg];
+    if (segment->type == SEGMENT_WILDCARD) {
+        overlap_subtree(overlap, node);
+        return;
+    }
+    if (segment->type == SEGMENT_OPTIONAL) overlap_node(overlap, node, seg + 1);
+
+    if (segment->type == SEGMENT_LITERAL) {
+        int found = find_static(node, segment->literal_value, strlen(segment->literal_value));
+        if (found >= 0) overlap_labels(overlap, node->statics[found], 1, seg + 1);
+    } else {
+        for (int i = 0; i < node->static_count; i++) {
+            if (segment_accepts(segment, node->statics[i]->labels[0])) {
+                overlap_labels(overlap, node->statics[i], 1, seg + 1);
+            }
+        }
+    }
+
+    for (int i = 0; i < node->dynamic_count; i++) {
+        const RouteTreeNode *child = node->dynamics[i];
+        if (child->type == SEGMENT_WILDCARD) {
+            overlap_subtree(overlap, child);
+            continue;
+        }
+        if (segment->type != SEGMENT_LITERAL ||
+            validate_parameter_slice(segment->literal_value, strlen(segment->literal_value), child->param_type)) {
+            overlap_node(overlap, child, seg + 1);
+        }
+        if (child->type == SEGMENT_OPTIONAL) overlap_node(overlap, child, seg);
+    }
+}
+
+static int compare_layers(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+int route_tree_overlapping(const RouteTree *tree, const RoutePattern *pattern, int layer_count, int *out) {
+    if (!tree || !pattern || layer_count <= 0) return 0;
+
+    TreeOverlap overlap = { pattern, calloc(layer_count, 1), out, 0 };
+    if (!overlap.seen) return -1;
+
+    for (int i = 0; i < tree->unkeyed_count; i++) {
+        overlap.seen[tree->unkeyed[i]] = 1;
+        out[overlap.found++] = tree->unkeyed[i];
+    }
+    overlap_node(&overlap, tree->root, 0);
+
+    free(overlap.seen);
+    // A wildcard pattern can overlap the whole router
+    qsort(out, overlap.found, sizeof(int), compare_layers);
+    return overlap.found;
+}
@@ -0,0 +1,57 @@
+#ifndef ROUTE_TREE_H
+#define ROUTE_TREE_H
+
+#include "route.h"
+
+// One node of the route tree. The edge into a node is either a run of
+// literal path segments (chains of single-child literal nodes are merged
+// into one edge) or a single :param, :param? or * segment.
+typedef struct RouteTreeNode {
+    SegmentType type;                 // Kind of edge leading to this node
+    ParameterType param_type;         // For SEGMENT_PARAMETER / SEGMENT_OPTIONAL edges
+    char **labels;                    // SEGMENT_LITERAL: the segments on this edge
+    int label_count;
+
+    struct RouteTreeNode **statics;   // Literal children, sorted by labels[0]
+    int static_count;
+    int static_capacity;
+    struct RouteTreeNode **dynamics;  // Param, optional and wildcard children
+    int dynamic_count;
+    int dynamic_capacity;
+
+    int *layers;                      // Layers whose path ends here, in registration order
+    int layer_count;
+    int layer_capacity;
+} RouteTreeNode;
+
+// Index over a router's layers keyed by path segment, so finding the
+// candidate layers for a path costs O(path length), not O(layers).
+// Pattern-less middleware and mounted routers are not keyed by path and
+// are kept in a side list that every lookup includes.
+typedef struct RouteTree {
+    RouteTreeNode *root;
+    int *unkeyed;
+    int unkeyed_count;
+    int unkeyed_capacity;
+} RouteTree;
+
+RouteTree *route_tree_create(void);
+void route_tree_destroy(RouteTree *tree);
+
+// Index layers[index]; call once per layer, in registration order
+int route_tree_insert(RouteTree *tree, const Layer *layer, int index);
+
+// Write the indexes of every layer that may match `path` into `out` (room
+// for every layer of the router), in registration order. Candidates must
+// still be confirmed with layer_match_slices, which also checks the method
+// and constraints and captures the parameters. The path is read in place.
+int route_tree_candidates(const RouteTree *tree, const char *path, int *out);
+
+// Write the indexes of every layer that may match some path `pattern`
+// matches, in registration order (`layer_count`: the router's layers).
+// Conservative: types, constraints and optional-segment greed are not
+// compared, so callers still check each layer against real paths.
+// Returns -1 when out of memory.
+int route_tree_overlapping(const RouteTree *tree, const RoutePattern *pattern, int layer_count, int *out);
+
+#endif
@@ -5,6 +5,8 @@
 #include "../http/response.h"
 #include "../http/error.h"
 #include "route.h"
+#include "vhost.h"
+#include "route_snapshot.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -17,6 +19,8 @@ Router *create_router() {
     router->layers = NULL;
     router->layer_count = 0;
     router->capacity = 0;
+    router->tree = NULL;
+    router->snapshot = NULL;
     
     // Set method pointers
     router->get = router_get;
@@ -34,19 +38,34 @@ Router *create_router() {
 void destroy_router(Router *router) {
     if (router) {
         if (router->layers) {
-            // Free mount_prefix strings for mounted routers
+            // Free mount_prefix strings and compiled patterns
             for (int i = 0; i < router->layer_count; i++) {
-                if (router->layers[i].mount_prefix) {
-                    free((char*)router->layers[i].mount_prefix);
+                Layer *layer = &router->layers[i];
+                if (layer->mount_prefix) {
+                    free((char*)layer->mount_prefix);
                 }
+                free(layer->host);
+                free_route_pattern((RoutePattern*)layer->pattern);
             }
             free(router->layers);
         }
+        route_tree_destroy(router->tree);
         free(router);
         DEBUG_PRINT_STR("destroy_router: router destroyed\n");
     }
 }
 
+// Add a new layer to the router's path index
+static void router_index_layer(Router *router, int index) {
+    if (!router->tree) {
+        router->tree = route_tree_create();
+        if (!router->tree) return;
+    }
+    if (route_tree_insert(router->tree, &router->layers[index], index) < 0) {
+        ERROR_PRINT("router: failed to index route %s\n", router->layers[index].path);
+    }
+}
+
 void router_add_layer(Router *router, const char *method, const char *path, Handler handler) {
     if (router->layer_count >= router->capacity) {
         int new_capacity = router->capacity == 0 ? 4 : router->capacity * 2;
@@ -63,26 +82,41 @@ void router_add_layer(Router *router, const char *method, const char *path, Hand
     layer->method = method;
     layer->path = path;
     layer->type = LAYER_HANDLER;
+    layer->methods = HTTP_METHODS_ALL;
+    if (method && strcmp(method, "USE") == 0) {
+        layer->type = LAYER_MIDDLEWARE;
+    } else if (method) {
+        layer->methods = HTTP_METHOD_BIT(http_method_parse(method, strlen(method)));
+    }
     layer->data.handler = handler;
     layer->mount_prefix = NULL;
-    layer->last_match = NULL;
+    layer->host = NULL;
     
-    // Compile route pattern for advanced matching
-    if (path && (strchr(path, ':') || strchr(path, '*'))) {
-        layer->pattern = (void*)compile_route_pattern(path);
-        DEBUG_PRINT("router_add_layer: compiled pattern for '%s'\n", path);
-    } else {
-        layer->pattern = NULL;
+    // Compile the path once here, static ones included, so matching a
+    // request never has to parse it (unless the snapshot has it compiled)
+    RoutePattern *pattern = path ? route_snapshot_find(router->snapshot, path) : NULL;
+    layer->pattern = pattern ? (void*)pattern : path ? (void*)compile_route_pattern(path) : NULL;
+    DEBUG_PRINT("router_add_layer: compiled pattern for '%s'\n", path ? path : "NULL");
+    if (layer->pattern && ((RoutePattern*)layer->pattern)->param_count > REQUEST_MAX_ROUTE_SLICES) {
+        ERROR_PRINT("router_add_layer: '%s' has more than %d parameters and never matches\n",
+                    path, REQUEST_MAX_ROUTE_SLICES);
     }
     
+    router_index_layer(router, router->layer_count);
     router->layer_count++;
 }
 
-void router_mount(Router *parent, const char *prefix, Router *child) {
+void router_set_snapshot(Router *router, RouteSnapshot *snapshot) {
+    router->snapshot = snapshot;
+    DEBUG_PRINT("router_set_snapshot: %d precompiled patterns\n", route_snapshot_count(snapshot));
+}
+
+static void router_add_mount(Router *parent, const char *prefix, Router *child, char *host) {
     if (parent->layer_count >= parent->capacity) {
         int new_capacity = parent->capacity == 0 ? 4 : parent->capacity * 2;
         Layer *new_layers = realloc(parent->layers, new_capacity * sizeof(Layer));
         if (!new_layers) {
+            free(host);
             return;
         }
         parent->layers = new_layers;
@@ -94,99 +128,337 @@ void router_mount(Router *parent, const char *prefix, Router *child) {
     layer->method = "MOUNT";  // Special method for mounted routers
     layer->path = prefix;
     layer->type = LAYER_ROUTER;
+    layer->methods = HTTP_METHODS_ALL;
     layer->data.router = child;
     layer->mount_prefix = strdup(prefix);  // Store a copy of the prefix
+    layer->host = host;
+    layer->pattern = NULL;
+    router_index_layer(parent, parent->layer_count);
     parent->layer_count++;
-    
+}
+
+void router_mount(Router *parent, const char *prefix, Router *child) {
+    router_add_mount(parent, prefix, child, NULL);
     DEBUG_PRINT("router_mount: mounted router at prefix=%s\n", prefix);
 }
 
-void next_handler(void *context) {
-    NextContext *ctx = (NextContext *)context;
+void router_vhost(Router *parent, const char *host, Router *child) {
+    char *pattern = vhost_pattern_normalize(host);
+    if (!pattern) {
+        ERROR_PRINT("router_vhost: invalid host pattern '%s'\n", host ? host : "NULL");
+        return;
+    }
+    // Mounted at the root: the host's router sees the whole path
+    router_add_mount(parent, "", child, pattern);
+    DEBUG_PRINT("router_vhost: mounted router for host=%s\n", pattern);
+}
+
+NextContext *next_context_create(Router *router, struct App *app, int client_fd, Request *req,
+                                 NextContext *local) {
+    NextContext *ctx = req ? arena_alloc(&req->arena, sizeof(NextContext)) : NULL;
+    if (!ctx) ctx = local;
+    memset(ctx, 0, sizeof(NextContext));
+    ctx->router = router;
+    ctx->app = app;
+    ctx->client_fd = client_fd;
+    ctx->req = req;
+    ctx->arena = req ? &req->arena : NULL;
+    ctx->path = req ? req->path : "/";
+    return ctx;
+}
+
+// Continue a chain inside the router mounted at `layer`: the context takes
+// over the sub-router's matches and keeps its place in the parent, so the
+// mount costs no stack frame
+static void router_enter_mount(NextContext *ctx, Layer *layer) {
+    DEBUG_PRINT("next_handler: routing to mounted router at prefix=%s\n", layer->mount_prefix);
+    
+    // Strip the mount prefix from the path the parent's layers see
+    const char *sub_path = ctx->path ? ctx->path : "/";
+    size_t prefix_len = strlen(layer->mount_prefix);
+    if (strncmp(sub_path, layer->mount_prefix, prefix_len) == 0) {
+        sub_path += prefix_len;
+        // If sub_path is empty, make it "/"
+        if (*sub_path == '\0') {
+            sub_path = "/";
+        }
+    }
+    DEBUG_PRINT("next_handler: sub_path=%s for mounted router\n", sub_path);
+    
+    Router *router = layer->data.router;
+    NextMount *mount = ctx->arena ? arena_alloc(ctx->arena, sizeof(NextMount)) : malloc(sizeof(NextMount));
+    LayerMatch *matches = ctx->arena ? arena_alloc(ctx->arena, router->layer_count * sizeof(LayerMatch))
+                                     : malloc(router->layer_count * sizeof(LayerMatch));
+    if (!mount || !matches) {
+        // Skip the mount, as when nothing in it matches
+        ERROR_PRINT_STR("router_enter_mount: out of memory\n");
+        if (!ctx->arena) {
+            free(mount);
+            free(matches);
+        }
+        return;
+    }
+    mount->router = ctx->router;
+    mount->matches = ctx->matches;
+    mount->match_count = ctx->match_count;
+    mount->idx = ctx->idx;
+    mount->path = ctx->path;
+    mount->parent = ctx->mounts;
+    ctx->mounts = mount;
+
+    int route_match_count = 0;
+    ctx->router = router;
+    ctx->matches = matches;
+    ctx->idx = 0;
+    ctx->path = sub_path;
+    ctx->match_count = router_match(router, ctx->req ? ctx->req->method : NULL, sub_path, matches,
+                                    &route_match_count, ctx->req);
+    if (route_match_count == 0) ctx->allowed |= router_allowed_methods(router, sub_path, ctx->arena);
+    ctx->route_match_count += route_match_count;
+}
+
+// Back to the parent once a mounted router's layers ran out
+static void router_leave_mount(NextContext *ctx) {
+    NextMount *mount = ctx->mounts;
+    if (!ctx->arena) free(ctx->matches);
+    ctx->router = mount->router;
+    ctx->matches = mount->matches;
+    ctx->match_count = mount->match_count;
+    ctx->idx = mount->idx;
+    ctx->path = mount->path;
+    ctx->mounts = mount->parent;
+    if (!ctx->arena) free(mount);
+}
+
+void next_context_release(NextContext *ctx) {
+    // With an arena, resetting it releases everything
+    if (ctx->arena) return;
+    while (ctx->mounts) router_leave_mount(ctx);
+    free(ctx->matches);
+    ctx->matches = NULL;
+}
+
+int router_advance(NextContext *ctx) {
     DEBUG_PRINT("next_handler: idx=%d, match_count=%d\n", ctx->idx, ctx->match_count);
-    if (ctx->idx < ctx->match_count) {
-        int layer_idx = ctx->matches[ctx->idx++];
+    while (ctx->idx < ctx->match_count || ctx->mounts) {
+        if (ctx->idx >= ctx->match_count) {
+            router_leave_mount(ctx);
+            continue;
+        }
+        LayerMatch *match = &ctx->matches[ctx->idx++];
+        int layer_idx = match->layer;
         Layer *layer = &ctx->router->layers[layer_idx];
         
         if (layer->type == LAYER_ROUTER) {
-            // Handle mounted router
-            DEBUG_PRINT("next_handler: routing to mounted router at prefix=%s\n", layer->mount_prefix);
-            
-            // Strip the mount prefix from the path
-            const char *sub_path = ctx->req->path;
-            size_t prefix_len = strlen(layer->mount_prefix);
-            if (strncmp(sub_path, layer->mount_prefix, prefix_len) == 0) {
-                sub_path += prefix_len;
-                // If sub_path is empty, make it "/"
-                if (*sub_path == '\0') {
-                    sub_path = "/";
-                }
-            }
-            
-            DEBUG_PRINT("next_handler: sub_path=%s for mounted router\n", sub_path);
-            
-            // Route to the mounted router with the stripped path
-            router_handle(layer->data.router, ctx->req->method, sub_path, ctx->client_fd, ctx->req);
-            
-        } else {
-            // Handle regular handler
-            
-            // Extract parameters from advanced pattern matching
-            RouteMatch *route_match = (RouteMatch*)layer->last_match;
-            if (route_match && route_match->matched) {
-                request_set_route_params(ctx->req, route_match);
-            } else if (layer->method && strcmp(layer->method, "USE") != 0 && layer->path) {
-                // Fallback to legacy parameter parsing for simple patterns
-                request_parse_params(ctx->req, layer->path, ctx->req->path);
-            }
-            
-            DEBUG_PRINT("next_handler: calling handler for layer_idx=%d\n", layer_idx);
-            layer->data.handler(ctx->client_fd, next_handler, ctx);
+            router_enter_mount(ctx, layer);
+            continue;
         }
-    } else {
-        DEBUG_PRINT_STR("next_handler: end of chain\n");
+        
+        // Parameters captured for this layer by router_match (none for a
+        // plain route path); middleware on a plain path leaves them alone
+        RoutePattern *pattern = (RoutePattern*)layer->pattern;
+        int is_use = layer->type == LAYER_MIDDLEWARE;
+        if (pattern && ctx->req && !(is_use && pattern->is_static)) {
+            request_set_route_slices(ctx->req, ctx->req->route_slices + match->slice_start, match->slice_count);
+        }
+        
+        DEBUG_PRINT("next_handler: calling handler for layer_idx=%d\n", layer_idx);
+        layer->data.handler(ctx->client_fd, next_handler, ctx);
+        return 1;
     }
+    DEBUG_PRINT_STR("next_handler: end of chain\n");
+    return 0;
 }
 
-void router_handle(Router *router, const char *method, const char *path, int client_fd, Request *req) {
-    DEBUG_PRINT("router_handle: method=%s, path=%s\n", method, path);
-    int *matches = malloc(router->layer_count * sizeof(int));
-    int match_count = 0;
-    int route_match_count = 0;  // Count only non-middleware matches
+static void next_finish(NextContext *ctx) {
+    // on_complete may release the context, so the pin is read first
+    unsigned int *pin = ctx->pinned ? ctx->pin : NULL;
+    if (ctx->route_match_count == 0) {
+        router_send_unmatched(ctx->client_fd, ctx->allowed, ctx->arena);
+    }
+    if (ctx->on_complete) {
+        ctx->on_complete(ctx);
+    }
+    if (pin) {
+        __atomic_sub_fetch(pin, 1, __ATOMIC_RELEASE);
+    }
+}
+
+int next_run(NextContext *ctx) {
+    int more = 1;
+    ctx->running = 1;
+    do {
+        ctx->next_called = 0;
+        more = ctx->advance(ctx);
+    } while (more && ctx->next_called && !ctx->paused);
+    ctx->running = 0;
     
-    for (int i = 0; i < router->layer_count; i++) {
-        if (layer_match(&router->layers[i], method, path)) {
-            matches[match_count++] = i;
-            // Count non-middleware matches (routes that aren't "USE")
-            if (strcmp(router->layers[i].method, "USE") != 0) {
-                route_match_count++;
-            }
+    if (more && ctx->paused) {
+        DEBUG_PRINT("next_run: chain paused at step %d\n", ctx->idx);
+        if (ctx->req) ctx->req->paused_chain = ctx;
+        // Taken while the dispatch still keeps the table alive
+        if (ctx->pin && !ctx->pinned) {
+            __atomic_add_fetch(ctx->pin, 1, __ATOMIC_ACQ_REL);
+            ctx->pinned = 1;
         }
+        return 0;
     }
-    DEBUG_PRINT("router_handle: match_count=%d, route_match_count=%d\n", match_count, route_match_count);
+    next_finish(ctx);
+    return 1;
+}
+
+void next_handler(void *context) {
+    NextContext *ctx = (NextContext *)context;
+    ctx->paused = 0;
+    if (ctx->running) {
+        // Called from a handler: the loop in next_run picks up from here
+        ctx->next_called = 1;
+        return;
+    }
+    // Resuming a paused chain
+    if (ctx->req) ctx->req->paused_chain = NULL;
+    next_run(ctx);
+}
+
+int next_pause(void *context) {
+    NextContext *ctx = (NextContext *)context;
+    if (!ctx->req) return 0;
+    ctx->paused = 1;
+    return 1;
+}
+
+void next_complete(void *context) {
+    NextContext *ctx = (NextContext *)context;
+    DEBUG_PRINT("next_complete: finishing paused chain at step %d\n", ctx->idx);
+    ctx->paused = 0;
+    if (ctx->req) ctx->req->paused_chain = NULL;
+    next_finish(ctx);
+}
+
+void next_take(void *context) {
+    NextContext *ctx = (NextContext *)context;
+    ctx->route_match_count++;
+}
 
-    NextContext ctx = { router, NULL, matches, match_count, client_fd, 0, req, &route_match_count, NULL };
+void next_allow(void *context, unsigned int methods) {
+    NextContext *ctx = (NextContext *)context;
+    ctx->allowed |= methods;
+}
 
-    if (match_count > 0) {
-        next_handler(&ctx);
+int router_match(Router *router, const char *method, const char *path, LayerMatch *matches,
+                 int *route_match_count, Request *req) {
+    Arena *arena = req ? &req->arena : NULL;
+    int *candidates = arena ? arena_alloc(arena, router->layer_count * sizeof(int))
+                            : malloc(router->layer_count * sizeof(int));
+    ParamSlice dropped[REQUEST_MAX_ROUTE_SLICES];
+    int match_count = 0;
+    if (!candidates) return 0;
+    
+    // The request's method was parsed when its head was; other callers
+    // pass a plain string
+    HttpMethod method_id = req && method == req->method ? req->method_id
+                         : method ? http_method_parse(method, strlen(method)) : HTTP_METHOD_OTHER;
+    
+    // The tree narrows the layers down by path; the layer itself still
+    // checks the method and constraints and captures the parameters
+    int candidate_count = route_tree_candidates(router->tree, path, candidates);
+    const char *host = NULL;
+    size_t host_len = 0;
+    int host_read = 0;
+    for (int i = 0; i < candidate_count; i++) {
+        Layer *layer = &router->layers[candidates[i]];
+        if (layer->host) {
+            // Virtual hosts only take requests for their own name
+            if (!host_read) {
+                host = req ? req->get_header(req, "Host") : NULL;
+                host_len = vhost_host_length(host);
+                host_read = 1;
+            }
+            if (!host || !vhost_pattern_matches(layer->host, host, host_len)) continue;
+        }
+        int slice_start = req ? req->route_slice_count : 0;
+        ParamSlice *slices = req ? req->route_slices + slice_start : dropped;
+        int slice_count = 0;
         
-        // If we only had middleware matches but no route matches, send 404
-        if (route_match_count == 0) {
-            Response *res = create_response(client_fd);
-            response_set_header(res, "Content-Type", "application/json");
-            response_status(res, 404);
-            response_send(res, "{\"error\":\"Not Found\",\"message\":\"The requested endpoint was not found\"}");
-            destroy_response(res);
+        if (layer_match_slices(layer, method_id, method, path, slices, REQUEST_MAX_ROUTE_SLICES - slice_start,
+                               &slice_count, arena)) {
+            LayerMatch *match = &matches[match_count++];
+            match->layer = candidates[i];
+            match->slice_start = slice_start;
+            match->slice_count = req ? slice_count : 0;
+            if (req) req->route_slice_count += slice_count;
+            // Count route matches; a mounted router's are counted on entry
+            if (layer->type == LAYER_HANDLER) {
+                (*route_match_count)++;
+            }
         }
+    }
+    if (!arena) free(candidates);
+    return match_count;
+}
+
+unsigned int router_allowed_methods(Router *router, const char *path, Arena *arena) {
+    if (!router || router->layer_count == 0) return 0;
+    int *candidates = arena ? arena_alloc(arena, router->layer_count * sizeof(int))
+                            : malloc(router->layer_count * sizeof(int));
+    unsigned int allowed = 0;
+    if (!candidates) return 0;
+    
+    int candidate_count = route_tree_candidates(router->tree, path, candidates);
+    for (int i = 0; i < candidate_count; i++) {
+        Layer *layer = &router->layers[candidates[i]];
+        ParamSlice slices[REQUEST_MAX_ROUTE_SLICES];
+        int slice_count = 0;
+        if (layer->type == LAYER_HANDLER && (allowed | layer->methods) != allowed &&
+            layer_match_path(layer, path, slices, REQUEST_MAX_ROUTE_SLICES, &slice_count, arena)) {
+            allowed |= layer->methods;
+        }
+    }
+    if (!arena) free(candidates);
+    return allowed;
+}
+
+void router_send_unmatched(int client_fd, unsigned int allowed, Arena *arena) {
+    // Only the standard methods can be listed in Allow; a path served for
+    // extension methods alone is still a 404
+    allowed &= ~HTTP_METHOD_BIT(HTTP_METHOD_OTHER);
+    Response *res = create_response_in(client_fd, arena);
+    response_set_header(res, "Content-Type", "application/json");
+    if (allowed) {
+        char allow[96];
+        http_method_list(allowed, allow, sizeof(allow));
+        response_set_header(res, "Allow", allow);
+        response_status(res, 405);
+        response_send(res, "{\"error\":\"Method Not Allowed\",\"message\":\"The requested method is not supported for this endpoint\"}");
     } else {
-        // No matching routes found - send 404
-        Response *res = create_response(client_fd);
-        response_set_header(res, "Content-Type", "application/json");
         response_status(res, 404);
         response_send(res, "{\"error\":\"Not Found\",\"message\":\"The requested endpoint was not found\"}");
-        destroy_response(res);
     }
-    free(matches);
+    destroy_response(res);
+}
+
+// Everything a dispatch needs lives in the request (or, without one, on
+// this stack frame), so any number of threads can run requests through
+// the same router
+int router_handle(Router *router, const char *method, const char *path, int client_fd, Request *req) {
+    DEBUG_PRINT("router_handle: method=%s, path=%s\n", method, path);
+    NextContext local;
+    NextContext *ctx = next_context_create(router, NULL, client_fd, req, &local);
+    Arena *arena = ctx->arena;
+    ctx->matches = arena ? arena_alloc(arena, router->layer_count * sizeof(LayerMatch))
+                         : malloc(router->layer_count * sizeof(LayerMatch));
+    ctx->match_count = ctx->matches ? router_match(router, method, path, ctx->matches, &ctx->route_match_count, req)
+                                    : 0;
+    DEBUG_PRINT("router_handle: match_count=%d, route_match_count=%d\n", ctx->match_count, ctx->route_match_count);
+    
+    // Only middleware (or nothing) matched: 405 if another method would
+    // have, otherwise 404. The methods are collected before the chain runs,
+    // while the path is still valid.
+    ctx->allowed = ctx->route_match_count == 0 ? router_allowed_methods(router, path, arena) : 0;
+    ctx->advance = router_advance;
+    int completed = next_run(ctx);
+    next_context_release(ctx);
+    return completed;
 }
 
 // Router method implementations for independent routing
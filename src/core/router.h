@@ -2,6 +2,7 @@
 #define ROUTER_H
 
 #include "route.h"
+#include "route_tree.h"
 #include "../http/request.h"
 #include "../http/error.h"
 
@@ -9,6 +10,8 @@ struct Router {
     Layer *layers;
     int layer_count;
     int capacity;
+    RouteTree *tree;         // Path index over layers, built as they are added
+    struct RouteSnapshot *snapshot; // Patterns compiled ahead of time (router_set_snapshot)
     
     // Router methods (similar to App)
     void (*get)(struct Router *, const char *path, Handler handler);
@@ -22,30 +25,115 @@ struct Router {
 
 typedef struct Router Router;
 
-// Forward declaration for App
+// Forward declarations for App and frozen dispatch
 struct App;
+struct FrozenChain;
 
-// context for next middleware
+// A layer that matched the request, with its parameters in req->route_slices
 typedef struct {
+    int layer;
+    int slice_start;
+    int slice_count;
+} LayerMatch;
+
+// Where a chain was in a router when it entered one mounted in it: the
+// rest of the parent's layers run once the mounted router's run out
+typedef struct NextMount {
+    struct Router *router;
+    LayerMatch *matches;
+    int match_count;
+    int idx;
+    const char *path;
+    struct NextMount *parent;
+} NextMount;
+
+// context for next middleware
+typedef struct NextContext {
     struct Router *router;
     struct App *app;     // Reference to the app for error handling
-    int *matches;
+    LayerMatch *matches;
     int match_count;
     int client_fd;
     int idx;
     Request *req;        // Request object
     void *user_context; // holds Response* or other user context
     ErrorContext *error_ctx; // Error handling context
+    Arena *arena;        // Per-request arena (the Request's); reset once the chain completes
+    const struct FrozenChain *chain; // Steps walked instead of `matches` once the app is frozen
+    // Starts the handler of the next layer that runs; 0 at the end of the chain
+    int (*advance)(struct NextContext *ctx);
+    // Set by express_init: releases the request's state once the chain is over
+    void (*on_complete)(struct NextContext *ctx);
+    int route_match_count;   // Routes matched; none means a 404/405 at the end
+    unsigned int allowed;    // Methods for that 405, collected before the chain runs
+    int running;             // Inside next_run: next() only flags the step
+    int next_called;
+    int paused;
+    unsigned int *pin;       // Held while the chain is paused (the table it walks)
+    int pinned;
+    NextMount *mounts;       // Routers the chain is inside a mount of, innermost first
+    const char *path;        // The request path less the prefixes of the mounts the running layer is in
 } NextContext;
 
 // Router functions
 struct Router *create_router();
 void destroy_router(struct Router *router);
 void router_add_layer(struct Router *router, const char *method, const char *path, Handler handler);
-void router_handle(struct Router *router, const char *method, const char *path, int client_fd, Request *req);
+// Take the patterns of routes added from now on from `snapshot` (see
+// route_snapshot.h) when it has them, instead of compiling them. The
+// snapshot must stay open until the router is destroyed.
+void router_set_snapshot(struct Router *router, struct RouteSnapshot *snapshot);
+int router_handle(struct Router *router, const char *method, const char *path, int client_fd, Request *req);
 void router_use(struct Router *router, const char *path, Handler handler);
 void router_mount(struct Router *parent, const char *prefix, struct Router *child);
+// Mount `child` at the root for requests whose Host matches `host` (see
+// vhost.h for the patterns); other hosts skip it
+void router_vhost(struct Router *parent, const char *host, struct Router *child);
+// Layers matching this request, in order, with their parameters appended
+// to req->route_slices (req may be NULL: parameters are then dropped).
+// Returns the count and adds to *route_match_count the matches that are
+// routes (not middleware nor mounted routers).
+int router_match(struct Router *router, const char *method, const char *path, LayerMatch *matches,
+                 int *route_match_count, Request *req);
+// Methods of the handler layers whose path (constraints included) matches,
+// as an HTTP_METHOD_BIT mask
+unsigned int router_allowed_methods(struct Router *router, const char *path, Arena *arena);
+// Answer a request no route took: 405 with an Allow header listing
+// `allowed` (from router_allowed_methods), or 404 when it is empty
+void router_send_unmatched(int client_fd, unsigned int allowed, Arena *arena);
+// A zeroed context for one dispatch, in the request's arena so that a
+// paused chain outlives the caller's frame (`local` without a request)
+NextContext *next_context_create(struct Router *router, struct App *app, int client_fd, Request *req,
+                                 NextContext *local);
+// Free what an unfrozen dispatch allocated for a context made without a
+// request (nothing can pause such a chain); a no-op otherwise
+void next_context_release(NextContext *ctx);
+// The `next` handed to every handler. Handlers run one after another from
+// the loop in next_run rather than from inside each other's next(), so a
+// chain of any length takes constant stack; code after next() returns runs
+// before the handlers downstream of it.
 void next_handler(void *context);
+// Run the chain from ctx->idx until it ends or a handler pauses it. At the
+// end the 404/405 is sent if no route matched and on_complete runs, after
+// which ctx (allocated in the request arena) must not be touched. Returns
+// 1 when the chain completed, 0 when it is paused.
+int next_run(NextContext *ctx);
+// Called by a handler that returns without calling next() but wants the
+// chain kept open: app_handle_request returns 0 and whoever holds the
+// request later calls next(context) to resume it, or next_complete() to
+// finish it without the remaining handlers. Needs a request arena (where
+// the context lives); returns 0 when the chain cannot be paused.
+int next_pause(void *context);
+void next_complete(void *context);
+// For middleware that routes requests itself (route_table_dispatch):
+// next_take marks the request as taken by a route, so the chain ends
+// without a 404/405; next_allow adds the methods its routes would take the
+// path with, for the 405 when nothing takes it
+void next_take(void *context);
+void next_allow(void *context, unsigned int methods);
+// NextContext.advance for an unfrozen router: the next of ctx->matches,
+// entering mounted routers in place
+int router_advance(NextContext *ctx);
 
 // Router method implementations
 void router_get(struct Router *router, const char *path, Handler handler);
@@ -0,0 +1,491 @@
+#define _GNU_SOURCE
+#include "uring_loop.h"
+#include "event_loop.h"
+#include "app.h"
+#include "../debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#if C_EXPRESS_HAVE_IO_URING
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#if C_EXPRESS_HAVE_IO_URING && defined(IORING_ACCEPT_MULTISHOT)
+
+// Completion kinds, tagged into the low bits of user_data
+enum {
+    URING_OP_ACCEPT = 1,
+    URING_OP_RECV,
+    URING_OP_SEND,
+    URING_OP_CLOSE,
+    URING_OP_TIMER
+};
+#define URING_OP_MASK 7
+
+// A client connection and the submissions it has in flight
+typedef struct {
+    Connection *conn;
+    int recv_armed;         // One-shot recv outstanding
+    int sending;            // Send outstanding; out_buf must not move
+    int closing;            // Close submitted, freed when it completes
+} UringConnection;
+
+// Ring state for one thread
+typedef struct {
+    App *app;
+    int ring_fd;
+    int server_fd;
+    int accepted;           // A client was accepted, so multishot accept works
+
+    // Submission queue
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sq_pending;    // Filled in but not yet handed to the kernel
+    struct io_uring_sqe *sqes;
+
+    // Completion queue
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    // Receive buffers the kernel picks from (IORING_REGISTER_PBUF_RING)
+    struct io_uring_buf_ring *buf_ring;
+    char *buf_pool;
+    unsigned short buf_tail;
+
+    // Mappings to release on shutdown
+    void *sq_map;
+    size_t sq_map_size;
+    void *cq_map;
+    size_t cq_map_size;
+    size_t sqes_size;
+    size_t buf_ring_size;
+
+    struct __kernel_timespec tick;  // Idle sweep interval
+    ConnectionList idle;            // Open connections, least recently active first
+} UringLoop;
+
+static int uring_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(int ring_fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+// Hand a receive buffer (back) to the kernel
+static void uring_buf_recycle(UringLoop *loop, unsigned short bid) {
+    struct io_uring_buf *buf = &loop->buf_ring->bufs[loop->buf_tail & (URING_LOOP_BUF_COUNT - 1)];
+    buf->addr = (uint64_t)(uintptr_t)(loop->buf_pool + (size_t)bid * CONNECTION_READ_CHUNK);
+    buf->len = CONNECTION_READ_CHUNK;
+    buf->bid = bid;
+    loop->buf_tail++;
+    __atomic_store_n(&loop->buf_ring->tail, loop->buf_tail, __ATOMIC_RELEASE);
+}
+
+static void uring_close(UringLoop *loop) {
+    if (loop->ring_fd >= 0) close(loop->ring_fd);
+    if (loop->sqes && loop->sqes != MAP_FAILED) munmap(loop->sqes, loop->sqes_size);
+    if (loop->cq_map && loop->cq_map != MAP_FAILED && loop->cq_map != loop->sq_map) {
+        munmap(loop->cq_map, loop->cq_map_size);
+    }
+    if (loop->sq_map && loop->sq_map != MAP_FAILED) munmap(loop->sq_map, loop->sq_map_size);
+    if (loop->buf_ring && loop->buf_ring != MAP_FAILED) munmap(loop->buf_ring, loop->buf_ring_size);
+    free(loop->buf_pool);
+}
+
+// Create the ring, map its queues and register the provided-buffer ring
+static int uring_open(UringLoop *loop) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    loop->ring_fd = uring_setup(URING_LOOP_ENTRIES, &params);
+    if (loop->ring_fd < 0) {
+        DEBUG_PRINT("uring_open: io_uring_setup failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    loop->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    loop->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (loop->cq_map_size > loop->sq_map_size) loop->sq_map_size = loop->cq_map_size;
+        loop->cq_map_size = loop->sq_map_size;
+    }
+
+    loop->sq_map = mmap(NULL, loop->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        loop->ring_fd, IORING_OFF_SQ_RING);
+    if (loop->sq_map == MAP_FAILED) return -1;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        loop->cq_map = loop->sq_map;
+    } else {
+        loop->cq_map = mmap(NULL, loop->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            loop->ring_fd, IORING_OFF_CQ_RING);
+        if (loop->cq_map == MAP_FAILED) return -1;
+    }
+
+    loop->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    loop->sqes = mmap(NULL, loop->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      loop->ring_fd, IORING_OFF_SQES);
+    if (loop->sqes == MAP_FAILED) return -1;
+
+    char *sq = (char *)loop->sq_map;
+    char *cq = (char *)loop->cq_map;
+    loop->sq_head = (unsigned *)(sq + params.sq_off.head);
+    loop->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    loop->sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+    loop->sq_entries = params.sq_entries;
+    loop->cq_head = (unsigned *)(cq + params.cq_off.head);
+    loop->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    loop->cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+    loop->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    // SQE slots map one-to-one onto the submission array
+    unsigned *sq_array = (unsigned *)(sq + params.sq_off.array);
+    for (unsigned i = 0; i < loop->sq_entries; i++) {
+        sq_array[i] = i;
+    }
+
+    loop->buf_ring_size = URING_LOOP_BUF_COUNT * sizeof(struct io_uring_buf);
+    loop->buf_ring = mmap(NULL, loop->buf_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (loop->buf_ring == MAP_FAILED) return -1;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)loop->buf_ring;
+    reg.ring_entries = URING_LOOP_BUF_COUNT;
+    reg.bgid = URING_LOOP_BUF_GROUP;
+    if (uring_register(loop->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        DEBUG_PRINT("uring_open: provided-buffer ring unsupported: %s\n", strerror(errno));
+        return -1;
+    }
+
+    loop->buf_pool = malloc((size_t)URING_LOOP_BUF_COUNT * CONNECTION_READ_CHUNK);
+    if (!loop->buf_pool) return -1;
+    for (unsigned short bid = 0; bid < URING_LOOP_BUF_COUNT; bid++) {
+        uring_buf_recycle(loop, bid);
+    }
+
+    return 0;
+}
+
+// Hand pending submissions to the kernel, optionally waiting for completions
+static int uring_submit(UringLoop *loop, unsigned wait_for) {
+    int submitted = uring_enter(loop->ring_fd, loop->sq_pending, wait_for,
+                                wait_for ? IORING_ENTER_GETEVENTS : 0);
+    if (submitted < 0) return -1;
+    loop->sq_pending -= (unsigned)submitted;
+    return 0;
+}
+
+// Make sure `count` SQEs can be filled without an intervening submit,
+// so linked submissions land in the same batch
+static void uring_reserve(UringLoop *loop, unsigned count) {
+    unsigned head = __atomic_load_n(loop->sq_head, __ATOMIC_ACQUIRE);
+    if (*loop->sq_tail - head + count > loop->sq_entries) {
+        while (uring_submit(loop, 0) < 0 && errno == EINTR) {
+        }
+    }
+}
+
+// Next free SQE. The tail is published right away; the kernel only reads
+// the queue inside io_uring_enter on this thread, after the caller fills it.
+static struct io_uring_sqe *uring_get_sqe(UringLoop *loop) {
+    uring_reserve(loop, 1);
+
+    unsigned tail = *loop->sq_tail;
+    struct io_uring_sqe *sqe = &loop->sqes[tail & loop->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    __atomic_store_n(loop->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    loop->sq_pending++;
+    return sqe;
+}
+
+static uint64_t uring_tag(UringConnection *uc, int op) {
+    return (uint64_t)(uintptr_t)uc | (uint64_t)op;
+}
+
+// One submission keeps accepting until the kernel drops it (no CQE_F_MORE)
+static void uring_prep_accept(UringLoop *loop) {
+    struct io_uring_sqe *sqe = uring_get_sqe(loop);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = loop->server_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = uring_tag(NULL, URING_OP_ACCEPT);
+}
+
+// The kernel picks the receive buffer from the provided-buffer ring
+static void uring_prep_recv(UringLoop *loop, UringConnection *uc) {
+    struct io_uring_sqe *sqe = uring_get_sqe(loop);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = uc->conn->fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_LOOP_BUF_GROUP;
+    sqe->len = CONNECTION_READ_CHUNK;
+    sqe->user_data = uring_tag(uc, URING_OP_RECV);
+    uc->recv_armed = 1;
+}
+
+static void uring_prep_send(UringLoop *loop, UringConnection *uc, int link_close) {
+    Connection *conn = uc->conn;
+    struct io_uring_sqe *sqe = uring_get_sqe(loop);
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = conn->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(conn->out_buf + conn->out_pos);
+    sqe->len = (unsigned)(conn->out_len - conn->out_pos);
+    // MSG_WAITALL makes a short send break the link instead of closing early
+    sqe->msg_flags = MSG_NOSIGNAL | (link_close ? MSG_WAITALL : 0);
+    sqe->flags = link_close ? IOSQE_IO_LINK : 0;
+    sqe->user_data = uring_tag(uc, URING_OP_SEND);
+    uc->sending = 1;
+}
+
+static void uring_prep_close(UringLoop *loop, UringConnection *uc) {
+    struct io_uring_sqe *sqe = uring_get_sqe(loop);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = uc->conn->fd;
+    sqe->user_data = uring_tag(uc, URING_OP_CLOSE);
+    uc->closing = 1;
+    connection_list_remove(&loop->idle, uc->conn);
+}
+
+static void uring_prep_timer(UringLoop *loop) {
+    struct io_uring_sqe *sqe = uring_get_sqe(loop);
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uint64_t)(uintptr_t)&loop->tick;
+    sqe->len = 1;
+    sqe->user_data = uring_tag(NULL, URING_OP_TIMER);
+}
+
+static int uring_reading(Connection *conn) {
+    return conn->state != CONN_WRITING && conn->state != CONN_CLOSING;
+}
+
+// Dispatch whatever is complete and submit the next operations for a
+// connection. Requests are only dispatched while no send is in flight, so
+// the output queue never moves under the kernel; pipelined responses are
+// batched into a single send.
+static void uring_advance(UringLoop *loop, UringConnection *uc) {
+    Connection *conn = uc->conn;
+    if (uc->closing) return;
+
+    if (!uc->sending) {
+        while (uring_reading(conn) && connection_request_ready(conn) && !connection_output_full(conn)) {
+            event_loop_dispatch(loop->app, conn);
+            if (conn->state == CONN_WRITING && conn->keep_alive) {
+                connection_reset(conn);
+            }
+        }
+
+        if (connection_has_pending_output(conn)) {
+            if (uring_reading(conn)) {
+                uring_prep_send(loop, uc, 0);
+            } else {
+                // Last response: the close runs only once the send completes
+                uring_reserve(loop, 2);
+                uring_prep_send(loop, uc, 1);
+                uring_prep_close(loop, uc);
+                return;
+            }
+        } else if (!uring_reading(conn)) {
+            uring_prep_close(loop, uc);
+            return;
+        }
+    }
+
+    // A dispatched request may read its streamed body straight from the fd,
+    // so a recv is never left outstanding across a dispatch
+    if (!uc->recv_armed && uring_reading(conn) && !connection_request_ready(conn)) {
+        uring_prep_recv(loop, uc);
+    }
+}
+
+static void uring_handle_accept(UringLoop *loop, int res) {
+    if (res < 0) {
+        DEBUG_PRINT("uring_handle_accept: accept failed: %s\n", strerror(-res));
+        return;
+    }
+    loop->accepted = 1;
+
+    UringConnection *uc = malloc(sizeof(UringConnection));
+    Connection *conn = uc ? connection_create(res) : NULL;
+    if (!conn) {
+        free(uc);
+        close(res);
+        return;
+    }
+    memset(uc, 0, sizeof(UringConnection));
+    uc->conn = conn;
+
+    DEBUG_PRINT("uring_handle_accept: accepted client_fd=%d\n", res);
+    connection_list_touch(&loop->idle, conn, event_loop_now());
+    uring_advance(loop, uc);
+}
+
+static void uring_handle_recv(UringLoop *loop, UringConnection *uc, int res, unsigned flags) {
+    Connection *conn = uc->conn;
+    uc->recv_armed = 0;
+
+    if (flags & IORING_CQE_F_BUFFER) {
+        unsigned short bid = (unsigned short)(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (res > 0 && connection_append(conn, loop->buf_pool + (size_t)bid * CONNECTION_READ_CHUNK,
+                                         (size_t)res) != CONN_IO_OK) {
+            conn->state = CONN_CLOSING;
+        }
+        uring_buf_recycle(loop, bid);
+    }
+
+    if (res > 0) {
+        connection_list_touch(&loop->idle, conn, event_loop_now());
+    } else if (res != -ENOBUFS && res != -EINTR) {
+        // Peer closed, or the idle sweep shut the socket down
+        conn->state = CONN_CLOSING;
+    }
+
+    uring_advance(loop, uc);
+}
+
+static void uring_handle_send(UringLoop *loop, UringConnection *uc, int res) {
+    Connection *conn = uc->conn;
+    uc->sending = 0;
+    if (uc->closing) return;  // The linked close completes next
+
+    if (res < 0) {
+        DEBUG_PRINT("uring_handle_send: send failed on fd=%d: %s\n", conn->fd, strerror(-res));
+        conn->state = CONN_CLOSING;
+        conn->out_len = conn->out_pos = 0;
+    } else {
+        conn->out_pos += (size_t)res;
+        if (conn->out_pos >= conn->out_len) {
+            conn->out_len = conn->out_pos = 0;
+        }
+        connection_list_touch(&loop->idle, conn, event_loop_now());
+    }
+
+    uring_advance(loop, uc);
+}
+
+static void uring_handle_close(UringConnection *uc, int res) {
+    // A failed send cancels its linked close
+    if (res == -ECANCELED) {
+        close(uc->conn->fd);
+    }
+    DEBUG_PRINT("uring_handle_close: fd=%d after %d requests\n", uc->conn->fd, uc->conn->requests_served);
+    connection_destroy(uc->conn);
+    free(uc);
+}
+
+// Shut down connections idle for longer than the keep-alive timeout; their
+// outstanding recv then completes with 0 and the normal close path runs
+static void uring_expire_idle(UringLoop *loop) {
+    long timeout = loop->app->keep_alive_timeout > 0 ? loop->app->keep_alive_timeout : DEFAULT_KEEP_ALIVE_TIMEOUT;
+    long now = event_loop_now();
+
+    while (loop->idle.head && now - loop->idle.head->last_active >= timeout) {
+        Connection *conn = loop->idle.head;
+        connection_list_remove(&loop->idle, conn);
+        if (connection_has_pending_output(conn)) {
+            // Still draining responses to a slow reader; give it another period
+            connection_list_touch(&loop->idle, conn, now);
+            continue;
+        }
+        DEBUG_PRINT("uring_expire_idle: closing idle fd=%d\n", conn->fd);
+        shutdown(conn->fd, SHUT_RDWR);
+    }
+}
+
+int uring_loop_run(App *app, int server_fd) {
+    UringLoop loop;
+    memset(&loop, 0, sizeof(loop));
+    loop.app = app;
+    loop.server_fd = server_fd;
+    loop.ring_fd = -1;
+    loop.tick.tv_sec = 1;
+
+    if (uring_open(&loop) < 0) {
+        uring_close(&loop);
+        return -1;
+    }
+
+    uring_prep_accept(&loop);
+    uring_prep_timer(&loop);
+    DEBUG_PRINT("uring_loop_run: io_uring loop started on fd=%d\n", server_fd);
+
+    for (;;) {
+        // One syscall both submits the batch and waits for completions
+        if (uring_submit(&loop, 1) < 0) {
+            if (errno == EINTR) continue;
+            perror("io_uring_enter");
+            break;
+        }
+
+        unsigned head = *loop.cq_head;
+        unsigned tail = __atomic_load_n(loop.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &loop.cqes[head & loop.cq_mask];
+            uint64_t user_data = cqe->user_data;
+            int res = cqe->res;
+            unsigned flags = cqe->flags;
+
+            head++;
+            __atomic_store_n(loop.cq_head, head, __ATOMIC_RELEASE);
+
+            UringConnection *uc = (UringConnection *)(uintptr_t)(user_data & ~(uint64_t)URING_OP_MASK);
+            switch ((int)(user_data & URING_OP_MASK)) {
+                case URING_OP_ACCEPT:
+                    if (res < 0 && !loop.accepted && (res == -EINVAL || res == -EOPNOTSUPP)) {
+                        // Kernel predates multishot accept
+                        DEBUG_PRINT_STR("uring_loop_run: multishot accept unsupported\n");
+                        uring_close(&loop);
+                        return -1;
+                    }
+                    uring_handle_accept(&loop, res);
+                    if (!(flags & IORING_CQE_F_MORE)) {
+                        uring_prep_accept(&loop);
+                    }
+                    break;
+                case URING_OP_RECV:
+                    uring_handle_recv(&loop, uc, res, flags);
+                    break;
+                case URING_OP_SEND:
+                    uring_handle_send(&loop, uc, res);
+                    break;
+                case URING_OP_CLOSE:
+                    uring_handle_close(uc, res);
+                    break;
+                case URING_OP_TIMER:
+                    uring_expire_idle(&loop);
+                    uring_prep_timer(&loop);
+                    break;
+            }
+        }
+    }
+
+    uring_close(&loop);
+    return 0;
+}
+
+#else
+
+int uring_loop_run(App *app, int server_fd) {
+    (void)app;
+    (void)server_fd;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef URING_LOOP_H
+#define URING_LOOP_H
+
+// Forward declaration for App
+struct App;
+
+#define URING_LOOP_ENTRIES 256      // Submission queue depth
+#define URING_LOOP_BUF_COUNT 256    // Provided receive buffers (power of two)
+#define URING_LOOP_BUF_GROUP 1      // Buffer group id for the provided-buffer ring
+
+// io_uring is compiled in on Linux when the kernel headers know about
+// multishot accept; define C_EXPRESS_NO_IO_URING to leave it out entirely.
+#if defined(__linux__) && !defined(C_EXPRESS_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define C_EXPRESS_HAVE_IO_URING 1
+#endif
+#endif
+#ifndef C_EXPRESS_HAVE_IO_URING
+#define C_EXPRESS_HAVE_IO_URING 0
+#endif
+
+// Run an io_uring completion loop on an already listening socket.
+// Returns -1 if the kernel lacks the required features so the caller can
+// fall back to the epoll or blocking loop.
+int uring_loop_run(struct App *app, int server_fd);
+
+#endif
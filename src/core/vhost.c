@@ -0,0 +1,61 @@
+#define _GNU_SOURCE
+#include "vhost.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+char *vhost_pattern_normalize(const char *pattern) {
+    if (!pattern) return NULL;
+    size_t len = strlen(pattern);
+    if (len > 0 && pattern[len - 1] == '.') len--;
+    // A wildcard needs a name after "*."
+    if (len == 0 || (pattern[0] == '*' && (len < 3 || pattern[1] != '.'))) return NULL;
+    if (strchr(pattern + 1, '*')) return NULL;
+
+    char *copy = malloc(len + 1);
+    if (!copy) return NULL;
+    for (size_t i = 0; i < len; i++) copy[i] = (char)tolower((unsigned char)pattern[i]);
+    copy[len] = '\0';
+    return copy;
+}
+
+size_t vhost_host_length(const char *host) {
+    size_t len = 0;
+    if (!host) return 0;
+    if (host[0] == '[') {
+        // IPv6 literal: the port follows the bracket
+        const char *end = strchr(host, ']');
+        return end ? (size_t)(end - host) + 1 : strlen(host);
+    }
+    while (host[len] && host[len] != ':') len++;
+    if (len > 0 && host[len - 1] == '.') len--;
+    return len;
+}
+
+unsigned long vhost_hash(const char *name, size_t len) {
+    unsigned long hash = 14695981039346656037UL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)tolower((unsigned char)name[i]);
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+int vhost_pattern_matches(const char *pattern, const char *host, size_t host_len) {
+    size_t pattern_len = strlen(pattern);
+    if (pattern[0] != '*') {
+        return pattern_len == host_len && strncasecmp(pattern, host, host_len) == 0;
+    }
+    // "*.suffix": at least one label, then ".suffix"
+    size_t suffix_len = pattern_len - 1;
+    return host_len > suffix_len && strncasecmp(pattern + 1, host + host_len - suffix_len, suffix_len) == 0;
+}
+
+int vhost_pattern_covers(const char *pattern, const char *other) {
+    if (other[0] != '*') return vhost_pattern_matches(pattern, other, strlen(other));
+    if (pattern[0] != '*') return 0;
+    // Every subdomain of other's suffix is one of pattern's suffix
+    size_t pattern_len = strlen(pattern), other_len = strlen(other);
+    return other_len >= pattern_len && strcmp(other + other_len - (pattern_len - 1), pattern + 1) == 0;
+}
@@ -0,0 +1,28 @@
+#ifndef VHOST_H
+#define VHOST_H
+
+#include <stddef.h>
+
+// Host names for virtual hosts. Patterns are an exact name
+// ("api.example.com") or a wildcard over every subdomain, at any depth
+// ("*.example.com" takes "a.example.com" and "a.b.example.com" but not
+// "example.com"). Comparison ignores case.
+
+// Copy of a pattern as it is stored: lower case, without a trailing dot;
+// NULL when out of memory or not a valid pattern
+char *vhost_pattern_normalize(const char *pattern);
+
+// Length of the name in a Host header value, without its port and
+// trailing dot
+size_t vhost_host_length(const char *host);
+
+// Case-insensitive FNV-1a of a name
+unsigned long vhost_hash(const char *name, size_t len);
+
+// Does a (normalized) pattern take this host name?
+int vhost_pattern_matches(const char *pattern, const char *host, size_t host_len);
+
+// Does `pattern` take every host `other` takes? Both normalized.
+int vhost_pattern_covers(const char *pattern, const char *other);
+
+#endif
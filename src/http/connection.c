@@ -0,0 +1,375 @@
+#define _GNU_SOURCE
+#include "connection.h"
+#include "request.h"
+#include "../debug.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <poll.h>
+
+// Connection being dispatched on this thread (see connection_set_active)
+static __thread Connection *active_connection = NULL;
+
+Connection *connection_create(int fd) {
+    Connection *conn = malloc(sizeof(Connection));
+    if (!conn) return NULL;
+
+    memset(conn, 0, sizeof(Connection));
+    conn->fd = fd;
+    conn->state = CONN_READING_HEADERS;
+    http_parser_init(&conn->parser);
+
+    DEBUG_PRINT("connection_create: fd=%d\n", fd);
+    return conn;
+}
+
+void connection_destroy(Connection *conn) {
+    if (!conn) return;
+
+    if (active_connection == conn) {
+        active_connection = NULL;
+    }
+
+    free(conn->in_buf);
+    free(conn->out_buf);
+    free(conn);
+}
+
+// Make sure in_buf can hold `needed` bytes plus a NUL terminator
+static int connection_reserve_input(Connection *conn, size_t needed) {
+    if (needed + 1 <= conn->in_cap) return 0;
+
+    size_t new_cap = conn->in_cap ? conn->in_cap : CONNECTION_READ_CHUNK;
+    while (new_cap < needed + 1) new_cap *= 2;
+
+    char *new_buf = realloc(conn->in_buf, new_cap);
+    if (!new_buf) return -1;
+
+    conn->in_buf = new_buf;
+    conn->in_cap = new_cap;
+    return 0;
+}
+
+// Upper bound on buffered input for the request currently being read
+static size_t connection_input_limit(Connection *conn) {
+    if (!conn->header_len) return CONNECTION_MAX_HEADER_SIZE;
+    if (conn->use_streaming) return conn->in_len;  // Body is read on demand by the stream
+    return conn->header_len + conn->body_len;
+}
+
+ConnectionIO connection_fill(Connection *conn) {
+    int progressed = 0;
+
+    for (;;) {
+        size_t limit = connection_input_limit(conn);
+        if (conn->in_len >= limit) break;
+
+        size_t want = limit - conn->in_len;
+        if (want > CONNECTION_READ_CHUNK) want = CONNECTION_READ_CHUNK;
+        if (connection_reserve_input(conn, conn->in_len + want) < 0) {
+            return CONN_IO_ERROR;
+        }
+
+        ssize_t n = recv(conn->fd, conn->in_buf + conn->in_len, want, 0);
+        if (n > 0) {
+            conn->in_len += n;
+            conn->in_buf[conn->in_len] = '\0';
+            progressed = 1;
+
+            // Frame as soon as the head arrives so the limit can widen to the body
+            if (!conn->header_len && connection_parse_head(conn) < 0) {
+                return CONN_IO_ERROR;
+            }
+            continue;
+        }
+        if (n == 0) return CONN_IO_CLOSED;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return progressed ? CONN_IO_OK : CONN_IO_AGAIN;
+        }
+
+        DEBUG_PRINT("connection_fill: recv failed on fd=%d: %s\n", conn->fd, strerror(errno));
+        return CONN_IO_ERROR;
+    }
+
+    return CONN_IO_OK;
+}
+
+ConnectionIO connection_append(Connection *conn, const char *data, size_t len) {
+    // Never buffer more than one head's worth past the request being read
+    if (conn->in_len + len > connection_input_limit(conn) + CONNECTION_MAX_HEADER_SIZE) {
+        DEBUG_PRINT("connection_append: input backlog too large on fd=%d\n", conn->fd);
+        return CONN_IO_ERROR;
+    }
+    if (connection_reserve_input(conn, conn->in_len + len) < 0) {
+        return CONN_IO_ERROR;
+    }
+
+    memcpy(conn->in_buf + conn->in_len, data, len);
+    conn->in_len += len;
+    conn->in_buf[conn->in_len] = '\0';
+
+    if (!conn->header_len && connection_parse_head(conn) < 0) {
+        return CONN_IO_ERROR;
+    }
+    return CONN_IO_OK;
+}
+
+int connection_parse_head(Connection *conn) {
+    if (conn->header_len) return 1;
+    if (!conn->in_buf) return 0;
+
+    // The parser resumes where the last read left off
+    HttpParseResult result = http_parser_execute(&conn->parser, conn->in_buf, conn->in_len);
+    if (result == HTTP_PARSE_ERROR) {
+        DEBUG_PRINT("connection_parse_head: malformed request head on fd=%d\n", conn->fd);
+        conn->state = CONN_CLOSING;
+        return -1;
+    }
+    if (result == HTTP_PARSE_INCOMPLETE) {
+        if (conn->in_len >= CONNECTION_MAX_HEADER_SIZE) {
+            DEBUG_PRINT("connection_parse_head: headers exceed %d bytes on fd=%d\n",
+                   CONNECTION_MAX_HEADER_SIZE, conn->fd);
+            conn->state = CONN_CLOSING;
+            return -1;
+        }
+        return 0;
+    }
+
+    conn->header_len = conn->parser.consumed;
+    conn->body_len = conn->parser.has_content_length ? conn->parser.content_length : 0;
+    conn->use_streaming = 0;
+    conn->keep_alive = http_parser_keep_alive(&conn->parser);
+
+    if (conn->parser.chunked) {
+        conn->use_streaming = 1;
+        conn->body_len = 0;
+        DEBUG_PRINT_STR("connection_parse_head: chunked encoding detected, using streaming\n");
+    } else if (conn->body_len > MAX_BODY_SIZE) {
+        conn->use_streaming = 1;
+        DEBUG_PRINT("connection_parse_head: large body detected (%zu bytes), using streaming\n",
+               conn->body_len);
+    }
+
+    conn->state = conn->use_streaming || conn->body_len == 0 ? CONN_DISPATCHING : CONN_READING_BODY;
+    DEBUG_PRINT("connection_parse_head: fd=%d header_len=%zu body_len=%zu\n",
+           conn->fd, conn->header_len, conn->body_len);
+    return 1;
+}
+
+int connection_request_ready(Connection *conn) {
+    if (!conn->header_len) return 0;
+    if (conn->use_streaming) return 1;
+    return conn->in_len >= conn->header_len + conn->body_len;
+}
+
+int connection_wants_keep_alive(const char *head, size_t head_len) {
+    HttpParser parser;
+    http_parser_init(&parser);
+    if (http_parser_execute(&parser, head, head_len) != HTTP_PARSE_DONE) return 0;
+    return http_parser_keep_alive(&parser);
+}
+
+void connection_reset(Connection *conn) {
+    size_t consumed = conn->header_len + (conn->use_streaming ? 0 : conn->body_len);
+    if (consumed > conn->in_len) consumed = conn->in_len;
+
+    // Keep any bytes that already belong to the next request
+    size_t leftover = conn->in_len - consumed;
+    if (leftover > 0) {
+        memmove(conn->in_buf, conn->in_buf + consumed, leftover);
+    }
+    conn->in_len = leftover;
+    if (conn->in_buf) conn->in_buf[conn->in_len] = '\0';
+
+    http_parser_init(&conn->parser);
+    conn->header_len = 0;
+    conn->body_len = 0;
+    conn->use_streaming = 0;
+    conn->keep_alive = 0;
+    conn->state = CONN_READING_HEADERS;
+
+    if (leftover > 0 && connection_parse_head(conn) < 0) {
+        conn->state = CONN_CLOSING;
+    }
+}
+
+void connection_list_remove(ConnectionList *list, Connection *conn) {
+    if (conn->prev) conn->prev->next = conn->next;
+    else if (list->head == conn) list->head = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    else if (list->tail == conn) list->tail = conn->prev;
+    conn->prev = conn->next = NULL;
+}
+
+void connection_list_touch(ConnectionList *list, Connection *conn, long now) {
+    conn->last_active = now;
+    if (list->tail == conn) return;
+
+    connection_list_remove(list, conn);
+    conn->prev = list->tail;
+    if (list->tail) list->tail->next = conn;
+    else list->head = conn;
+    list->tail = conn;
+}
+
+int connection_queue(Connection *conn, const char *data, size_t len) {
+    if (!conn || !data || len == 0) return 0;
+
+    // Drop bytes a partial flush already sent before growing the buffer
+    if (conn->out_pos > 0 && conn->out_len + len > conn->out_cap) {
+        memmove(conn->out_buf, conn->out_buf + conn->out_pos, conn->out_len - conn->out_pos);
+        conn->out_len -= conn->out_pos;
+        conn->out_pos = 0;
+    }
+
+    if (conn->out_len + len > conn->out_cap) {
+        size_t new_cap = conn->out_cap ? conn->out_cap : CONNECTION_READ_CHUNK;
+        while (new_cap < conn->out_len + len) new_cap *= 2;
+
+        char *new_buf = realloc(conn->out_buf, new_cap);
+        if (!new_buf) return -1;
+
+        conn->out_buf = new_buf;
+        conn->out_cap = new_cap;
+    }
+
+    memcpy(conn->out_buf + conn->out_len, data, len);
+    conn->out_len += len;
+    conn->out_total += len;
+    return 0;
+}
+
+// Queue what is left of `iov` once its first `skip` bytes are sent
+static int connection_queue_iov(Connection *conn, const struct iovec *iov, int iovcnt, size_t skip) {
+    for (int i = 0; i < iovcnt; i++) {
+        if (skip >= iov[i].iov_len) {
+            skip -= iov[i].iov_len;
+            continue;
+        }
+        if (connection_queue(conn, (const char *)iov[i].iov_base + skip, iov[i].iov_len - skip) < 0) return -1;
+        skip = 0;
+    }
+    return 0;
+}
+
+ConnectionIO connection_flush(Connection *conn) {
+    while (conn->out_pos < conn->out_len) {
+        ssize_t n = send(conn->fd, conn->out_buf + conn->out_pos,
+                         conn->out_len - conn->out_pos, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn->out_pos += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return CONN_IO_AGAIN;
+
+        DEBUG_PRINT("connection_flush: send failed on fd=%d\n", conn->fd);
+        return CONN_IO_ERROR;
+    }
+
+    conn->out_len = 0;
+    conn->out_pos = 0;
+    return CONN_IO_OK;
+}
+
+int connection_has_pending_output(Connection *conn) {
+    return conn && conn->out_pos < conn->out_len;
+}
+
+int connection_output_full(Connection *conn) {
+    return conn->out_len - conn->out_pos >= CONNECTION_MAX_PENDING_OUTPUT;
+}
+
+void connection_set_active(Connection *conn) {
+    active_connection = conn;
+}
+
+Connection *connection_get_active(void) {
+    return active_connection;
+}
+
+// One non-blocking gathered send on a loop-owned socket: the loop thread
+// must never wait on a slow client. Returns the bytes sent (0 on EAGAIN).
+static ssize_t connection_send_now(Connection *conn, const struct iovec *iov, int iovcnt) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (struct iovec *)iov;
+    msg.msg_iovlen = iovcnt;
+    for (;;) {
+        ssize_t n = sendmsg(conn->fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n >= 0) return n;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+        DEBUG_PRINT("connection_send_now: sendmsg failed on fd=%d\n", conn->fd);
+        return -1;
+    }
+}
+
+// Write every byte to an fd no event loop owns, resuming after short
+// writes and waiting out EAGAIN on a non-blocking one
+static ssize_t connection_write_all(int fd, const struct iovec *iov, int iovcnt) {
+    struct iovec left[CONNECTION_MAX_IOV];
+    memcpy(left, iov, iovcnt * sizeof(struct iovec));
+    struct iovec *next = left;
+    size_t sent = 0;
+
+    for (;;) {
+        while (iovcnt > 0 && next->iov_len == 0) {
+            next++;
+            iovcnt--;
+        }
+        if (iovcnt == 0) return (ssize_t)sent;
+
+        ssize_t n = writev(fd, next, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = { fd, POLLOUT, 0 };
+                if (poll(&pfd, 1, -1) >= 0 || errno == EINTR) continue;
+            }
+            return -1;
+        }
+        if (n == 0) return -1;
+
+        sent += (size_t)n;
+        while ((size_t)n >= next->iov_len) {
+            n -= (ssize_t)next->iov_len;
+            next++;
+            iovcnt--;
+            if (iovcnt == 0) return (ssize_t)sent;
+        }
+        next->iov_base = (char *)next->iov_base + n;
+        next->iov_len -= (size_t)n;
+    }
+}
+
+ssize_t connection_sendv(int fd, const struct iovec *iov, int iovcnt) {
+    if (iovcnt < 0 || iovcnt > CONNECTION_MAX_IOV) return -1;
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++) total += iov[i].iov_len;
+
+    Connection *conn = active_connection;
+    if (!conn || conn->fd != fd) {
+        return connection_write_all(fd, iov, iovcnt);
+    }
+
+    // Output already queued must go first, and small responses cost less
+    // to copy than to send on their own before the batch is flushed
+    size_t sent = 0;
+    if (total >= CONNECTION_DIRECT_SEND_MIN && !connection_has_pending_output(conn)) {
+        ssize_t n = connection_send_now(conn, iov, iovcnt);
+        if (n < 0) return -1;
+        sent = (size_t)n;
+        conn->out_total += sent;
+        DEBUG_PRINT("connection_sendv: wrote %zu of %zu bytes on fd=%d\n", sent, total, fd);
+    }
+    return connection_queue_iov(conn, iov, iovcnt, sent) == 0 ? (ssize_t)total : -1;
+}
+
+ssize_t connection_send(int fd, const char *data, size_t len) {
+    struct iovec iov = { (void *)data, len };
+    return connection_sendv(fd, &iov, 1);
+}
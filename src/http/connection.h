@@ -0,0 +1,116 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "../parsers/http_parser.h"
+
+#define CONNECTION_READ_CHUNK 4096          // Bytes requested per read() call
+#define CONNECTION_MAX_HEADER_SIZE 8192     // Largest accepted request head
+#define CONNECTION_MAX_PENDING_OUTPUT 65536 // Unsent bytes before pipelined dispatch pauses
+#define CONNECTION_DIRECT_SEND_MIN 16384    // Responses this large are written during dispatch, not copied
+#define CONNECTION_MAX_IOV 8                // Buffers per connection_sendv() call
+
+// Per-connection state machine
+typedef enum {
+    CONN_READING_HEADERS,  // Waiting for the end of the request head
+    CONN_READING_BODY,     // Headers parsed, waiting for Content-Length bytes
+    CONN_DISPATCHING,      // Complete request handed to the app
+    CONN_WRITING,          // Response queued, flushing to the socket
+    CONN_CLOSING           // Done (or failed), connection will be closed
+} ConnectionState;
+
+// Result of a non-blocking read/write attempt
+typedef enum {
+    CONN_IO_OK,            // Progress was made
+    CONN_IO_AGAIN,         // Socket would block, wait for readiness
+    CONN_IO_CLOSED,        // Peer closed the connection
+    CONN_IO_ERROR          // Socket or allocation error
+} ConnectionIO;
+
+// A client connection owned by the event loop
+typedef struct Connection {
+    int fd;
+    ConnectionState state;
+
+    // Inbound bytes (request head and body)
+    char *in_buf;
+    size_t in_len;
+    size_t in_cap;
+
+    // Framing of the request currently being read
+    HttpParser parser;      // Resumes across reads; its slices index in_buf
+    size_t header_len;      // Bytes up to and including the blank line (0 until known)
+    size_t body_len;        // Declared Content-Length
+    int use_streaming;      // Body is chunked or too large to buffer
+
+    // Outbound bytes queued by response_send(), in request order
+    char *out_buf;
+    size_t out_len;
+    size_t out_pos;
+    size_t out_cap;
+    size_t out_total;       // Bytes ever handed to connection_send(v), queued or written
+
+    // Persistent connection (keep-alive) state
+    int keep_alive;         // Stay open after the current response
+    int requests_served;
+    long last_active;       // Monotonic seconds of the last socket activity
+
+    // Event loop idle list, least recently active first
+    struct Connection *prev;
+    struct Connection *next;
+} Connection;
+
+// Connections ordered by last activity, used to expire idle keep-alive sockets
+typedef struct {
+    Connection *head;       // Least recently active
+    Connection *tail;       // Most recently active
+} ConnectionList;
+
+// Lifecycle
+Connection *connection_create(int fd);
+void connection_destroy(Connection *conn);
+
+// Inbound: drain the socket into in_buf, then frame the request
+ConnectionIO connection_fill(Connection *conn);
+int connection_parse_head(Connection *conn);
+int connection_request_ready(Connection *conn);
+
+// Inbound for completion-based backends: the bytes were already received
+// into a kernel-provided buffer and are appended, then framed
+ConnectionIO connection_append(Connection *conn, const char *data, size_t len);
+
+// Keep-alive: HTTP/1.1 defaults to persistent, HTTP/1.0 to close, and an
+// explicit Connection header overrides either
+int connection_wants_keep_alive(const char *head, size_t head_len);
+
+// Drop the request just served and get ready to read the next one
+void connection_reset(Connection *conn);
+
+// Idle tracking: stamp last_active with `now` and move to the tail
+void connection_list_touch(ConnectionList *list, Connection *conn, long now);
+void connection_list_remove(ConnectionList *list, Connection *conn);
+
+// Outbound: queue response bytes and write them out
+int connection_queue(Connection *conn, const char *data, size_t len);
+ConnectionIO connection_flush(Connection *conn);
+int connection_has_pending_output(Connection *conn);
+int connection_output_full(Connection *conn);
+
+// The connection currently being dispatched on this thread. While set,
+// connection_send() queues bytes for its fd instead of writing directly.
+void connection_set_active(Connection *conn);
+Connection *connection_get_active(void);
+
+// Send bytes to a client fd (queued if an event loop owns the fd)
+ssize_t connection_send(int fd, const char *data, size_t len);
+// Send up to CONNECTION_MAX_IOV buffers as one write. On the connection
+// being dispatched, small sends (and any behind output still queued) are
+// queued for the loop to flush with the rest of the batch; larger ones are
+// written at once with a single non-blocking sendmsg, and whatever a short
+// write or EAGAIN leaves is queued. Without an event loop every byte is
+// written with writev before returning. Returns the bytes taken, or -1.
+ssize_t connection_sendv(int fd, const struct iovec *iov, int iovcnt);
+
+#endif
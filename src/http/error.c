@@ -1,5 +1,6 @@
 #include "error.h"
 #include "../debug.h"
+#include "../core/arena.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -23,9 +24,15 @@ const char *error_get_status_text(ErrorCode code) {
 }
 
 Error *create_error(ErrorCode code, const char *message, const char *file, int line, const char *function) {
-    Error *error = malloc(sizeof(Error));
+    return create_error_in(NULL, code, message, file, line, function);
+}
+
+Error *create_error_in(struct Arena *arena, ErrorCode code, const char *message,
+                       const char *file, int line, const char *function) {
+    Error *error = arena ? arena_alloc(arena, sizeof(Error)) : malloc(sizeof(Error));
     if (!error) return NULL;
     
+    error->in_arena = arena != NULL;
     error->code = code;
     error->status_code = (int)code;
     error->is_handled = false;
@@ -53,7 +60,7 @@ Error *create_error(ErrorCode code, const char *message, const char *file, int l
 }
 
 void destroy_error(Error *error) {
-    if (error) {
+    if (error && !error->in_arena) {
         free(error);
     }
 }
@@ -73,12 +80,17 @@ void error_set_stack_trace(Error *error, const char *stack_trace) {
 }
 
 ErrorContext *create_error_context() {
-    ErrorContext *ctx = malloc(sizeof(ErrorContext));
+    return create_error_context_in(NULL);
+}
+
+ErrorContext *create_error_context_in(struct Arena *arena) {
+    ErrorContext *ctx = arena ? arena_alloc(arena, sizeof(ErrorContext)) : malloc(sizeof(ErrorContext));
     if (!ctx) return NULL;
     
     ctx->current_error = NULL;
     ctx->has_error = false;
     ctx->error_handler = NULL;
+    ctx->arena = arena;
     
     return ctx;
 }
@@ -88,7 +100,7 @@ void destroy_error_context(ErrorContext *ctx) {
         if (ctx->current_error) {
             destroy_error(ctx->current_error);
         }
-        free(ctx);
+        if (!ctx->arena) free(ctx);
     }
 }
 
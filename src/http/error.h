@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+struct Arena;
+
 #define MAX_ERROR_MESSAGE 512
 #define MAX_STACK_TRACE 1024
 
@@ -30,6 +32,7 @@ typedef struct {
     const char *file;
     int line;
     const char *function;
+    bool in_arena;              // Lives in a request arena: destroy_error leaves it
 } Error;
 
 // Error handling context
@@ -37,10 +40,13 @@ typedef struct {
     Error *current_error;
     bool has_error;
     void (*error_handler)(Error *error, void *context);
+    struct Arena *arena;        // Request arena for this context and its errors (NULL = heap)
 } ErrorContext;
 
 // Error handling functions
 Error *create_error(ErrorCode code, const char *message, const char *file, int line, const char *function);
+Error *create_error_in(struct Arena *arena, ErrorCode code, const char *message,
+                       const char *file, int line, const char *function);
 void destroy_error(Error *error);
 void error_set_message(Error *error, const char *message);
 void error_set_stack_trace(Error *error, const char *stack_trace);
@@ -48,6 +54,7 @@ const char *error_get_status_text(ErrorCode code);
 
 // Error context functions
 ErrorContext *create_error_context();
+ErrorContext *create_error_context_in(struct Arena *arena);
 void destroy_error_context(ErrorContext *ctx);
 void error_context_set_error(ErrorContext *ctx, Error *error);
 void error_context_clear(ErrorContext *ctx);
@@ -55,7 +62,7 @@ bool error_context_has_error(ErrorContext *ctx);
 
 // Macros for easier error handling
 #define THROW_ERROR(ctx, code, msg) do { \
-    Error *_err = create_error(code, msg, __FILE__, __LINE__, __func__); \
+    Error *_err = create_error_in((ctx) ? (ctx)->arena : NULL, code, msg, __FILE__, __LINE__, __func__); \
     error_context_set_error(ctx, _err); \
 } while(0)
 
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include "negotiation.h"
 #include "../debug.h"
 #include <stdio.h>
@@ -105,9 +106,10 @@ static int compare_accept_types(const void *a, const void *b) {
 }
 
 ContentNegotiation* parse_accept_header(Request *req) {
-    ContentNegotiation *negotiation = malloc(sizeof(ContentNegotiation));
+    ContentNegotiation *negotiation = arena_alloc(&req->arena, sizeof(ContentNegotiation));
     if (!negotiation) return NULL;
     
+    negotiation->in_arena = 1;
     negotiation->accept_count = 0;
     negotiation->preferred_language[0] = '\0';
     negotiation->preferred_encoding[0] = '\0';
@@ -129,11 +131,12 @@ ContentNegotiation* parse_accept_header(Request *req) {
     strncpy(buffer, accept_header, sizeof(buffer) - 1);
     buffer[sizeof(buffer) - 1] = '\0';
     
-    char *token = strtok(buffer, ",");
+    char *saveptr = NULL;
+    char *token = strtok_r(buffer, ",", &saveptr);
     while (token && negotiation->accept_count < MAX_ACCEPT_TYPES) {
         parse_media_type(token, &negotiation->accept_types[negotiation->accept_count]);
         negotiation->accept_count++;
-        token = strtok(NULL, ",");
+        token = strtok_r(NULL, ",", &saveptr);
     }
     
     // Sort by quality and specificity
@@ -395,7 +398,7 @@ char* format_response_data(ContentType type, const char *data) {
 }
 
 void free_content_negotiation(ContentNegotiation *negotiation) {
-    if (negotiation) {
+    if (negotiation && !negotiation->in_arena) {
         free(negotiation);
     }
 }
@@ -445,7 +448,7 @@ const char* get_preferred_content_type(Request *req, const char **available_type
     const char *chosen_type = negotiate_content_type(negotiation, available_types, count);
     
     // Clean up
-    free(negotiation);
+    free_content_negotiation(negotiation);
     
     return chosen_type ? chosen_type : "application/json";
 }
@@ -24,6 +24,7 @@ typedef struct {
     char preferred_language[64];
     char preferred_encoding[64];
     char preferred_charset[64];
+    int in_arena;                            // Allocated from the request arena
 } ContentNegotiation;
 
 // Content type definitions for common formats
@@ -50,7 +51,8 @@ typedef struct {
 
 // Function declarations
 
-// Parse Accept header and build negotiation context
+// Parse Accept header and build negotiation context (allocated from the
+// request arena; free_content_negotiation is still safe to call)
 ContentNegotiation* parse_accept_header(Request *req);
 
 // Find best matching content type from available options
@@ -6,6 +6,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// Slot for entry `count` of an array that starts in `inline_entries`. The
+// array moves to the arena, sized for `max` entries, once the inline slots
+// are full. Returns NULL at `max`.
+static KeyValue *request_next_entry(Request *req, KeyValue **entries, KeyValue *inline_entries,
+                                    int inline_count, int count, int max) {
+    if (count >= max) return NULL;
+    if (count == inline_count && *entries == inline_entries) {
+        KeyValue *spilled = arena_alloc(&req->arena, (size_t)max * sizeof(KeyValue));
+        if (!spilled) return NULL;
+        memcpy(spilled, inline_entries, (size_t)count * sizeof(KeyValue));
+        *entries = spilled;
+    }
+    return &(*entries)[count];
+}
+
 // Helper function to get header value
 const char* request_get_header(Request *req, const char *key) {
     for (int i = 0; i < req->header_count; i++) {
@@ -58,78 +73,37 @@ void url_decode(char *dst, const char *src) {
     *p = '\0';
 }
 
-// Parse query string into key-value pairs
-void parse_query_string(const char *query_string, KeyValue *query_params, int *query_count) {
-    *query_count = 0;
+// Parse query string into key-value pairs. The string is copied once into
+// the arena and split and decoded in place there.
+void parse_query_string(Request *req, const char *query_string) {
+    req->query_count = 0;
     if (!query_string || strlen(query_string) == 0) {
         return;
     }
     
-    char *query_copy = strdup(query_string);
-    char *pair = strtok(query_copy, "&");
+    char *query_copy = arena_strdup(&req->arena, query_string);
+    if (!query_copy) return;
+    char *saveptr = NULL;
+    char *pair = strtok_r(query_copy, "&", &saveptr);
     
-    while (pair && *query_count < MAX_QUERY_PARAMS) {
+    while (pair) {
+        KeyValue *entry = request_next_entry(req, &req->query, req->query_inline, REQUEST_INLINE_QUERY,
+                                             req->query_count, MAX_QUERY_PARAMS);
+        if (!entry) break;
+        
+        // Decoding never lengthens a string, so it can run in place
         char *equals = strchr(pair, '=');
         if (equals) {
             *equals = '\0';
-            url_decode(query_params[*query_count].key, pair);
-            url_decode(query_params[*query_count].value, equals + 1);
+            url_decode(equals + 1, equals + 1);
+            entry->value = equals + 1;
         } else {
-            url_decode(query_params[*query_count].key, pair);
-            query_params[*query_count].value[0] = '\0';
-        }
-        (*query_count)++;
-        pair = strtok(NULL, "&");
-    }
-    
-    free(query_copy);
-}
-
-// Parse HTTP headers from raw request
-void parse_headers(const char *raw_request, KeyValue *headers, int *header_count) {
-    *header_count = 0;
-    
-    // Skip the first line (HTTP method line)
-    const char *line_start = strchr(raw_request, '\n');
-    if (!line_start) return;
-    line_start++; // Skip the newline
-    
-    while (line_start && *line_start && *header_count < MAX_HEADERS) {
-        const char *line_end = strchr(line_start, '\r');
-        if (!line_end) line_end = strchr(line_start, '\n');
-        if (!line_end) break;
-        
-        // Empty line indicates end of headers
-        if (line_end == line_start || (line_end == line_start + 1 && *line_start == '\r')) {
-            break;
-        }
-        
-        // Find the colon separator
-        const char *colon = strchr(line_start, ':');
-        if (colon && colon < line_end) {
-            int key_len = colon - line_start;
-            const char *value_start = colon + 1;
-            
-            // Skip whitespace after colon
-            while (value_start < line_end && (*value_start == ' ' || *value_start == '\t')) {
-                value_start++;
-            }
-            
-            int value_len = line_end - value_start;
-            
-            if (key_len < MAX_PARAM_SIZE && value_len < MAX_PARAM_SIZE) {
-                strncpy(headers[*header_count].key, line_start, key_len);
-                headers[*header_count].key[key_len] = '\0';
-                strncpy(headers[*header_count].value, value_start, value_len);
-                headers[*header_count].value[value_len] = '\0';
-                (*header_count)++;
-            }
+            entry->value = "";
         }
-        
-        // Move to next line
-        line_start = line_end;
-        if (*line_start == '\r') line_start++;
-        if (*line_start == '\n') line_start++;
+        url_decode(pair, pair);
+        entry->key = pair;
+        req->query_count++;
+        pair = strtok_r(NULL, "&", &saveptr);
     }
 }
 
@@ -163,7 +137,7 @@ void request_parse_params(Request *req, const char *route_pattern, const char *a
     int pattern_pos = 0, path_pos = 0;
     char pattern_segment[64], path_segment[64];
     
-    while (req->param_count < MAX_PARAMS) {
+    while (1) {
         const char *p_seg = get_next_segment_req(route_pattern, &pattern_pos, pattern_segment, sizeof(pattern_segment));
         const char *path_seg = get_next_segment_req(actual_path, &path_pos, path_segment, sizeof(path_segment));
         
@@ -175,21 +149,42 @@ void request_parse_params(Request *req, const char *route_pattern, const char *a
         
         if (p_seg[0] == ':') {
             // This is a parameter
-            strncpy(req->params[req->param_count].key, p_seg + 1, MAX_PARAM_SIZE - 1);
-            req->params[req->param_count].key[MAX_PARAM_SIZE - 1] = '\0';
+            KeyValue *entry = request_next_entry(req, &req->params, req->params_inline, REQUEST_INLINE_PARAMS,
+                                                 req->param_count, MAX_PARAMS);
+            char *value = arena_strdup(&req->arena, path_seg);
+            if (!entry || !value) break;
             
-            url_decode(req->params[req->param_count].value, path_seg);
+            url_decode(value, value);
+            entry->key = arena_strdup(&req->arena, p_seg + 1);
+            entry->value = value;
+            if (!entry->key) break;
             req->param_count++;
         }
     }
 }
 
-// Initialize request from raw HTTP data
-void request_init(Request *req, int client_fd, const char *raw_request) {
+// Reset every field and attach the helper functions
+static void request_init_fields(Request *req, int client_fd) {
     req->client_fd = client_fd;
+    req->method = "";
+    req->method_id = HTTP_METHOD_OTHER;
+    req->path = "";
+    req->query_string = "";
     req->header_count = 0;
+    req->head_storage = NULL;
     req->param_count = 0;
+    req->route_slice_count = 0;
+    req->paused_chain = NULL;
     req->query_count = 0;
+    req->headers = req->headers_inline;
+    req->params = req->params_inline;
+    req->query = req->query_inline;
+    
+    // Empty body until one is copied in
+    arena_init(&req->arena, req->arena_inline, sizeof(req->arena_inline));
+    req->body = arena_alloc(&req->arena, 1);
+    req->body[0] = '\0';
+    req->body_len = 0;
     
     // Initialize JSON fields
     req->parsed_json = NULL;
@@ -197,7 +192,7 @@ void request_init(Request *req, int client_fd, const char *raw_request) {
     req->json_error = NULL;
     
     // Initialize form data fields
-    form_data_init(&req->form_data);
+    req->form_data = NULL;
     req->form_parsed = 0;
     
     // Initialize streaming fields
@@ -232,67 +227,86 @@ void request_init(Request *req, int client_fd, const char *raw_request) {
     req->get_temp_file = request_get_temp_file;
     req->save_body_to_file = request_save_body_to_file;
     req->get_body_size = request_get_body_size;
-    
-    // Parse the first line to get method and path
-    char first_line[512];
-    const char *line_end = strchr(raw_request, '\r');
-    if (!line_end) line_end = strchr(raw_request, '\n');
-    if (!line_end) return;
-    
-    int line_len = line_end - raw_request;
-    if ((size_t)line_len >= sizeof(first_line)) line_len = sizeof(first_line) - 1;
-    strncpy(first_line, raw_request, line_len);
-    first_line[line_len] = '\0';
-    
-    // Parse method, path, and query string
-    char full_path[512];
-    sscanf(first_line, "%7s %511s", req->method, full_path);
-    
-    // Split path and query string
-    char *query_start = strchr(full_path, '?');
-    if (query_start) {
-        *query_start = '\0';
-        strncpy(req->query_string, query_start + 1, sizeof(req->query_string) - 1);
-        req->query_string[sizeof(req->query_string) - 1] = '\0';
-        parse_query_string(req->query_string, req->query, &req->query_count);
-    } else {
-        req->query_string[0] = '\0';
+}
+
+// Terminate a parsed slice in place and return it as a C string. The byte
+// after every slice is a delimiter (space, '?', ':', CR or LF).
+static const char *request_slice(char *head, HttpSlice slice) {
+    head[slice.offset + slice.length] = '\0';
+    return head + slice.offset;
+}
+
+static void request_apply_head(Request *req, char *head, const HttpParser *parser) {
+    req->method = request_slice(head, parser->method);
+    req->method_id = http_method_parse(req->method, parser->method.length);
+    req->path = request_slice(head, parser->path);
+    req->query_string = request_slice(head, parser->query);
+    parse_query_string(req, req->query_string);
+
+    for (int i = 0; i < parser->header_count; i++) {
+        RequestHeader *header = request_next_entry(req, &req->headers, req->headers_inline,
+                                                   REQUEST_INLINE_HEADERS, req->header_count, MAX_HEADERS);
+        if (!header) break;
+        header->key = request_slice(head, parser->headers[i].name);
+        header->value = request_slice(head, parser->headers[i].value);
+        req->header_count++;
     }
+}
+
+static void request_copy_body(Request *req, const char *body, size_t body_len) {
+    size_t max_copy = body_len < MAX_BODY_SIZE ? body_len : MAX_BODY_SIZE;
+    if (!body || max_copy == 0) return;
     
-    strncpy(req->path, full_path, sizeof(req->path) - 1);
-    req->path[sizeof(req->path) - 1] = '\0';
-    
-    // Parse headers
-    parse_headers(raw_request, req->headers, &req->header_count);
-    
-    // Parse body (handle both \r\n\r\n and \n\n patterns)
-    DEBUG_PRINT("Looking for body separator in raw_request (first 200 chars): %.200s\n", raw_request);
-    const char *body_start = strstr(raw_request, "\r\n\r\n");
-    if (body_start) {
-        body_start += 4; // Skip \r\n\r\n
-        DEBUG_PRINT_STR("Found \\r\\n\\r\\n separator\n");
-    } else {
-        body_start = strstr(raw_request, "\n\n");
-        if (body_start) {
-            body_start += 2; // Skip \n\n
-            DEBUG_PRINT_STR("Found \\n\\n separator\n");
-        } else {
-            DEBUG_PRINT_STR("No body separator found\n");
-        }
+    char *copy = arena_alloc(&req->arena, max_copy + 1);
+    if (!copy) return;
+    memcpy(copy, body, max_copy);
+    copy[max_copy] = '\0';
+    req->body = copy;
+    req->body_len = max_copy;
+    DEBUG_PRINT("Parsed body length: %zu (original: %zu)\n", max_copy, body_len);
+}
+
+void request_init_parsed(Request *req, int client_fd, char *head, const HttpParser *parser,
+                         const char *body, size_t body_len) {
+    request_init_fields(req, client_fd);
+    request_apply_head(req, head, parser);
+    request_copy_body(req, body, body_len);
+
+    DEBUG_PRINT("request_init_parsed: method=%s, path=%s, query=%s\n",
+           req->method, req->path, req->query_string);
+}
+
+// Initialize request from raw HTTP data
+void request_init(Request *req, int client_fd, const char *raw_request) {
+    request_init_fields(req, client_fd);
+    if (!raw_request) return;
+
+    HttpParser parser;
+    size_t raw_len = strlen(raw_request);
+    http_parser_init(&parser);
+    HttpParseResult result = http_parser_execute(&parser, raw_request, raw_len);
+    if (result == HTTP_PARSE_ERROR) {
+        DEBUG_PRINT_STR("request_init: malformed request head\n");
+        return;
     }
-    
-    if (body_start) {
-        size_t body_len = strlen(body_start);
-        size_t max_copy = (body_len < MAX_BODY_SIZE - 1) ? body_len : MAX_BODY_SIZE - 1;
-        strncpy(req->body, body_start, max_copy);
-        req->body[max_copy] = '\0';
-        DEBUG_PRINT("Parsed body length: %zu (original: %zu)\n", strlen(req->body), body_len);
-        DEBUG_PRINT("Body first 100 chars: %.100s\n", req->body);
-    } else {
-        req->body[0] = '\0';
-        DEBUG_PRINT_STR("No body found in request\n");
+
+    // The caller's buffer is read-only, so the head is terminated in a
+    // private copy. A head missing its blank line is completed here.
+    size_t head_len = result == HTTP_PARSE_DONE ? parser.consumed : raw_len;
+    req->head_storage = arena_alloc(&req->arena, head_len + 5);
+    if (!req->head_storage) return;
+    memcpy(req->head_storage, raw_request, head_len);
+    memcpy(req->head_storage + head_len, "\r\n\r\n", 5);
+
+    if (result != HTTP_PARSE_DONE &&
+        http_parser_execute(&parser, req->head_storage, head_len + 4) != HTTP_PARSE_DONE) {
+        DEBUG_PRINT_STR("request_init: incomplete request head\n");
+        return;
     }
-    
+
+    request_apply_head(req, req->head_storage, &parser);
+    request_copy_body(req, raw_request + head_len, raw_len - head_len);
+
     DEBUG_PRINT("request_init: method=%s, path=%s, query=%s\n", 
            req->method, req->path, req->query_string);
 }
@@ -305,45 +319,68 @@ void request_set_route_params(Request *req, void *match_ptr) {
     // Clear existing parameters
     req->param_count = 0;
     
-    // Copy parameters from match result
-    for (int i = 0; i < match->param_count && i < MAX_PARAMS; i++) {
-        strncpy(req->params[i].key, match->params[i].name, sizeof(req->params[i].key) - 1);
-        req->params[i].key[sizeof(req->params[i].key) - 1] = '\0';
-        
-        strncpy(req->params[i].value, match->params[i].value, sizeof(req->params[i].value) - 1);
-        req->params[i].value[sizeof(req->params[i].value) - 1] = '\0';
+    // A match made in this request's arena can be referenced directly;
+    // any other match is freed after dispatch, so its strings are copied
+    int borrow = match->arena == &req->arena;
+    for (int i = 0; i < match->param_count; i++) {
+        KeyValue *entry = request_next_entry(req, &req->params, req->params_inline, REQUEST_INLINE_PARAMS,
+                                             req->param_count, MAX_PARAMS);
+        if (!entry) break;
         
+        entry->key = borrow ? match->params[i].name : arena_strdup(&req->arena, match->params[i].name);
+        entry->value = borrow ? match->params[i].value : arena_strdup(&req->arena, match->params[i].value);
+        if (!entry->key || !entry->value) break;
         req->param_count++;
         
         DEBUG_PRINT("request_set_route_params: set param '%s' = '%s'\n", 
-               req->params[i].key, req->params[i].value);
+               entry->key, entry->value);
     }
     
     DEBUG_PRINT("request_set_route_params: set %d parameters\n", req->param_count);
 }
 
+// Set parameters from path slices recorded by the router
+void request_set_route_slices(Request *req, const ParamSlice *slices, int count) {
+    if (!req) return;
+    req->param_count = 0;
+    
+    for (int i = 0; i < count; i++) {
+        KeyValue *entry = request_next_entry(req, &req->params, req->params_inline, REQUEST_INLINE_PARAMS,
+                                             req->param_count, MAX_PARAMS);
+        if (!entry) break;
+        
+        entry->key = slices[i].name;
+        entry->value = arena_strndup(&req->arena, slices[i].value, slices[i].length);
+        if (!entry->value) break;
+        req->param_count++;
+        
+        DEBUG_PRINT("request_set_route_slices: set param '%s' = '%s'\n", entry->key, entry->value);
+    }
+}
+
 // Initialize request with streaming support (headers already parsed)
 void request_init_streaming(Request *req, int client_fd, const char *headers_only) {
-    // First initialize normally but with empty body
-    char empty_request[4096];
-    snprintf(empty_request, sizeof(empty_request), "%s\r\n\r\n", headers_only);
-    request_init(req, client_fd, empty_request);
-    
-    // Clear the body since we'll handle it via streaming
+    // Only the head is given, so the body starts out empty
+    request_init(req, client_fd, headers_only);
+    request_start_stream(req);
+}
+
+void request_start_stream(Request *req) {
     req->body[0] = '\0';
+    req->body_len = 0;
     
     // Get content length and transfer encoding headers
     const char *content_length = req->get_header(req, "Content-Length");
     const char *transfer_encoding = req->get_header(req, "Transfer-Encoding");
     
     // Create stream context
-    req->stream = stream_create(client_fd, content_length, transfer_encoding);
+    req->stream = stream_create(req->client_fd, content_length, transfer_encoding);
     if (req->stream) {
         req->body_streamed = 1;
         req->body_complete = 0;
-        DEBUG_PRINT_STR("request_init_streaming: Created stream context\n");
+        DEBUG_PRINT_STR("request_start_stream: Created stream context\n");
     } else {
-        DEBUG_PRINT_STR("request_init_streaming: Failed to create stream context\n");
+        DEBUG_PRINT_STR("request_start_stream: Failed to create stream context\n");
         req->body_streamed = 0;
         req->body_complete = 1;
     }
@@ -385,14 +422,14 @@ JsonValue* request_get_json(Request *req) {
     }
     
     // Check if body is empty
-    if (!req->body[0]) {
+    if (!req->body || !req->body[0]) {
         req->json_error = strdup("Request body is empty");
         return NULL;
     }
     
     // Parse JSON
     char *error_message = NULL;
-    req->parsed_json = json_parse_with_error(req->body, &error_message);
+    req->parsed_json = json_parse_arena(req->body, &error_message, &req->arena);
     
     if (error_message) {
         req->json_error = error_message;
@@ -479,10 +516,8 @@ int request_validate_json_schema(Request *req, JsonSchema *schema) {
 void request_free_json(Request *req) {
     if (!req) return;
     
-    if (req->parsed_json) {
-        json_free_value(req->parsed_json);
-        req->parsed_json = NULL;
-    }
+    // The tree itself is released with the arena
+    req->parsed_json = NULL;
     
     if (req->json_error) {
         free(req->json_error);
@@ -518,17 +553,22 @@ FormData* request_get_form(Request *req) {
     
     // Return cached result if already parsed
     if (req->form_parsed) {
-        return &req->form_data;
+        return req->form_data;
     }
     
     // Mark as parsed to avoid re-parsing
     req->form_parsed = 1;
     
+    // Most requests never look at a form, so its storage is allocated here
+    req->form_data = arena_alloc(&req->arena, sizeof(FormData));
+    if (!req->form_data) return NULL;
+    form_data_init(req->form_data);
+    
     DEBUG_PRINT_STR("Parsing form data from request body\n");
     
     // Check if body is empty
-    if (!req->body[0]) {
-        req->form_data.error_message = strdup("Request body is empty");
+    if (!req->body || !req->body[0]) {
+        req->form_data->error_message = strdup("Request body is empty");
         return NULL;
     }
     
@@ -536,17 +576,16 @@ FormData* request_get_form(Request *req) {
     if (request_is_multipart_form(req)) {
         // Parse multipart form data
         const char *content_type = request_get_content_type(req);
-        char *boundary = extract_multipart_boundary(content_type);
+        char *boundary = extract_multipart_boundary_in(content_type, &req->arena);
         
         if (!boundary) {
-            req->form_data.error_message = strdup("Could not extract multipart boundary");
+            req->form_data->error_message = strdup("Could not extract multipart boundary");
             return NULL;
         }
         
         DEBUG_PRINT("Parsing multipart form data with boundary: %s\n", boundary);
         
-        int success = parse_multipart_form(&req->form_data, req->body, boundary);
-        free(boundary);
+        int success = parse_multipart_form(req->form_data, req->body, boundary);
         
         if (!success) {
             return NULL;
@@ -555,18 +594,18 @@ FormData* request_get_form(Request *req) {
         // Parse URL-encoded form data
         DEBUG_PRINT_STR("Parsing URL-encoded form data\n");
         
-        int success = parse_url_encoded_form(&req->form_data, req->body);
+        int success = parse_url_encoded_form_in(req->form_data, req->body, &req->arena);
         if (!success) {
-            req->form_data.error_message = strdup("Failed to parse URL-encoded form data");
+            req->form_data->error_message = strdup("Failed to parse URL-encoded form data");
             return NULL;
         }
     } else {
-        req->form_data.error_message = strdup("Content-Type is not a supported form data type");
+        req->form_data->error_message = strdup("Content-Type is not a supported form data type");
         return NULL;
     }
     
-    DEBUG_PRINT("Successfully parsed form data with %d fields\n", req->form_data.field_count);
-    return &req->form_data;
+    DEBUG_PRINT("Successfully parsed form data with %d fields\n", req->form_data->field_count);
+    return req->form_data;
 }
 
 // Get form field value by name
@@ -605,7 +644,10 @@ int request_has_form_field(Request *req, const char *name) {
 void request_free_form(Request *req) {
     if (!req) return;
     
-    form_data_cleanup(&req->form_data);
+    if (req->form_data) {
+        form_data_cleanup(req->form_data);
+        req->form_data = NULL;
+    }
     req->form_parsed = 0;
 }
 
@@ -654,7 +696,7 @@ size_t request_get_body_size(Request *req) {
     }
     
     // Fallback to legacy body
-    return strlen(req->body);
+    return req->body_len;
 }
 
 void request_free_stream(Request *req) {
@@ -679,6 +721,11 @@ void request_destroy(Request *req) {
     // Free streaming-related allocations
     request_free_stream(req);
     
+    // The head copy, strings, spilled arrays, body, JSON tree and form data
+    // all live in the arena
+    req->head_storage = NULL;
+    arena_reset(&req->arena);
+    
     // Note: The Request struct itself should be freed by the caller
     // since it might be stack-allocated or part of a larger structure
 }
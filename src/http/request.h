@@ -4,49 +4,79 @@
 #include <stddef.h>
 #include "../parsers/json.h"
 #include "../parsers/form.h"
+#include "../parsers/http_parser.h"
+#include "../core/arena.h"
 #include "streaming.h"
 
 #define MAX_HEADERS 32
 #define MAX_PARAMS 16
 #define MAX_QUERY_PARAMS 16
-#define MAX_HEADER_SIZE 256
-#define MAX_PARAM_SIZE 128
 #define MAX_BODY_SIZE 16384
 
+// Entries kept inside the Request itself; past these, arrays spill into
+// the request's arena (up to the MAX_ limits above)
+#define REQUEST_INLINE_HEADERS 16
+#define REQUEST_INLINE_PARAMS 4
+#define REQUEST_INLINE_QUERY 8
+#define REQUEST_INLINE_STORAGE 512       // First arena buffer: decoded strings and small bodies
+#define REQUEST_MAX_ROUTE_SLICES 16      // Route parameters captured across every matched layer
+
+// A name/value pair as C strings owned by the request (or its head)
 typedef struct {
-    char key[MAX_PARAM_SIZE];
-    char value[MAX_PARAM_SIZE];
+    const char *key;
+    const char *value;
 } KeyValue;
 
+// A header as NUL-terminated views into the request head
+typedef KeyValue RequestHeader;
+
+// A route parameter captured in place: `length` bytes of the matched path
+// at `value` (not terminated). The name belongs to the compiled route.
+typedef struct {
+    const char *name;
+    const char *value;
+    size_t length;
+} ParamSlice;
+
 // Forward declaration for self-referencing pointers
 struct Request;
 
+// The arrays below point at their inline slots, so a Request must not be
+// copied once initialized.
 struct Request {
     int client_fd;
-    char method[8];
-    char path[256];
-    char query_string[512];
-    char body[MAX_BODY_SIZE];
+    const char *method;         // Request line fields point into the head
+    HttpMethod method_id;       // `method` parsed once, for the router
+    const char *path;
+    const char *query_string;
+    char *body;                 // NUL-terminated copy of the body in the arena (empty if none)
+    size_t body_len;
     
     // HTTP headers
-    KeyValue headers[MAX_HEADERS];
+    RequestHeader *headers;
     int header_count;
+    char *head_storage;         // Private copy of the head when the caller's buffer is read-only
     
     // URL parameters (e.g., :id in /users/:id)
-    KeyValue params[MAX_PARAMS];
+    KeyValue *params;
     int param_count;
+    int route_slice_count;      // Slices used in route_slices by the layers matched so far
+    void *paused_chain;         // The NextContext of a paused chain (see next_pause), else NULL
     
     // Query parameters (e.g., ?name=john&age=25)
-    KeyValue query[MAX_QUERY_PARAMS];
+    KeyValue *query;
     int query_count;
     
-    // JSON parsing support
+    // Everything the request allocates; released in one reset
+    Arena arena;
+    
+    // JSON parsing support (the parsed tree lives in the arena)
     JsonValue *parsed_json;
     int json_parsed;
     char *json_error;
     
-    // Form data parsing support
-    FormData form_data;
+    // Form data parsing support (allocated in the arena by the first get_form)
+    FormData *form_data;
     int form_parsed;
     
     // Streaming support for large bodies
@@ -83,6 +113,13 @@ struct Request {
     const char* (*get_temp_file)(struct Request *req);     // For large bodies
     int (*save_body_to_file)(struct Request *req, const char *filename);
     size_t (*get_body_size)(struct Request *req);
+    
+    // Inline slots and the arena's first buffer
+    RequestHeader headers_inline[REQUEST_INLINE_HEADERS];
+    KeyValue params_inline[REQUEST_INLINE_PARAMS];
+    KeyValue query_inline[REQUEST_INLINE_QUERY];
+    ParamSlice route_slices[REQUEST_MAX_ROUTE_SLICES];
+    char arena_inline[REQUEST_INLINE_STORAGE];
 };
 
 typedef struct Request Request;
@@ -90,20 +127,31 @@ typedef struct Request Request;
 // Initialize request from raw HTTP data
 void request_init(struct Request *req, int client_fd, const char *raw_request);
 
+// Initialize request from a head already parsed in a mutable buffer (the
+// connection's). Fields are terminated in place, so the head bytes must stay
+// put until request_destroy; body bytes are copied.
+void request_init_parsed(struct Request *req, int client_fd, char *head, const HttpParser *parser,
+                         const char *body, size_t body_len);
+
 // Initialize request with streaming support
 void request_init_streaming(struct Request *req, int client_fd, const char *headers_only);
 
-// Parse URL parameters based on route pattern
+// Attach a stream context for reading the body from the socket on demand
+void request_start_stream(struct Request *req);
+
+// Parse URL parameters based on route pattern (legacy: re-splits the pattern
+// on every call; dispatch uses the slices captured by the router)
 void request_parse_params(struct Request *req, const char *route_pattern, const char *actual_path);
 
 // Set parameters from RouteMatch result (for advanced pattern matching)
 void request_set_route_params(struct Request *req, void *match);
 
-// Helper function to parse query string
-void parse_query_string(const char *query_string, KeyValue *query_params, int *query_count);
+// Set parameters from slices of the path captured by the router; only the
+// values are copied (into the arena) so they can be NUL-terminated
+void request_set_route_slices(struct Request *req, const ParamSlice *slices, int count);
 
-// Helper function to parse HTTP headers
-void parse_headers(const char *raw_request, KeyValue *headers, int *header_count);
+// Helper function to parse query string into req->query
+void parse_query_string(struct Request *req, const char *query_string);
 
 // JSON request body functions
 JsonValue* request_get_json(struct Request *req);
@@ -1,5 +1,9 @@
+#define _GNU_SOURCE
 #include "response.h"
+#include "connection.h"
+#include "../core/arena.h"
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -59,45 +63,98 @@ void response_status(Response *res, int code) {
     res->status_code = code;
 }
 
-void response_send(Response *res, const char *body) {
-    char header[1024];
-    int body_len = strlen(body);
+// Case-insensitive lookup of a header set by the handler
+static const char *response_find_header(Response *res, const char *key) {
+    for (int i = 0; i < res->header_count; i++) {
+        if (strcasecmp(res->headers[i].key, key) == 0) {
+            return res->headers[i].value;
+        }
+    }
+    return NULL;
+}
+
+// Room for the status line, Content-Type, Connection, Content-Length and
+// every custom header at its longest
+#define RESPONSE_MAX_HEAD (256 + MAX_RESPONSE_HEADERS * (2 * MAX_HEADER_SIZE + 4))
+
+// Append `len` bytes to the head, clamped to its capacity
+static size_t head_append(char *head, size_t head_len, const char *data, size_t len) {
+    if (len > RESPONSE_MAX_HEAD - head_len) len = RESPONSE_MAX_HEAD - head_len;
+    memcpy(head + head_len, data, len);
+    return head_len + len;
+}
+
+// "key: value\r\n"
+static size_t head_append_field(char *head, size_t head_len, const char *key, const char *value) {
+    head_len = head_append(head, head_len, key, strlen(key));
+    head_len = head_append(head, head_len, ": ", 2);
+    head_len = head_append(head, head_len, value, strlen(value));
+    return head_append(head, head_len, "\r\n", 2);
+}
+
+void response_send_bytes(Response *res, const void *body, size_t body_len) {
+    char head[RESPONSE_MAX_HEAD];
+    if (!body) body_len = 0;
     
     // Start with HTTP response line using current status code
-    int header_len = snprintf(header, sizeof(header),
+    size_t head_len = (size_t)snprintf(head, sizeof(head),
         "HTTP/1.1 %d %s\r\n", res->status_code, get_status_text(res->status_code));
     
-    // Add Content-Type
-    header_len += snprintf(header + header_len, sizeof(header) - header_len,
-        "Content-Type: %s\r\n", 
+    head_len = head_append_field(head, head_len, "Content-Type",
         res->content_type[0] ? res->content_type : "text/plain");
     
+    // On an event loop connection the loop decides the Connection header
+    Connection *conn = connection_get_active();
+    if (conn && conn->fd != res->client_fd) conn = NULL;
+    
     // Add custom headers
     for (int i = 0; i < res->header_count; i++) {
         // Skip Content-Type as we already added it
-        if (strcmp(res->headers[i].key, "Content-Type") != 0) {
-            header_len += snprintf(header + header_len, sizeof(header) - header_len,
-                "%s: %s\r\n", res->headers[i].key, res->headers[i].value);
+        if (strcmp(res->headers[i].key, "Content-Type") != 0 &&
+            !(conn && strcasecmp(res->headers[i].key, "Connection") == 0)) {
+            head_len = head_append_field(head, head_len, res->headers[i].key, res->headers[i].value);
         }
     }
     
+    // Tell the client whether the connection stays open; a handler can
+    // force a close by setting "Connection: close" itself, but cannot keep
+    // open one the loop is closing (client asked, or max requests reached)
+    if (conn) {
+        const char *connection = response_find_header(res, "Connection");
+        if (connection && strcasestr(connection, "close")) conn->keep_alive = 0;
+        if (!conn->keep_alive) connection = "close";
+        head_len = head_append_field(head, head_len, "Connection",
+                                     connection ? connection : "keep-alive");
+    }
+
     // Add Content-Length and end headers
-    header_len += snprintf(header + header_len, sizeof(header) - header_len,
-        "Content-Length: %d\r\n\r\n", body_len);
+    char length[48];
+    int length_len = snprintf(length, sizeof(length), "Content-Length: %zu\r\n\r\n", body_len);
+    head_len = head_append(head, head_len, length, (size_t)length_len);
     
-    write(res->client_fd, header, header_len);
-    write(res->client_fd, body, body_len);
+    // Head and body leave in one write
+    struct iovec iov[2] = { { head, head_len }, { (void *)body, body_len } };
+    connection_sendv(res->client_fd, iov, 2);
+}
+
+void response_send_buffer(Response *res, void *data, size_t len, void (*release)(void *data)) {
+    res->send_bytes(res, data, len);
+    if (release && data) release(data);
+}
+
+void response_send(Response *res, const char *body) {
+    res->send_bytes(res, body, body ? strlen(body) : 0);
 }
 
 void response_json(Response *res, const char *json_str) {
     res->set_header(res, "Content-Type", "application/json");
-    res->send(res, json_str);
+    res->send_bytes(res, json_str, json_str ? strlen(json_str) : 0);
 }
 
 void response_send_status(Response *res, int code) {
     res->status_code = code;
     const char *status_text = get_status_text(code);
-    res->send(res, status_text);
+    res->send_bytes(res, status_text, strlen(status_text));
 }
 
 void response_init(Response *res, int client_fd) {
@@ -108,20 +165,28 @@ void response_init(Response *res, int client_fd) {
     res->set_header = response_set_header;
     res->status = response_status;
     res->send = response_send;
+    res->send_bytes = response_send_bytes;
+    res->send_buffer = response_send_buffer;
     res->json = response_json;
     res->send_status = response_send_status;
+    res->in_arena = 0;
 }
 
 Response *create_response(int client_fd) {
-    Response *res = malloc(sizeof(Response));
+    return create_response_in(client_fd, NULL);
+}
+
+Response *create_response_in(int client_fd, struct Arena *arena) {
+    Response *res = arena ? arena_alloc(arena, sizeof(Response)) : malloc(sizeof(Response));
     if (res) {
         response_init(res, client_fd);
+        res->in_arena = arena != NULL;
     }
     return res;
 }
 
 void destroy_response(Response *res) {
-    if (res) {
+    if (res && !res->in_arena) {
         free(res);
     }
 }
@@ -13,6 +13,7 @@ typedef struct {
 
 // Forward declaration for self-referencing pointers  
 struct Response;
+struct Arena;
 
 // response struct for each request
 struct Response {
@@ -24,18 +25,29 @@ struct Response {
     void (*set_header)(struct Response *res, const char *key, const char *value);
     void (*status)(struct Response *res, int code);
     void (*send)(struct Response *res, const char *body);
+    void (*send_bytes)(struct Response *res, const void *data, size_t len);
+    void (*send_buffer)(struct Response *res, void *data, size_t len, void (*release)(void *data));
     void (*json)(struct Response *res, const char *json_str);
     void (*send_status)(struct Response *res, int code);
+    int in_arena;               // Allocated by create_response_in: destroy_response leaves it
 };
 
 typedef struct Response Response;
 
 // Function declarations
 struct Response *create_response(int client_fd);
+// Response allocated from a request arena (falls back to malloc when NULL)
+struct Response *create_response_in(int client_fd, struct Arena *arena);
 void destroy_response(struct Response *res);
 void response_set_header(struct Response *res, const char *key, const char *value);
 void response_status(struct Response *res, int code);
 void response_send(struct Response *res, const char *body);
+// Send `len` bytes of body as they are, NULs included. The bytes are only
+// borrowed: by the time it returns they are written or copied.
+void response_send_bytes(struct Response *res, const void *data, size_t len);
+// Send a buffer the response takes over: `release` (e.g. free) is called
+// on it once sent. With a NULL `release` it is borrowed, as send_bytes.
+void response_send_buffer(struct Response *res, void *data, size_t len, void (*release)(void *data));
 void response_send_status(struct Response *res, int code);
 
 // attach send implementation to Response
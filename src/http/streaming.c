@@ -416,6 +416,19 @@ int stream_copy_to_buffer(StreamContext *stream, char *buffer, size_t buffer_siz
     return -1;
 }
 
+// Seed the read buffer with body bytes that arrived in the same read as the headers
+int stream_prefill(StreamContext *stream, const char *data, size_t length) {
+    if (!stream || (!data && length > 0)) return -1;
+    if (length > STREAM_BUFFER_SIZE) return -1;
+    
+    memcpy(stream->read_buffer, data, length);
+    stream->buffer_pos = 0;
+    stream->buffer_len = length;
+    
+    DEBUG_PRINT("Stream: Prefilled %zu bytes from connection buffer\n", length);
+    return 0;
+}
+
 // Cleanup stream resources
 void stream_destroy(StreamContext *stream) {
     if (!stream) return;
@@ -77,6 +77,9 @@ void stream_destroy(StreamContext *stream);
 int stream_save_to_file(StreamContext *stream, const char *filename);
 int stream_copy_to_buffer(StreamContext *stream, char *buffer, size_t buffer_size);
 
+// Seed the read buffer with body bytes already read alongside the headers
+int stream_prefill(StreamContext *stream, const char *data, size_t length);
+
 // Chunked transfer encoding helpers
 int parse_chunk_size(const char *line);
 int read_chunk_data(int client_fd, char *buffer, size_t chunk_size);
@@ -1,6 +1,7 @@
 #define _GNU_SOURCE
 #include "form.h"
 #include "../debug.h"
+#include "../core/arena.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +36,10 @@ void form_data_init(FormData *form) {
 // ============================================================================
 
 int parse_url_encoded_form(FormData *form, const char *body) {
+    return parse_url_encoded_form_in(form, body, NULL);
+}
+
+int parse_url_encoded_form_in(FormData *form, const char *body, struct Arena *arena) {
     if (!form || !body) {
         return 0;
     }
@@ -43,8 +48,12 @@ int parse_url_encoded_form(FormData *form, const char *body) {
     
     DEBUG_PRINT("Parsing URL-encoded form data: %.100s\n", body);
     
-    char *body_copy = strdup(body);
-    char *pair = strtok(body_copy, "&");
+    char *body_copy = arena ? arena_strdup(arena, body) : strdup(body);
+    if (!body_copy) {
+        return 0;
+    }
+    char *saveptr = NULL;
+    char *pair = strtok_r(body_copy, "&", &saveptr);
     
     while (pair && form->field_count < MAX_FORM_FIELDS) {
         char *equals = strchr(pair, '=');
@@ -73,10 +82,10 @@ int parse_url_encoded_form(FormData *form, const char *body) {
             DEBUG_PRINT("Parsed form field (no value): '%s'\n", field->name);
         }
         
-        pair = strtok(NULL, "&");
+        pair = strtok_r(NULL, "&", &saveptr);
     }
     
-    free(body_copy);
+    if (!arena) free(body_copy);
     form->parsed = 1;
     
     DEBUG_PRINT("Parsed %d form fields from URL-encoded data\n", form->field_count);
@@ -88,6 +97,10 @@ int parse_url_encoded_form(FormData *form, const char *body) {
 // ============================================================================
 
 char* extract_multipart_boundary(const char *content_type) {
+    return extract_multipart_boundary_in(content_type, NULL);
+}
+
+char* extract_multipart_boundary_in(const char *content_type, struct Arena *arena) {
     if (!content_type) return NULL;
     
     const char *boundary_start = strstr(content_type, "boundary=");
@@ -112,9 +125,8 @@ char* extract_multipart_boundary(const char *content_type) {
         return NULL;
     }
     
-    char *boundary = malloc(boundary_len + 1);
-    strncpy(boundary, boundary_start, boundary_len);
-    boundary[boundary_len] = '\0';
+    char *boundary = arena ? arena_strndup(arena, boundary_start, boundary_len) : strndup(boundary_start, boundary_len);
+    if (!boundary) return NULL;
     
     DEBUG_PRINT("Extracted boundary: '%s'\n", boundary);
     return boundary;
@@ -10,6 +10,8 @@
 #define MAX_CONTENT_TYPE_SIZE 128
 #define MAX_BOUNDARY_SIZE 128
 
+struct Arena;
+
 // Forward declaration for Request
 struct Request;
 
@@ -52,12 +54,15 @@ void form_data_init(FormData *form);
 
 // Parse URL-encoded form data (application/x-www-form-urlencoded)
 int parse_url_encoded_form(FormData *form, const char *body);
+// Same, with the working copy of the body taken from `arena` (NULL = heap)
+int parse_url_encoded_form_in(FormData *form, const char *body, struct Arena *arena);
 
 // Parse multipart form data (multipart/form-data)
 int parse_multipart_form(FormData *form, const char *body, const char *boundary);
 
 // Extract boundary from Content-Type header
 char* extract_multipart_boundary(const char *content_type);
+char* extract_multipart_boundary_in(const char *content_type, struct Arena *arena);
 
 // ============================================================================
 // FORM DATA ACCESS FUNCTIONS
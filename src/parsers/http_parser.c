@@ -0,0 +1,311 @@
+#define _GNU_SOURCE
+#include "http_parser.h"
+#include "http_scan.h"
+#include "../debug.h"
+#include <string.h>
+#include <strings.h>
+
+// Parser states, in the order they occur in a request head
+enum {
+    HTTP_STATE_METHOD,
+    HTTP_STATE_PATH,
+    HTTP_STATE_QUERY,
+    HTTP_STATE_VERSION,
+    HTTP_STATE_REQUEST_LINE_LF,  // Saw the CR ending the request line
+    HTTP_STATE_HEADER_START,     // At the start of a header line or the blank line
+    HTTP_STATE_HEADER_NAME,
+    HTTP_STATE_VALUE_START,      // Skipping whitespace after the colon
+    HTTP_STATE_VALUE,
+    HTTP_STATE_HEADER_LF,        // Saw the CR ending a header line
+    HTTP_STATE_HEAD_END_LF,      // Saw the CR of the blank line
+    HTTP_STATE_DONE
+};
+
+// RFC 9110 token characters (method and header names), as a lookup table
+// so the name check costs one load per byte
+static const unsigned char http_token_table[256] = {
+    ['!'] = 1, ['#'] = 1, ['$'] = 1, ['%'] = 1, ['&'] = 1, ['\''] = 1, ['*'] = 1, ['+'] = 1,
+    ['-'] = 1, ['.'] = 1, ['^'] = 1, ['_'] = 1, ['`'] = 1, ['|'] = 1, ['~'] = 1,
+    ['0'] = 1, ['1'] = 1, ['2'] = 1, ['3'] = 1, ['4'] = 1, ['5'] = 1, ['6'] = 1, ['7'] = 1,
+    ['8'] = 1, ['9'] = 1,
+    ['A'] = 1, ['B'] = 1, ['C'] = 1, ['D'] = 1, ['E'] = 1, ['F'] = 1, ['G'] = 1, ['H'] = 1,
+    ['I'] = 1, ['J'] = 1, ['K'] = 1, ['L'] = 1, ['M'] = 1, ['N'] = 1, ['O'] = 1, ['P'] = 1,
+    ['Q'] = 1, ['R'] = 1, ['S'] = 1, ['T'] = 1, ['U'] = 1, ['V'] = 1, ['W'] = 1, ['X'] = 1,
+    ['Y'] = 1, ['Z'] = 1,
+    ['a'] = 1, ['b'] = 1, ['c'] = 1, ['d'] = 1, ['e'] = 1, ['f'] = 1, ['g'] = 1, ['h'] = 1,
+    ['i'] = 1, ['j'] = 1, ['k'] = 1, ['l'] = 1, ['m'] = 1, ['n'] = 1, ['o'] = 1, ['p'] = 1,
+    ['q'] = 1, ['r'] = 1, ['s'] = 1, ['t'] = 1, ['u'] = 1, ['v'] = 1, ['w'] = 1, ['x'] = 1,
+    ['y'] = 1, ['z'] = 1
+};
+
+#define http_is_token(c) (http_token_table[(unsigned char)(c)])
+
+static HttpSlice http_slice(size_t start, size_t end) {
+    HttpSlice slice;
+    slice.offset = (uint32_t)start;
+    slice.length = (uint32_t)(end - start);
+    return slice;
+}
+
+static int http_slice_equals(const char *data, HttpSlice slice, const char *name) {
+    size_t name_len = strlen(name);
+    return slice.length == name_len && strncasecmp(data + slice.offset, name, name_len) == 0;
+}
+
+static const char *const http_method_names[HTTP_METHOD_COUNT] = {
+    [HTTP_METHOD_OTHER] = "",
+    [HTTP_METHOD_GET] = "GET",
+    [HTTP_METHOD_HEAD] = "HEAD",
+    [HTTP_METHOD_POST] = "POST",
+    [HTTP_METHOD_PUT] = "PUT",
+    [HTTP_METHOD_DELETE] = "DELETE",
+    [HTTP_METHOD_PATCH] = "PATCH",
+    [HTTP_METHOD_OPTIONS] = "OPTIONS",
+    [HTTP_METHOD_CONNECT] = "CONNECT",
+    [HTTP_METHOD_TRACE] = "TRACE",
+};
+
+HttpMethod http_method_parse(const char *name, size_t length) {
+    // The first byte and the length tell the known methods apart
+    HttpMethod guess = HTTP_METHOD_OTHER;
+    switch (length ? name[0] : 0) {
+        case 'G': guess = HTTP_METHOD_GET; break;
+        case 'H': guess = HTTP_METHOD_HEAD; break;
+        case 'P':
+            guess = length == 4 ? HTTP_METHOD_POST : length == 3 ? HTTP_METHOD_PUT : HTTP_METHOD_PATCH;
+            break;
+        case 'D': guess = HTTP_METHOD_DELETE; break;
+        case 'O': guess = HTTP_METHOD_OPTIONS; break;
+        case 'C': guess = HTTP_METHOD_CONNECT; break;
+        case 'T': guess = HTTP_METHOD_TRACE; break;
+        default: return HTTP_METHOD_OTHER;
+    }
+    const char *expected = http_method_names[guess];
+    if (strlen(expected) != length || memcmp(expected, name, length) != 0) return HTTP_METHOD_OTHER;
+    return guess;
+}
+
+const char *http_method_name(HttpMethod method) {
+    return method > HTTP_METHOD_OTHER && method < HTTP_METHOD_COUNT ? http_method_names[method] : "";
+}
+
+size_t http_method_list(unsigned int mask, char *out, size_t size) {
+    size_t used = 0;
+    if (size == 0) return 0;
+    out[0] = '\0';
+    for (int m = HTTP_METHOD_GET; m < HTTP_METHOD_COUNT; m++) {
+        if (!(mask & HTTP_METHOD_BIT(m))) continue;
+        size_t name_len = strlen(http_method_names[m]);
+        size_t sep = used ? 2 : 0;
+        if (used + sep + name_len >= size) break;
+        if (sep) memcpy(out + used, ", ", 2);
+        memcpy(out + used + sep, http_method_names[m], name_len);
+        used += sep + name_len;
+        out[used] = '\0';
+    }
+    return used;
+}
+
+// Does the comma-separated list in `value` contain `token`?
+static int http_value_has_token(const char *data, HttpSlice value, const char *token) {
+    size_t token_len = strlen(token);
+    size_t pos = value.offset;
+    size_t end = value.offset + value.length;
+
+    while (pos < end) {
+        while (pos < end && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == ',')) pos++;
+        size_t start = pos;
+        while (pos < end && data[pos] != ',') pos++;
+        size_t stop = pos;
+        while (stop > start && (data[stop - 1] == ' ' || data[stop - 1] == '\t')) stop--;
+        if (stop - start == token_len && strncasecmp(data + start, token, token_len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Pick out the headers that affect framing and connection reuse
+static int http_apply_header(HttpParser *parser, const char *data, HttpSlice name, HttpSlice value) {
+    if (http_slice_equals(data, name, "Content-Length")) {
+        size_t length = 0;
+        if (value.length == 0) return -1;
+        for (uint32_t i = 0; i < value.length; i++) {
+            char c = data[value.offset + i];
+            if (c < '0' || c > '9') return -1;
+            if (length > ((size_t)-1 - 9) / 10) return -1;  // Overflow
+            length = length * 10 + (size_t)(c - '0');
+        }
+        // Conflicting lengths are a request smuggling vector
+        if (parser->has_content_length && parser->content_length != length) return -1;
+        parser->content_length = length;
+        parser->has_content_length = 1;
+    } else if (http_slice_equals(data, name, "Transfer-Encoding")) {
+        // Only the final coding decides the framing
+        size_t end = value.offset + value.length;
+        size_t start = end;
+        while (start > value.offset && data[start - 1] != ',') start--;
+        while (start < end && (data[start] == ' ' || data[start] == '\t')) start++;
+        parser->chunked = end - start == 7 && strncasecmp(data + start, "chunked", 7) == 0;
+    } else if (http_slice_equals(data, name, "Connection")) {
+        if (http_value_has_token(data, value, "close")) parser->connection_close = 1;
+        if (http_value_has_token(data, value, "keep-alive")) parser->connection_keep_alive = 1;
+    }
+    return 0;
+}
+
+void http_parser_init(HttpParser *parser) {
+    memset(parser, 0, sizeof(HttpParser));
+    parser->state = HTTP_STATE_METHOD;
+}
+
+HttpParseResult http_parser_execute(HttpParser *parser, const char *data, size_t len) {
+    size_t pos = parser->consumed;
+
+    if (parser->state == HTTP_STATE_DONE) return HTTP_PARSE_DONE;
+    if (len > UINT32_MAX) return HTTP_PARSE_ERROR;
+
+    while (pos < len) {
+        unsigned char c = (unsigned char)data[pos];
+
+        switch (parser->state) {
+            case HTTP_STATE_METHOD:
+                while (pos < len && http_is_token(data[pos])) pos++;
+                if (pos == len) break;
+                if (data[pos] != ' ' || pos == parser->mark) return HTTP_PARSE_ERROR;
+                parser->method = http_slice(parser->mark, pos);
+                parser->mark = ++pos;
+                parser->state = HTTP_STATE_PATH;
+                break;
+
+            case HTTP_STATE_PATH:
+                while (pos < len && (unsigned char)data[pos] > ' ' && data[pos] != '?') pos++;
+                if (pos == len) break;
+                if ((data[pos] != ' ' && data[pos] != '?') || pos == parser->mark) return HTTP_PARSE_ERROR;
+                parser->path = http_slice(parser->mark, pos);
+                if (data[pos] == '?') {
+                    parser->state = HTTP_STATE_QUERY;
+                } else {
+                    parser->query = http_slice(pos, pos);
+                    parser->state = HTTP_STATE_VERSION;
+                }
+                parser->mark = ++pos;
+                break;
+
+            case HTTP_STATE_QUERY:
+                while (pos < len && (unsigned char)data[pos] > ' ') pos++;
+                if (pos == len) break;
+                if (data[pos] != ' ') return HTTP_PARSE_ERROR;
+                parser->query = http_slice(parser->mark, pos);
+                parser->mark = ++pos;
+                parser->state = HTTP_STATE_VERSION;
+                break;
+
+            case HTTP_STATE_VERSION:
+                pos = http_scan_line_end(data, pos, len);
+                if (pos == len) break;
+                if (pos - parser->mark != 8 || strncmp(data + parser->mark, "HTTP/1.", 7) != 0 ||
+                    data[parser->mark + 7] < '0' || data[parser->mark + 7] > '9') {
+                    return HTTP_PARSE_ERROR;
+                }
+                parser->version_minor = data[parser->mark + 7] - '0';
+                parser->state = data[pos] == '\r' ? HTTP_STATE_REQUEST_LINE_LF : HTTP_STATE_HEADER_START;
+                pos++;
+                break;
+
+            case HTTP_STATE_REQUEST_LINE_LF:
+            case HTTP_STATE_HEADER_LF:
+                if (c != '\n') return HTTP_PARSE_ERROR;
+                parser->state = HTTP_STATE_HEADER_START;
+                pos++;
+                break;
+
+            case HTTP_STATE_HEADER_START:
+                if (c == '\r') {
+                    parser->state = HTTP_STATE_HEAD_END_LF;
+                    pos++;
+                } else if (c == '\n') {
+                    parser->state = HTTP_STATE_DONE;
+                    parser->consumed = pos + 1;
+                    return HTTP_PARSE_DONE;
+                } else if (http_is_token(c)) {
+                    parser->mark = pos;
+                    parser->state = HTTP_STATE_HEADER_NAME;
+                } else {
+                    return HTTP_PARSE_ERROR;  // Includes obsolete line folding
+                }
+                break;
+
+            case HTTP_STATE_HEADER_NAME: {
+                // Find the colon first, then check the (short) name is a token
+                size_t end = http_scan_name_end(data, pos, len);
+                while (pos < end && http_is_token(data[pos])) pos++;
+                if (pos < end) return HTTP_PARSE_ERROR;
+                if (pos == len) break;
+                if (data[pos] != ':') return HTTP_PARSE_ERROR;
+                parser->name = http_slice(parser->mark, pos);
+                parser->state = HTTP_STATE_VALUE_START;
+                pos++;
+                break;
+            }
+
+            case HTTP_STATE_VALUE_START:
+                while (pos < len && (data[pos] == ' ' || data[pos] == '\t')) pos++;
+                if (pos == len) break;
+                parser->mark = pos;
+                parser->state = HTTP_STATE_VALUE;
+                break;
+
+            case HTTP_STATE_VALUE: {
+                pos = http_scan_line_end(data, pos, len);
+                if (pos == len) break;
+
+                size_t end = pos;
+                while (end > parser->mark && (data[end - 1] == ' ' || data[end - 1] == '\t')) end--;
+                HttpSlice value = http_slice(parser->mark, end);
+
+                if (http_apply_header(parser, data, parser->name, value) < 0) {
+                    DEBUG_PRINT("http_parser_execute: invalid value for header %.*s\n",
+                           (int)parser->name.length, data + parser->name.offset);
+                    return HTTP_PARSE_ERROR;
+                }
+                if (parser->header_count < HTTP_PARSER_MAX_HEADERS) {
+                    parser->headers[parser->header_count].name = parser->name;
+                    parser->headers[parser->header_count].value = value;
+                    parser->header_count++;
+                }
+
+                parser->state = data[pos] == '\r' ? HTTP_STATE_HEADER_LF : HTTP_STATE_HEADER_START;
+                pos++;
+                break;
+            }
+
+            case HTTP_STATE_HEAD_END_LF:
+                if (c != '\n') return HTTP_PARSE_ERROR;
+                parser->state = HTTP_STATE_DONE;
+                parser->consumed = pos + 1;
+                return HTTP_PARSE_DONE;
+
+            default:
+                return HTTP_PARSE_ERROR;
+        }
+    }
+
+    parser->consumed = pos;
+    return HTTP_PARSE_INCOMPLETE;
+}
+
+int http_parser_keep_alive(const HttpParser *parser) {
+    if (parser->connection_close) return 0;
+    if (parser->connection_keep_alive) return 1;
+    return parser->version_minor >= 1;
+}
+
+const HttpHeaderSlice *http_parser_find_header(const HttpParser *parser, const char *data, const char *name) {
+    for (int i = 0; i < parser->header_count; i++) {
+        if (http_slice_equals(data, parser->headers[i].name, name)) {
+            return &parser->headers[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,94 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTTP_PARSER_MAX_HEADERS 32
+
+// A run of bytes inside the buffer being parsed. Offsets rather than
+// pointers keep the views valid when the caller grows (reallocs) the buffer.
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} HttpSlice;
+
+typedef struct {
+    HttpSlice name;
+    HttpSlice value;
+} HttpHeaderSlice;
+
+// Request methods the router dispatches on. Methods are case-sensitive;
+// anything not listed here is HTTP_METHOD_OTHER.
+typedef enum {
+    HTTP_METHOD_OTHER = 0,
+    HTTP_METHOD_GET,
+    HTTP_METHOD_HEAD,
+    HTTP_METHOD_POST,
+    HTTP_METHOD_PUT,
+    HTTP_METHOD_DELETE,
+    HTTP_METHOD_PATCH,
+    HTTP_METHOD_OPTIONS,
+    HTTP_METHOD_CONNECT,
+    HTTP_METHOD_TRACE,
+    HTTP_METHOD_COUNT
+} HttpMethod;
+
+#define HTTP_METHOD_BIT(m) (1u << (m))
+#define HTTP_METHODS_ALL ((1u << HTTP_METHOD_COUNT) - 1)
+
+// Result of feeding bytes to the parser
+typedef enum {
+    HTTP_PARSE_ERROR = -1,       // Malformed request head
+    HTTP_PARSE_INCOMPLETE = 0,   // Need more bytes; call again once they arrive
+    HTTP_PARSE_DONE = 1          // Head complete; consumed holds its length
+} HttpParseResult;
+
+// Resumable request-head parser. It never copies: the request line and
+// headers are recorded as slices of the caller's buffer.
+typedef struct {
+    int state;
+    size_t consumed;             // Bytes parsed so far (the head length once done)
+    size_t mark;                 // Start of the token being scanned
+
+    // Request line
+    HttpSlice method;
+    HttpSlice path;
+    HttpSlice query;             // Without the leading '?'; empty if absent
+    int version_minor;           // 1 for HTTP/1.1, 0 for HTTP/1.0
+
+    // Headers (beyond HTTP_PARSER_MAX_HEADERS they are parsed but not kept)
+    HttpHeaderSlice headers[HTTP_PARSER_MAX_HEADERS];
+    int header_count;
+    HttpSlice name;              // Name of the header being scanned
+
+    // Framing and connection semantics, extracted while parsing
+    size_t content_length;
+    int has_content_length;
+    int chunked;                 // Transfer-Encoding ends in chunked
+    int connection_close;        // Connection: close
+    int connection_keep_alive;   // Connection: keep-alive
+} HttpParser;
+
+void http_parser_init(HttpParser *parser);
+
+// Parse `data[0..len)`, resuming where the previous call stopped. `data`
+// must hold every byte passed to earlier calls at the same offsets.
+HttpParseResult http_parser_execute(HttpParser *parser, const char *data, size_t len);
+
+// HTTP/1.1 defaults to a persistent connection, HTTP/1.0 to close, and an
+// explicit Connection header overrides either
+int http_parser_keep_alive(const HttpParser *parser);
+
+// Method name to enum (`length` bytes, not necessarily terminated)
+HttpMethod http_method_parse(const char *name, size_t length);
+const char *http_method_name(HttpMethod method);
+
+// Write the methods in `mask` as an Allow header value ("GET, POST");
+// returns the length written
+size_t http_method_list(unsigned int mask, char *out, size_t size);
+
+// Case-insensitive header lookup on a completed head; returns NULL if absent
+const HttpHeaderSlice *http_parser_find_header(const HttpParser *parser, const char *data, const char *name);
+
+#endif
@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+#include "http_scan.h"
+#include "../debug.h"
+#include <pthread.h>
+
+#if !defined(C_EXPRESS_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HTTP_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+// Every kernel looks for the first of three bytes (repeat one to search for two)
+typedef size_t (*HttpScanFn)(const char *data, size_t pos, size_t len, char a, char b, char c);
+
+static size_t scan_scalar(const char *data, size_t pos, size_t len, char a, char b, char c) {
+    while (pos < len && data[pos] != a && data[pos] != b && data[pos] != c) pos++;
+    return pos;
+}
+
+#ifdef HTTP_SCAN_X86
+// PCMPESTRI compares 16 bytes against the whole set in one instruction
+__attribute__((target("sse4.2")))
+static size_t scan_sse42(const char *data, size_t pos, size_t len, char a, char b, char c) {
+    const __m128i set = _mm_setr_epi8(a, b, c, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    while (pos + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + pos));
+        int index = _mm_cmpestri(set, 3, chunk, 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16) return pos + (size_t)index;
+        pos += 16;
+    }
+    return scan_scalar(data, pos, len, a, b, c);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *data, size_t pos, size_t len, char a, char b, char c) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+
+    while (pos + 32 <= len) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + pos));
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, va),
+                                                       _mm256_cmpeq_epi8(chunk, vb)),
+                                       _mm256_cmpeq_epi8(chunk, vc));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+        if (mask) return pos + (size_t)__builtin_ctz(mask);
+        pos += 32;
+    }
+    // Most lines end within the last 32 bytes; let the SSE kernel take the tail
+    return scan_sse42(data, pos, len, a, b, c);
+}
+#endif
+
+static HttpScanKernel scan_kernel = HTTP_SCAN_SCALAR;
+static HttpScanFn scan_fn = scan_scalar;
+static pthread_once_t scan_once = PTHREAD_ONCE_INIT;
+
+static int scan_kernel_supported(HttpScanKernel kernel) {
+#ifdef HTTP_SCAN_X86
+    __builtin_cpu_init();
+    if (kernel == HTTP_SCAN_AVX2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2");
+    if (kernel == HTTP_SCAN_SSE42) return __builtin_cpu_supports("sse4.2");
+#endif
+    return kernel == HTTP_SCAN_SCALAR;
+}
+
+static void scan_use(HttpScanKernel kernel) {
+    scan_kernel = kernel;
+    switch (kernel) {
+#ifdef HTTP_SCAN_X86
+        case HTTP_SCAN_AVX2:  scan_fn = scan_avx2; break;
+        case HTTP_SCAN_SSE42: scan_fn = scan_sse42; break;
+#endif
+        default:              scan_fn = scan_scalar; break;
+    }
+}
+
+static void scan_select(void) {
+    if (scan_kernel_supported(HTTP_SCAN_AVX2)) {
+        scan_use(HTTP_SCAN_AVX2);
+    } else if (scan_kernel_supported(HTTP_SCAN_SSE42)) {
+        scan_use(HTTP_SCAN_SSE42);
+    } else {
+        scan_use(HTTP_SCAN_SCALAR);
+    }
+    DEBUG_PRINT("http_scan: using %s kernel\n", http_scan_kernel_name(scan_kernel));
+}
+
+size_t http_scan_line_end(const char *data, size_t pos, size_t len) {
+    pthread_once(&scan_once, scan_select);
+    return scan_fn(data, pos, len, '\r', '\n', '\n');
+}
+
+size_t http_scan_name_end(const char *data, size_t pos, size_t len) {
+    pthread_once(&scan_once, scan_select);
+    return scan_fn(data, pos, len, ':', '\r', '\n');
+}
+
+HttpScanKernel http_scan_kernel(void) {
+    pthread_once(&scan_once, scan_select);
+    return scan_kernel;
+}
+
+const char *http_scan_kernel_name(HttpScanKernel kernel) {
+    switch (kernel) {
+        case HTTP_SCAN_AVX2:  return "avx2";
+        case HTTP_SCAN_SSE42: return "sse4.2";
+        default:              return "scalar";
+    }
+}
+
+int http_scan_set_kernel(HttpScanKernel kernel) {
+    pthread_once(&scan_once, scan_select);
+    if (!scan_kernel_supported(kernel)) return -1;
+    scan_use(kernel);
+    return 0;
+}
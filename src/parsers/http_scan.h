@@ -0,0 +1,28 @@
+#ifndef HTTP_SCAN_H
+#define HTTP_SCAN_H
+
+#include <stddef.h>
+
+// Byte scanners behind the request-head parser. On x86 they compare 16
+// (SSE4.2) or 32 (AVX2) bytes per step; the kernel is picked from CPUID on
+// first use, with a scalar loop everywhere else. Build with
+// -DC_EXPRESS_NO_SIMD to always use the scalar loop.
+typedef enum {
+    HTTP_SCAN_SCALAR,
+    HTTP_SCAN_SSE42,
+    HTTP_SCAN_AVX2
+} HttpScanKernel;
+
+// Index of the first CR or LF in data[pos..len), or len if there is none
+size_t http_scan_line_end(const char *data, size_t pos, size_t len);
+
+// Index of the first ':', CR or LF in data[pos..len), or len if there is none
+size_t http_scan_name_end(const char *data, size_t pos, size_t len);
+
+HttpScanKernel http_scan_kernel(void);
+const char *http_scan_kernel_name(HttpScanKernel kernel);
+
+// Force a kernel (tests and benchmarks); returns -1 if the CPU lacks it
+int http_scan_set_kernel(HttpScanKernel kernel);
+
+#endif
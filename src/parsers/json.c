@@ -2,6 +2,7 @@
 #include "json.h"
 #include "../debug.h"
 #include "json_builder.h"
+#include "../core/arena.h"
 #include <stdarg.h>
 #include <ctype.h>
 #include <errno.h>
@@ -39,6 +40,84 @@ static void set_error(JsonParser *parser, const char *message) {
     parser->error_message = strdup(message);
 }
 
+// Parse-time allocation: from the parser's arena if it has one, else the heap
+static void *json_alloc(JsonParser *parser, size_t size) {
+    return parser->arena ? arena_alloc(parser->arena, size) : malloc(size);
+}
+
+static void json_release(JsonParser *parser, void *ptr) {
+    if (!parser->arena) free(ptr);
+}
+
+// Drop a partially built value on error; arena trees go with the arena
+static void json_discard(JsonParser *parser, JsonValue *value) {
+    if (!parser->arena) json_free_value(value);
+}
+
+static JsonValue *json_new_value(JsonParser *parser, JsonType type) {
+    JsonValue *value = json_alloc(parser, sizeof(JsonValue));
+    if (!value) {
+        set_error(parser, "Memory allocation failed");
+        return NULL;
+    }
+    value->type = type;
+    return value;
+}
+
+static void json_discard_array(JsonParser *parser, JsonArray *array) {
+    if (!parser->arena) json_free_value(json_create_array_value(array));
+}
+
+static void json_discard_object(JsonParser *parser, JsonObject *object) {
+    if (!parser->arena) json_free_value(json_create_object_value(object));
+}
+
+static void json_parser_array_add(JsonParser *parser, JsonArray *array, JsonValue *value) {
+    if (array->count >= array->capacity) {
+        int new_capacity = array->capacity == 0 ? 4 : array->capacity * 2;
+        JsonValue **new_items = parser->arena
+            ? arena_realloc(parser->arena, array->items, array->capacity * sizeof(JsonValue*),
+                            new_capacity * sizeof(JsonValue*))
+            : realloc(array->items, new_capacity * sizeof(JsonValue*));
+        if (!new_items) {
+            set_error(parser, "Memory allocation failed");
+            json_discard(parser, value);
+            return;
+        }
+        array->items = new_items;
+        array->capacity = new_capacity;
+    }
+    array->items[array->count++] = value;
+}
+
+// Same semantics as json_object_set (a repeated key replaces the value),
+// but takes ownership of the parsed key instead of copying it
+static void json_parser_object_set(JsonParser *parser, JsonObject *object, char *key, JsonValue *value) {
+    JsonProperty *prop = object->properties;
+    while (prop) {
+        if (strcmp(prop->key, key) == 0) {
+            json_discard(parser, prop->value);
+            prop->value = value;
+            json_release(parser, key);
+            return;
+        }
+        prop = prop->next;
+    }
+    
+    JsonProperty *new_prop = json_alloc(parser, sizeof(JsonProperty));
+    if (!new_prop) {
+        set_error(parser, "Memory allocation failed");
+        json_release(parser, key);
+        json_discard(parser, value);
+        return;
+    }
+    new_prop->key = key;
+    new_prop->value = value;
+    new_prop->next = object->properties;
+    object->properties = new_prop;
+    object->property_count++;
+}
+
 // Forward declarations for recursive parsing
 static JsonValue* parse_value(JsonParser *parser);
 static JsonObject* parse_object(JsonParser *parser);
@@ -99,7 +178,7 @@ static char* parse_string(JsonParser *parser) {
     }
     
     // Second pass: build string
-    char *result = malloc(str_length + 1);
+    char *result = json_alloc(parser, str_length + 1);
     if (!result) {
         set_error(parser, "Memory allocation failed");
         return NULL;
@@ -136,7 +215,7 @@ static char* parse_string(JsonParser *parser) {
         }
     }
     
-    free(result);
+    json_release(parser, result);
     set_error(parser, "Unterminated string");
     return NULL;
 }
@@ -191,28 +270,30 @@ static double parse_number(JsonParser *parser) {
         }
     }
     
-    // Extract number string and convert
+    // Extract number string and convert; ordinary numbers fit on the stack
     size_t length = parser->position - start;
-    char *number_str = malloc(length + 1);
+    char stack_str[64];
+    char *number_str = length < sizeof(stack_str) ? stack_str : json_alloc(parser, length + 1);
     if (!number_str) {
         set_error(parser, "Memory allocation failed");
         return 0.0;
     }
     
-    strncpy(number_str, parser->json_text + start, length);
+    memcpy(number_str, parser->json_text + start, length);
     number_str[length] = '\0';
     
     char *endptr;
     errno = 0;
     double result = strtod(number_str, &endptr);
+    int valid = errno != ERANGE && endptr == number_str + length;
     
-    if (errno == ERANGE || endptr != number_str + length) {
-        free(number_str);
+    if (number_str != stack_str) {
+        json_release(parser, number_str);
+    }
+    if (!valid) {
         set_error(parser, "Invalid number value");
         return 0.0;
     }
-    
-    free(number_str);
     return result;
 }
 
@@ -223,11 +304,14 @@ static JsonArray* parse_array(JsonParser *parser) {
         return NULL;
     }
     
-    JsonArray *array = json_create_array();
+    JsonArray *array = json_alloc(parser, sizeof(JsonArray));
     if (!array) {
         set_error(parser, "Memory allocation failed");
         return NULL;
     }
+    array->items = NULL;
+    array->count = 0;
+    array->capacity = 0;
     
     skip_whitespace(parser);
     
@@ -241,11 +325,12 @@ static JsonArray* parse_array(JsonParser *parser) {
     while (parser->position < parser->length && !parser->error_message) {
         JsonValue *value = parse_value(parser);
         if (!value) {
-            json_free_value(json_create_array_value(array));
+            json_discard_array(parser, array);
             return NULL;
         }
         
-        json_array_add(array, value);
+        json_parser_array_add(parser, array, value);
+        if (parser->error_message) break;
         
         skip_whitespace(parser);
         char c = peek_char(parser);
@@ -258,13 +343,13 @@ static JsonArray* parse_array(JsonParser *parser) {
             skip_whitespace(parser);
         } else {
             set_error(parser, "Expected ',' or ']' in array");
-            json_free_value(json_create_array_value(array));
+            json_discard_array(parser, array);
             return NULL;
         }
     }
     
     set_error(parser, "Unterminated array");
-    json_free_value(json_create_array_value(array));
+    json_discard_array(parser, array);
     return NULL;
 }
 
@@ -275,11 +360,13 @@ static JsonObject* parse_object(JsonParser *parser) {
         return NULL;
     }
     
-    JsonObject *object = json_create_object();
+    JsonObject *object = json_alloc(parser, sizeof(JsonObject));
     if (!object) {
         set_error(parser, "Memory allocation failed");
         return NULL;
     }
+    object->properties = NULL;
+    object->property_count = 0;
     
     skip_whitespace(parser);
     
@@ -296,13 +383,13 @@ static JsonObject* parse_object(JsonParser *parser) {
         // Parse key
         if (peek_char(parser) != '"') {
             set_error(parser, "Expected string key in object");
-            json_free_value(json_create_object_value(object));
+            json_discard_object(parser, object);
             return NULL;
         }
         
         char *key = parse_string(parser);
         if (!key) {
-            json_free_value(json_create_object_value(object));
+            json_discard_object(parser, object);
             return NULL;
         }
         
@@ -311,8 +398,8 @@ static JsonObject* parse_object(JsonParser *parser) {
         // Parse colon
         if (next_char(parser) != ':') {
             set_error(parser, "Expected ':' after object key");
-            free(key);
-            json_free_value(json_create_object_value(object));
+            json_release(parser, key);
+            json_discard_object(parser, object);
             return NULL;
         }
         
@@ -321,13 +408,13 @@ static JsonObject* parse_object(JsonParser *parser) {
         // Parse value
         JsonValue *value = parse_value(parser);
         if (!value) {
-            free(key);
-            json_free_value(json_create_object_value(object));
+            json_release(parser, key);
+            json_discard_object(parser, object);
             return NULL;
         }
         
-        json_object_set(object, key, value);
-        free(key);
+        json_parser_object_set(parser, object, key, value);
+        if (parser->error_message) break;
         
         skip_whitespace(parser);
         char c = peek_char(parser);
@@ -340,13 +427,13 @@ static JsonObject* parse_object(JsonParser *parser) {
             skip_whitespace(parser);
         } else {
             set_error(parser, "Expected ',' or '}' in object");
-            json_free_value(json_create_object_value(object));
+            json_discard_object(parser, object);
             return NULL;
         }
     }
     
     set_error(parser, "Unterminated object");
-    json_free_value(json_create_object_value(object));
+    json_discard_object(parser, object);
     return NULL;
 }
 
@@ -360,23 +447,43 @@ static JsonValue* parse_value(JsonParser *parser) {
         // String
         char *str = parse_string(parser);
         if (!str) return NULL;
-        JsonValue *value = json_create_string(str);
-        free(str); // Free the original string since json_create_string uses strdup
+        JsonValue *value = json_new_value(parser, JSON_STRING);
+        if (!value) {
+            json_release(parser, str);
+            return NULL;
+        }
+        value->data.string_value = str;  // The value takes the parsed string
         return value;
     } else if (c == '{') {
         // Object
         JsonObject *obj = parse_object(parser);
-        return obj ? json_create_object_value(obj) : NULL;
+        if (!obj) return NULL;
+        JsonValue *value = json_new_value(parser, JSON_OBJECT);
+        if (!value) {
+            json_discard_object(parser, obj);
+            return NULL;
+        }
+        value->data.object_value = obj;
+        return value;
     } else if (c == '[') {
         // Array
         JsonArray *arr = parse_array(parser);
-        return arr ? json_create_array_value(arr) : NULL;
+        if (!arr) return NULL;
+        JsonValue *value = json_new_value(parser, JSON_ARRAY);
+        if (!value) {
+            json_discard_array(parser, arr);
+            return NULL;
+        }
+        value->data.array_value = arr;
+        return value;
     } else if (c == 't') {
         // true
         if (parser->position + 4 <= parser->length && 
             strncmp(parser->json_text + parser->position, "true", 4) == 0) {
             parser->position += 4;
-            return json_create_bool(1);
+            JsonValue *value = json_new_value(parser, JSON_BOOL);
+            if (value) value->data.bool_value = 1;
+            return value;
         } else {
             set_error(parser, "Invalid literal 'true'");
             return NULL;
@@ -386,7 +493,9 @@ static JsonValue* parse_value(JsonParser *parser) {
         if (parser->position + 5 <= parser->length && 
             strncmp(parser->json_text + parser->position, "false", 5) == 0) {
             parser->position += 5;
-            return json_create_bool(0);
+            JsonValue *value = json_new_value(parser, JSON_BOOL);
+            if (value) value->data.bool_value = 0;
+            return value;
         } else {
             set_error(parser, "Invalid literal 'false'");
             return NULL;
@@ -396,7 +505,7 @@ static JsonValue* parse_value(JsonParser *parser) {
         if (parser->position + 4 <= parser->length && 
             strncmp(parser->json_text + parser->position, "null", 4) == 0) {
             parser->position += 4;
-            return json_create_null();
+            return json_new_value(parser, JSON_NULL);
         } else {
             set_error(parser, "Invalid literal 'null'");
             return NULL;
@@ -404,7 +513,10 @@ static JsonValue* parse_value(JsonParser *parser) {
     } else if (c == '-' || isdigit(c)) {
         // Number
         double num = parse_number(parser);
-        return parser->error_message ? NULL : json_create_number(num);
+        if (parser->error_message) return NULL;
+        JsonValue *value = json_new_value(parser, JSON_NUMBER);
+        if (value) value->data.number_value = num;
+        return value;
     } else {
         set_error(parser, "Unexpected character");
         return NULL;
@@ -423,6 +535,10 @@ JsonValue* json_parse(const char *json_text) {
 }
 
 JsonValue* json_parse_with_error(const char *json_text, char **error_message) {
+    return json_parse_arena(json_text, error_message, NULL);
+}
+
+JsonValue* json_parse_arena(const char *json_text, char **error_message, struct Arena *arena) {
     if (!json_text) {
         *error_message = strdup("JSON text is NULL");
         return NULL;
@@ -432,7 +548,8 @@ JsonValue* json_parse_with_error(const char *json_text, char **error_message) {
         .json_text = json_text,
         .position = 0,
         .length = strlen(json_text),
-        .error_message = NULL
+        .error_message = NULL,
+        .arena = arena
     };
     
     JsonValue *result = parse_value(&parser);
@@ -440,7 +557,7 @@ JsonValue* json_parse_with_error(const char *json_text, char **error_message) {
     if (parser.error_message) {
         *error_message = parser.error_message;
         if (result) {
-            json_free_value(result);
+            json_discard(&parser, result);
             result = NULL;
         }
     } else {
@@ -451,7 +568,7 @@ JsonValue* json_parse_with_error(const char *json_text, char **error_message) {
         if (parser.position < parser.length) {
             *error_message = strdup("Unexpected content after JSON value");
             if (result) {
-                json_free_value(result);
+                json_discard(&parser, result);
                 result = NULL;
             }
         }
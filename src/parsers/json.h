@@ -51,12 +51,15 @@ struct JsonArray {
     int capacity;
 };
 
+struct Arena;
+
 // JSON parsing context
 typedef struct {
     const char *json_text;
     size_t position;
     size_t length;
     char *error_message;
+    struct Arena *arena;         // Where the tree is allocated; NULL for the heap
 } JsonParser;
 
 // JSON validation schema
@@ -85,6 +88,9 @@ typedef struct {
 // JSON parsing functions
 JsonValue* json_parse(const char *json_text);
 JsonValue* json_parse_with_error(const char *json_text, char **error_message);
+// Parse into an arena: the tree is released with the arena and must not be
+// passed to json_free_value. *error_message is still heap-allocated.
+JsonValue* json_parse_arena(const char *json_text, char **error_message, struct Arena *arena);
 void json_free_value(JsonValue *value);
 
 // JSON object functions
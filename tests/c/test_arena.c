@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/core/app.h"
+#include "../src/core/arena.h"
+#include "test_helpers.h"
+
+static int handler_calls = 0;
+static int handler_ok = 0;
+
+// Touches every per-request allocation site: params, JSON, negotiation,
+// a thrown error and the response
+static void user_handler(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    Response *res = (Response *)ctx->user_context;
+    Request *req = ctx->req;
+
+    JsonValue *body = request_get_json(req);
+    JsonValue *name = body ? json_object_get(body->data.object_value, "name") : NULL;
+    const char *id = req->get_param(req, "id");
+
+    handler_calls++;
+    if (id && strcmp(id, "42") == 0 && name && strcmp(name->data.string_value, "ada") == 0 && accepts_json(req)) {
+        handler_ok++;
+    }
+    if (strcmp(id ? id : "", "0") == 0) {
+        THROW_ERROR(ctx->error_ctx, ERROR_NOT_FOUND, "No such user");
+        return;
+    }
+    res->json(res, "{\"ok\":true}");
+}
+
+int main() {
+    printf("Testing per-request arena...\n");
+
+    // Test 1: Alignment, spilling past the first buffer and reuse after reset
+    printf("\nTest 1: Arena basics\n");
+    {
+        char initial[64];
+        Arena arena;
+        arena_init(&arena, initial, sizeof(initial));
+
+        char *a = arena_alloc(&arena, 3);
+        double *b = arena_alloc(&arena, sizeof(double));
+        CHECK(a >= initial && a < initial + sizeof(initial), "small allocation served from the first buffer");
+        CHECK(((uintptr_t)b & 7) == 0, "allocations are 8-byte aligned");
+
+        char *big = arena_alloc(&arena, 1000);
+        CHECK(big && (big < initial || big >= initial + sizeof(initial)), "overflow spills into a block");
+        memset(big, 'x', 1000);
+
+        char *huge = arena_alloc(&arena, ARENA_BLOCK_SIZE * 2);
+        CHECK(huge != NULL, "oversized allocation gets its own block");
+        memset(huge, 'y', ARENA_BLOCK_SIZE * 2);
+
+        char *copy = arena_strndup(&arena, "hello world", 5);
+        CHECK(copy && strcmp(copy, "hello") == 0, "arena_strndup copies and terminates");
+
+        arena_reset(&arena);
+        size_t before = arena_thread_heap_allocations();
+        for (int i = 0; i < 100; i++) {
+            arena_alloc(&arena, 1000);
+            arena_reset(&arena);
+        }
+        CHECK(arena_thread_heap_allocations() == before, "reset blocks are reused without malloc");
+        CHECK(arena_alloc(&arena, 8) == (void *)initial, "reset rewinds the first buffer");
+        arena_reset(&arena);
+    }
+
+    // Test 2: JSON trees built in the arena
+    printf("\nTest 2: json_parse_arena\n");
+    {
+        Arena arena;
+        arena_init(&arena, NULL, 0);
+        char *error = NULL;
+        JsonValue *value = json_parse_arena("{\"a\":[1,2,3,4,5],\"b\":\"s\\tA\",\"a\":true}", &error, &arena);
+        JsonValue *a = value ? json_object_get(value->data.object_value, "a") : NULL;
+        JsonValue *b = value ? json_object_get(value->data.object_value, "b") : NULL;
+        CHECK(value && value->type == JSON_OBJECT, "object parsed");
+        CHECK(a && a->type == JSON_BOOL && a->data.bool_value == 1, "repeated key replaces the value");
+        CHECK(b && strcmp(b->data.string_value, "s\tA") == 0, "escapes decoded");
+        CHECK(arena.allocations > 0, "tree allocated from the arena");
+
+        JsonValue *bad = json_parse_arena("{\"a\":[1,2,", &error, &arena);
+        CHECK(bad == NULL && error != NULL, "errors reported without a tree to free");
+        free(error);
+        arena_reset(&arena);
+    }
+
+    // Test 3: Full dispatch stays off the heap once warmed up
+    printf("\nTest 3: Dispatch allocations\n");
+    {
+        int fd = open("/dev/null", O_WRONLY);
+        App app = create_app();
+        app.get(&app, "/users/:id", user_handler);
+
+        const char *ok = "GET /users/42?x=1 HTTP/1.1\r\nHost: test\r\nAccept: application/json\r\n"
+                         "Content-Type: application/json\r\nContent-Length: 14\r\n\r\n{\"name\":\"ada\"}";
+        const char *thrown = "GET /users/0 HTTP/1.1\r\nHost: test\r\n\r\n";
+        const char *missing = "GET /nowhere HTTP/1.1\r\nHost: test\r\n\r\n";
+
+        for (int i = 0; i < 4; i++) {
+            test_dispatch(&app, fd, ok);
+            test_dispatch(&app, fd, thrown);
+            test_dispatch(&app, fd, missing);
+        }
+        size_t before = arena_thread_heap_allocations();
+        handler_calls = handler_ok = 0;
+        for (int i = 0; i < 1000; i++) {
+            test_dispatch(&app, fd, ok);
+            test_dispatch(&app, fd, thrown);
+            test_dispatch(&app, fd, missing);
+        }
+        char msg[128];
+        snprintf(msg, sizeof(msg), "handlers saw params, JSON and Accept (%d/1000)", handler_ok);
+        CHECK(handler_calls == 2000 && handler_ok == 1000, msg);
+        snprintf(msg, sizeof(msg), "no arena blocks malloc'd after warm-up (%zu)",
+                 arena_thread_heap_allocations() - before);
+        CHECK(arena_thread_heap_allocations() == before, msg);
+        close(fd);
+
+        for (int i = 0; i < app.router.layer_count; i++) {
+            free_route_pattern((RoutePattern *)app.router.layers[i].pattern);
+        }
+        free(app.router.layers);
+        route_tree_destroy(app.router.tree);
+    }
+
+    return test_report("Arena");
+}
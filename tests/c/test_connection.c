@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "../src/http/connection.h"
+#include "test_helpers.h"
+
+int main() {
+    printf("Testing Connection framing and output queue...\n");
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+
+    Connection *conn = connection_create(fds[0]);
+    CHECK(conn != NULL, "connection created");
+    CHECK(conn->state == CONN_READING_HEADERS, "starts in CONN_READING_HEADERS");
+
+    // Test 1: Head arrives in two pieces
+    printf("\nTest 1: Partial head\n");
+    const char *part1 = "POST /echo HTTP/1.1\r\nHost: localhost\r\ncontent-length: 5\r\n";
+    const char *part2 = "\r\nhel";
+    const char *part3 = "lo";
+
+    write(fds[1], part1, strlen(part1));
+    CHECK(connection_fill(conn) == CONN_IO_OK, "fill reads first piece");
+    CHECK(!connection_request_ready(conn), "request not ready without terminator");
+    CHECK(connection_fill(conn) == CONN_IO_AGAIN, "fill reports EAGAIN when drained");
+
+    // Test 2: Terminator and part of the body
+    printf("\nTest 2: Head complete, body pending\n");
+    write(fds[1], part2, strlen(part2));
+    connection_fill(conn);
+    CHECK(conn->header_len == strlen(part1) + 2, "header_len covers the terminator");
+    CHECK(conn->body_len == 5, "Content-Length parsed case-insensitively");
+    CHECK(conn->state == CONN_READING_BODY, "moved to CONN_READING_BODY");
+    CHECK(!connection_request_ready(conn), "request waits for the full body");
+
+    write(fds[1], part3, strlen(part3));
+    connection_fill(conn);
+    CHECK(connection_request_ready(conn), "request ready once body arrives");
+    CHECK(memcmp(conn->in_buf + conn->header_len, "hello", 5) == 0, "body bytes buffered");
+
+    // Test 3: Output queue used while the connection is active
+    printf("\nTest 3: Queued output\n");
+    connection_set_active(conn);
+    connection_send(fds[0], "HTTP/1.1 200 OK\r\n", 17);
+    connection_send(fds[0], "\r\n", 2);
+    connection_set_active(NULL);
+    CHECK(connection_has_pending_output(conn), "response bytes queued, not written");
+    CHECK(connection_flush(conn) == CONN_IO_OK, "flush drains the queue");
+    CHECK(!connection_has_pending_output(conn), "queue empty after flush");
+
+    char buffer[64] = {0};
+    ssize_t n = read(fds[1], buffer, sizeof(buffer) - 1);
+    CHECK(n == 19 && strncmp(buffer, "HTTP/1.1 200 OK", 15) == 0, "peer received the response");
+
+    // Test 4: Oversized head is rejected
+    printf("\nTest 4: Oversized head\n");
+    Connection *big = connection_create(fds[0]);
+    char *junk = malloc(CONNECTION_MAX_HEADER_SIZE + 16);
+    memset(junk, 'a', CONNECTION_MAX_HEADER_SIZE + 16);
+    write(fds[1], junk, CONNECTION_MAX_HEADER_SIZE + 16);
+    CHECK(connection_fill(big) == CONN_IO_ERROR, "fill fails past CONNECTION_MAX_HEADER_SIZE");
+    free(junk);
+
+    connection_destroy(big);
+
+    // Test 5: Keep-alive negotiation
+    printf("\nTest 5: Keep-alive negotiation\n");
+    const char *h11 = "GET / HTTP/1.1\r\nHost: x\r\n\r\n";
+    const char *h11_close = "GET / HTTP/1.1\r\nconnection: Close\r\n\r\n";
+    const char *h10 = "GET / HTTP/1.0\r\n\r\n";
+    const char *h10_keep = "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+    CHECK(connection_wants_keep_alive(h11, strlen(h11)), "HTTP/1.1 defaults to keep-alive");
+    CHECK(!connection_wants_keep_alive(h11_close, strlen(h11_close)), "Connection: close honoured");
+    CHECK(!connection_wants_keep_alive(h10, strlen(h10)), "HTTP/1.0 defaults to close");
+    CHECK(connection_wants_keep_alive(h10_keep, strlen(h10_keep)), "HTTP/1.0 keep-alive opt-in");
+
+    // Test 6: Reset keeps bytes of the next request
+    printf("\nTest 6: Reset for the next request\n");
+    Connection *ka = connection_create(fds[0]);
+    const char *two = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n";
+    write(fds[1], two, strlen(two));
+    connection_fill(ka);
+    CHECK(connection_request_ready(ka) && ka->keep_alive, "first request framed as keep-alive");
+    connection_reset(ka);
+    CHECK(connection_request_ready(ka), "second request framed from leftover bytes");
+    CHECK(strncmp(ka->in_buf, "GET /b", 6) == 0, "leftover moved to the buffer start");
+    connection_reset(ka);
+    CHECK(ka->in_len == 0 && ka->state == CONN_READING_HEADERS, "buffer empty after last request");
+    connection_destroy(ka);
+
+    // Test 7: Bytes appended by a completion-based backend
+    printf("\nTest 7: Appended input\n");
+    Connection *ring = connection_create(fds[0]);
+    const char *head = "GET /x HTTP/1.1\r\nHost: x\r";
+    CHECK(connection_append(ring, head, strlen(head)) == CONN_IO_OK, "partial head appended");
+    CHECK(!connection_request_ready(ring), "request waits for the terminator");
+    CHECK(connection_append(ring, "\n\r\n", 3) == CONN_IO_OK && connection_request_ready(ring),
+          "terminator split across appends is found");
+
+    // Test 8: Idle list ordering
+    printf("\nTest 8: Idle list\n");
+    ConnectionList idle = { NULL, NULL };
+    connection_list_touch(&idle, ring, 1);
+    connection_list_touch(&idle, conn, 2);
+    CHECK(idle.head == ring && idle.tail == conn, "least recently active at the head");
+    connection_list_touch(&idle, ring, 3);
+    CHECK(idle.head == conn && idle.tail == ring && ring->last_active == 3, "touch moves to the tail");
+    connection_list_remove(&idle, conn);
+    connection_list_remove(&idle, ring);
+    CHECK(idle.head == NULL && idle.tail == NULL, "list empty after removals");
+    connection_destroy(ring);
+
+    // Test 9: Gathered sends
+    printf("\nTest 9: Gathered sends\n");
+    size_t payload_len = 256 * 1024;
+    char *payload = malloc(payload_len);
+    for (size_t i = 0; i < payload_len; i++) payload[i] = (char)('a' + i % 26);
+    struct iovec iov[2] = { { "HEAD\r\n", 6 }, { payload, payload_len } };
+
+    size_t before = conn->out_total;
+    connection_set_active(conn);
+    CHECK(connection_sendv(fds[0], iov, 1) == 6 && conn->out_len == 6, "small send queued");
+    char chunk[4096];
+    CHECK(connection_flush(conn) == CONN_IO_OK && read(fds[1], chunk, sizeof(chunk)) == 6, "small send flushed");
+    CHECK(connection_sendv(fds[0], iov, 2) == (ssize_t)(6 + payload_len), "large send taken whole");
+    connection_set_active(NULL);
+    CHECK(conn->out_total - before == 12 + payload_len, "every byte counted, written or queued");
+    CHECK(conn->out_len < payload_len && connection_has_pending_output(conn), "written at once, remainder queued");
+
+    size_t received = 0, matched = 1;
+    while (received < 6 + payload_len) {
+        connection_flush(conn);
+        ssize_t got = read(fds[1], chunk, sizeof(chunk));
+        if (got <= 0) break;
+        for (ssize_t i = 0; i < got; i++, received++) {
+            char want = received < 6 ? "HEAD\r\n"[received] : payload[received - 6];
+            if (chunk[i] != want) matched = 0;
+        }
+    }
+    CHECK(received == 6 + payload_len && matched && !connection_has_pending_output(conn), "peer received both in order");
+
+    // Without an event loop the caller waits for every byte, even on a
+    // non-blocking fd that fills up
+    int pipe_fds[2];
+    pipe(pipe_fds);
+    fcntl(pipe_fds[1], F_SETFL, fcntl(pipe_fds[1], F_GETFL, 0) | O_NONBLOCK);
+    pid_t reader = fork();
+    if (reader == 0) {
+        close(pipe_fds[1]);
+        size_t total = 0;
+        int same = 1;
+        ssize_t got;
+        while ((got = read(pipe_fds[0], chunk, sizeof(chunk))) > 0) {
+            for (ssize_t i = 0; i < got; i++, total++) {
+                char want = total < 6 ? "HEAD\r\n"[total] : payload[total - 6];
+                if (chunk[i] != want) same = 0;
+            }
+        }
+        _exit(same && total == 6 + payload_len ? 0 : 1);
+    }
+    close(pipe_fds[0]);
+    CHECK(connection_sendv(pipe_fds[1], iov, 2) == (ssize_t)(6 + payload_len), "blocking send writes everything");
+    close(pipe_fds[1]);
+    int status = 0;
+    waitpid(reader, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "reader got every byte in order");
+    free(payload);
+
+
+    connection_destroy(conn);
+    close(fds[0]);
+    close(fds[1]);
+
+    return test_report("Connection");
+}
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../src/core/app.h"
+#include "test_helpers.h"
+
+// Many threads dispatching through one App at once. Every handler checks
+// that the parameters, query and context it sees belong to its own
+// request. Build with -fsanitize=thread (make test-tsan) to catch races.
+
+#define THREADS 8
+#define ROUNDS 1500
+
+// Per-thread tallies, summed by each worker when it finishes
+static __thread int handled_ok;
+static __thread int handled_bad;
+
+static void tally(int ok) {
+    if (ok) handled_ok++;
+    else handled_bad++;
+}
+
+// Middleware with its own parameter: must not leak into the route's params
+static void user_middleware(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd;
+    NextContext *ctx = (NextContext *)context;
+    const char *id = ctx->req->get_param(ctx->req, "id");
+    tally(id && ctx->req->param_count == 1);
+    next(ctx);
+}
+
+// /users/:id:number/items/:item, where the client always sends item = "i<id>"
+static void item_handler(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    Request *req = ctx->req;
+    Response *res = (Response *)ctx->user_context;
+    const char *id = req->get_param(req, "id");
+    const char *item = req->get_param(req, "item");
+    const char *page = req->get_query(req, "page");
+
+    tally(res && id && item && page && item[0] == 'i' && strcmp(item + 1, id) == 0 &&
+          strcmp(page, id) == 0 && accepts_json(req));
+    res->json(res, "{\"ok\":true}");
+}
+
+// /colors/:color:slug(enum=red|green|blue) exercises constraint validation
+static void color_handler(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    const char *color = ctx->req->get_param(ctx->req, "color");
+    tally(color && (strcmp(color, "red") == 0 || strcmp(color, "blue") == 0));
+    ((Response *)ctx->user_context)->send(ctx->user_context, color);
+}
+
+// Mounted at /api: sees the app's response and error context
+static void order_handler(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    const char *order = ctx->req->get_param(ctx->req, "order");
+    tally(ctx->user_context && ctx->error_ctx && order && atoi(order) > 0);
+    if (order && atoi(order) % 2 == 0) {
+        THROW_ERROR(ctx->error_ctx, ERROR_NOT_FOUND, "No such order");
+        return;
+    }
+    ((Response *)ctx->user_context)->send(ctx->user_context, order);
+}
+
+typedef struct {
+    App *app;
+    int index;
+    int ok;
+    int bad;
+} Worker;
+
+static void *worker_main(void *arg) {
+    Worker *worker = (Worker *)arg;
+    int fd = open("/dev/null", O_WRONLY);
+    char raw[256];
+
+    for (int i = 0; i < ROUNDS; i++) {
+        int id = worker->index * 100000 + i;
+        snprintf(raw, sizeof(raw), "GET /users/%d/items/i%d?page=%d HTTP/1.1\r\nHost: t\r\n"
+                 "Accept: text/html;q=0.5, application/json\r\n\r\n", id, id, id);
+        test_dispatch(worker->app, fd, raw);
+        snprintf(raw, sizeof(raw), "GET /colors/%s HTTP/1.1\r\nHost: t\r\n\r\n",
+                 (i % 3 == 0) ? "red" : (i % 3 == 1) ? "blue" : "mauve");
+        test_dispatch(worker->app, fd, raw);
+        snprintf(raw, sizeof(raw), "GET /api/orders/%d HTTP/1.1\r\nHost: t\r\n\r\n", id + 1);
+        test_dispatch(worker->app, fd, raw);
+    }
+    close(fd);
+    worker->ok = handled_ok;
+    worker->bad = handled_bad;
+    return NULL;
+}
+
+// Run every worker against the app; returns the ok tallies, *bad the rest
+static int run_workers(App *app, int *bad) {
+    pthread_t threads[THREADS];
+    Worker workers[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        workers[i].app = app;
+        workers[i].index = i;
+        workers[i].ok = workers[i].bad = 0;
+        pthread_create(&threads[i], NULL, worker_main, &workers[i]);
+    }
+
+    int ok = 0;
+    *bad = 0;
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        ok += workers[i].ok;
+        *bad += workers[i].bad;
+    }
+    return ok;
+}
+
+int main() {
+    printf("Testing concurrent dispatch through one App...\n");
+
+    App app = create_app();
+    Router *api = create_router();
+    router_get(api, "/orders/:order", order_handler);
+    router_use(&app.router, "/users/:id/*", user_middleware);
+    app.get(&app, "/users/:id:number/items/:item", item_handler);
+    app.get(&app, "/colors/:color:slug(enum=red|green|blue)", color_handler);
+    app.mount(&app, "/api", api);
+
+    // Per round: middleware + item handler, one color (two of three pass
+    // the enum constraint) and one order
+    int expected = THREADS * (ROUNDS * 3 + (ROUNDS - ROUNDS / 3));
+    char msg[128];
+    int bad = 0;
+    int ok = run_workers(&app, &bad);
+    snprintf(msg, sizeof(msg), "every handler saw its own request (%d/%d)", ok, expected);
+    CHECK(ok == expected && bad == 0, msg);
+
+    // The same through the frozen chains workers use once listening
+    app_freeze(&app);
+    ok = run_workers(&app, &bad);
+    snprintf(msg, sizeof(msg), "frozen: every handler saw its own request (%d/%d)", ok, expected);
+    CHECK(app.frozen && ok == expected && bad == 0, msg);
+    app_thaw(&app);
+
+    for (int i = 0; i < app.router.layer_count; i++) {
+        free_route_pattern((RoutePattern *)app.router.layers[i].pattern);
+        free((char *)app.router.layers[i].mount_prefix);
+    }
+    free(app.router.layers);
+    route_tree_destroy(app.router.tree);
+    destroy_router(api);
+
+    return test_report("Concurrent dispatch");
+}
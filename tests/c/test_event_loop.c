@@ -0,0 +1,160 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../src/core/app.h"
+#include "../src/core/event_loop.h"
+#include "test_helpers.h"
+
+// Pipelining through the epoll loop: the client writes several requests in
+// one segment and reads back what the loop sends, while each handler notes
+// how much the loop had sent on the connection before it ran
+
+#define BIG_BODY 10000  // Queued, not sent during dispatch; a few fill the output cap
+
+static App app;
+static int dispatched = 0;
+static size_t written[32];
+static int closed;            // The loop closed the last connection
+
+// What the loop had written to the client by the time a handler ran
+static void note_dispatch(void) {
+    Connection *conn = connection_get_active();
+    written[dispatched++] = conn ? conn->out_total - (conn->out_len - conn->out_pos) : 0;
+}
+
+static void echo_path(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = context;
+    Response *res = ctx->user_context;
+    note_dispatch();
+    res->send(res, ctx->req->path);
+}
+
+static void big(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = context;
+    Response *res = ctx->user_context;
+    static char body[BIG_BODY + 1];
+    memset(body, 'x', BIG_BODY);
+    note_dispatch();
+    res->send(res, body);
+}
+
+static struct sockaddr_un address;
+
+static void *loop_main(void *arg) {
+    event_loop_run(&app, *(int *)arg);
+    return NULL;
+}
+
+// Connect, send `raw` in one write and read until the loop closes the
+// connection (every batch ends with a closing request)
+static size_t exchange(const char *raw, char *out, size_t size) {
+    dispatched = 0;
+    closed = 0;
+    memset(written, 0, sizeof(written));
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client < 0 || connect(client, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("connect");
+        return 0;
+    }
+    if (write(client, raw, strlen(raw)) != (ssize_t)strlen(raw)) return 0;
+
+    size_t total = 0;
+    struct pollfd pfd = { client, POLLIN, 0 };
+    while (total < size - 1 && poll(&pfd, 1, 2000) > 0) {
+        ssize_t n = read(client, out + total, size - 1 - total);
+        if (n <= 0) {
+            closed = n == 0;
+            break;
+        }
+        total += (size_t)n;
+    }
+    out[total] = '\0';
+    close(client);
+    return total;
+}
+
+static int count(const char *haystack, const char *needle) {
+    int found = 0;
+    for (const char *at = strstr(haystack, needle); at; at = strstr(at + 1, needle)) found++;
+    return found;
+}
+
+int main() {
+    printf("Testing pipelining in the event loop...\n");
+#if !C_EXPRESS_HAVE_EPOLL
+    printf("\nepoll unavailable, skipped\n");
+    return 0;
+#endif
+
+    app = create_app();
+    app.get(&app, "/one", echo_path);
+    app.get(&app, "/two", echo_path);
+    app.get(&app, "/three", echo_path);
+    app.get(&app, "/big", big);
+    app_freeze(&app);
+
+    // An abstract socket: nothing to clean up, and sends reach the peer at once
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path + 1, sizeof(address.sun_path) - 1, "c-express-event-loop-%d", (int)getpid());
+    if (server_fd < 0 || bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        listen(server_fd, 8) < 0) {
+        perror("listen");
+        return 1;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, loop_main, &server_fd);
+
+    static char out[256 * 1024];
+
+    // Test 1: Responses in request order, sent together
+    printf("\nTest 1: Batched responses\n");
+    exchange("GET /one HTTP/1.1\r\n\r\n"
+             "GET /two HTTP/1.1\r\n\r\n"
+             "GET /three HTTP/1.1\r\nConnection: close\r\n\r\n", out, sizeof(out));
+    char *one = strstr(out, "\r\n\r\n/one");
+    char *two = strstr(out, "\r\n\r\n/two");
+    char *three = strstr(out, "\r\n\r\n/three");
+    CHECK(dispatched == 3 && count(out, "HTTP/1.1 200") == 3 && closed, "every request answered");
+    CHECK(one && two && three && one < two && two < three, "responses in request order");
+    CHECK(written[1] == 0 && written[2] == 0, "nothing sent until the batch was dispatched");
+
+    // Test 2: Dispatch pauses once the queued output reaches the cap
+    printf("\nTest 2: Output cap\n");
+    char raw[2048] = "";
+    for (int i = 0; i < 11; i++) strcat(raw, "GET /big HTTP/1.1\r\n\r\n");
+    strcat(raw, "GET /one HTTP/1.1\r\nConnection: close\r\n\r\n");
+    exchange(raw, out, sizeof(out));
+    CHECK(dispatched == 12 && count(out, "HTTP/1.1 200") == 12, "every request answered");
+    char *second = strstr(out + 1, "HTTP/1.1 200");
+    size_t response_size = second ? (size_t)(second - out) : 0;
+    int fills = response_size ? (int)((CONNECTION_MAX_PENDING_OUTPUT + response_size - 1) / response_size) : 0;
+    int held = fills > 1 && fills < 11;
+    for (int i = 0; held && i < fills; i++) held = written[i] == 0;
+    CHECK(held, "responses queued up to the cap");
+    CHECK(held && written[fills] == fills * response_size, "queue flushed before dispatching past the cap");
+
+    // Test 3: A closing request ends the batch
+    printf("\nTest 3: Connection: close mid-batch\n");
+    exchange("GET /one HTTP/1.1\r\n\r\n"
+             "GET /two HTTP/1.1\r\nConnection: close\r\n\r\n"
+             "GET /three HTTP/1.1\r\n\r\n", out, sizeof(out));
+    two = strstr(out, "\r\n\r\n/two");
+    CHECK(dispatched == 2 && count(out, "HTTP/1.1 200") == 2, "requests after the closing one not served");
+    CHECK(strstr(out, "/one") && two && !strstr(out, "/three"), "only the first two answered");
+    char *header = strstr(out, "\r\n\r\n/one");
+    header = header ? strstr(header, "Connection: close\r\n") : NULL;
+    CHECK(header && header < two, "closing response says so");
+    CHECK(closed, "connection closed after it");
+
+    close(server_fd);
+    return test_report("Event loop");
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/core/app.h"
+#include "../src/core/frozen_router.h"
+#include "test_helpers.h"
+
+// Every handler appends a tag (and the parameter it reads) to the trace
+static char trace[256];
+
+static void note(NextContext *ctx, const char *tag, const char *param) {
+    const char *value = param ? ctx->req->get_param(ctx->req, param) : NULL;
+    size_t used = strlen(trace);
+    snprintf(trace + used, sizeof(trace) - used, "%s%s%s%s", used ? " " : "", tag,
+             value ? ":" : "", value ? value : "");
+}
+
+#define TRACE_HANDLER(fn, tag, param, calls_next) \
+    static void fn(int client_fd, void (*next)(void *), void *context) { \
+        (void)client_fd; \
+        note((NextContext *)context, tag, param); \
+        if (calls_next) next(context); \
+    }
+
+TRACE_HANDLER(mw_all, "all", NULL, 1)
+TRACE_HANDLER(mw_user, "mwuser", "id", 1)
+TRACE_HANDLER(h_user, "user", "id", 1)
+TRACE_HANDLER(h_name, "name", "name", 1)
+TRACE_HANDLER(h_me, "me", NULL, 0)
+TRACE_HANDLER(h_post, "post", "id", 0)
+TRACE_HANDLER(h_health, "health", NULL, 1)
+TRACE_HANDLER(h_files, "files", NULL, 1)
+TRACE_HANDLER(h_purge, "purge", "key", 0)
+TRACE_HANDLER(mw_api, "api-mw", NULL, 1)
+TRACE_HANDLER(h_api_root, "api-root", NULL, 0)
+TRACE_HANDLER(h_item, "item", "id", 1)
+TRACE_HANDLER(h_ping, "ping", NULL, 0)
+TRACE_HANDLER(mw_tail, "tail", NULL, 1)
+
+static int out_fds[2];
+
+// Dispatch one request; returns the status line code written, if any
+static int dispatch(App *app, const char *raw) {
+    char out[512];
+    trace[0] = '\0';
+    test_dispatch(app, out_fds[1], raw);
+    test_read_response(out_fds[0], out, sizeof(out));
+    int code = test_status(out);
+    if (code == 405 && !strstr(out, "Allow: GET, POST\r\n")) code = -405;
+    return code;
+}
+
+typedef struct {
+    const char *raw;
+    const char *expected;
+    int status;
+    int same_unfrozen;      // Mounted routers now fall through to the parent, and
+                            // nested mounts strip their prefix from the parent's path
+} Case;
+
+static const Case cases[] = {
+    { "GET /users/5 HTTP/1.1\r\n\r\n", "all mwuser:5 user:5 name:5 tail", 0, 1 },
+    { "GET /users/me HTTP/1.1\r\n\r\n", "all mwuser:me name:me me", 0, 1 },
+    { "POST /users/9 HTTP/1.1\r\n\r\n", "all mwuser:9 post:9", 0, 1 },
+    { "GET /users/bob/extra HTTP/1.1\r\n\r\n", "all mwuser:bob tail", 404, 1 },
+    { "DELETE /users/5 HTTP/1.1\r\n\r\n", "all mwuser:5 tail", 405, 1 },
+    { "GET /health HTTP/1.1\r\n\r\n", "all health tail", 0, 1 },
+    { "GET /files/a/b HTTP/1.1\r\n\r\n", "all files tail", 0, 1 },
+    { "PURGE /cache/k1 HTTP/1.1\r\n\r\n", "all purge:k1", 0, 1 },
+    { "BREW /cache/k1 HTTP/1.1\r\n\r\n", "all tail", 404, 1 },
+    { "GET /api HTTP/1.1\r\n\r\n", "all api-mw api-root", 0, 1 },
+    { "GET /api/v2/ping HTTP/1.1\r\n\r\n", "all api-mw ping", 0, 0 },
+    { "GET /api/items/7 HTTP/1.1\r\n\r\n", "all api-mw item:7 tail", 0, 0 },
+    { "GET /api/nothing HTTP/1.1\r\n\r\n", "all api-mw tail", 404, 0 },
+};
+
+static const FrozenChain *chain_for(const FrozenRouter *frozen, const char *path) {
+    for (int i = 0; i < frozen->layer_count; i++) {
+        const Layer *layer = frozen->layers[i].layer;
+        if (layer->type == LAYER_HANDLER && strcmp(layer->path, path) == 0) return &frozen->chains[i];
+    }
+    return NULL;
+}
+
+int main() {
+    printf("Testing frozen dispatch...\n");
+    if (test_response_pipe(out_fds) != 0) return 1;
+
+    App app = create_app();
+    Router *api = create_router();
+    Router *v2 = create_router();
+    router_get(v2, "/ping", h_ping);
+    router_use(api, "/", mw_api);
+    router_get(api, "/", h_api_root);
+    router_get(api, "/items/:id:number", h_item);
+    router_mount(api, "/v2", v2);
+
+    app.use(&app, mw_all);
+    router_use(&app.router, "/users/:id/*", mw_user);
+    app.get(&app, "/users/:id:number", h_user);
+    app.get(&app, "/users/:name", h_name);
+    app.get(&app, "/users/me", h_me);
+    app.post(&app, "/users/:id", h_post);
+    app.get(&app, "/health", h_health);
+    app.get(&app, "/files/*", h_files);
+    router_add_layer(&app.router, "PURGE", "/cache/:key", h_purge);
+    app.mount(&app, "/api", api);
+    app.use(&app, mw_tail);
+
+    // Test 1: Unfrozen dispatch, as the reference
+    printf("\nTest 1: Unfrozen dispatch\n");
+    char unfrozen[sizeof(cases) / sizeof(cases[0])][256];
+    int unfrozen_status[sizeof(cases) / sizeof(cases[0])];
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        unfrozen_status[i] = dispatch(&app, cases[i].raw);
+        memcpy(unfrozen[i], trace, sizeof(trace));
+    }
+    CHECK(app.frozen == NULL, "apps start unfrozen");
+
+    // Test 2: Flattened layers and precomputed chains
+    printf("\nTest 2: Freeze\n");
+    app_freeze(&app);
+    const FrozenRouter *frozen = app.frozen;
+    CHECK(frozen && frozen->group_count == 3 && frozen->layer_count == 15, "mounted routers flattened in place");
+    const FrozenChain *health = frozen ? chain_for(frozen, "/health") : NULL;
+    CHECK(health && health->step_count == 4 && health->steps[0].kind == STEP_ALWAYS &&
+          health->steps[1].kind == STEP_ALWAYS && health->steps[2].kind == STEP_ROUTE &&
+          health->steps[3].kind == STEP_ALWAYS, "static route: middleware decided at freeze time");
+    const FrozenChain *user = frozen ? chain_for(frozen, "/users/:id:number") : NULL;
+    int has_post = 0, has_api = 0;
+    for (int i = 0; user && i < user->step_count; i++) {
+        has_post |= strcmp(user->steps[i].layer->layer->path, "/users/:id") == 0;
+        has_api |= user->steps[i].layer->prefix_len > 0;
+    }
+    CHECK(user && user->step_count == 6 && !has_post && !has_api,
+          "parameter route: other methods and other mounts pruned");
+    CHECK(frozen && frozen->unmatched.step_count == 5 && frozen->unmatched.steps[2].kind == STEP_CHECK,
+          "unmatched chain holds the middleware only");
+
+    // Test 3: Frozen dispatch against the expected chains
+    printf("\nTest 3: Frozen dispatch\n");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int status = dispatch(&app, cases[i].raw);
+        char msg[256];
+        snprintf(msg, sizeof(msg), "%.*s -> %.160s (%d)", (int)(strchr(cases[i].raw, '\r') - cases[i].raw),
+                 cases[i].raw, trace, status);
+        int ok = strcmp(trace, cases[i].expected) == 0 && status == cases[i].status;
+        if (cases[i].same_unfrozen) ok = ok && strcmp(trace, unfrozen[i]) == 0 && status == unfrozen_status[i];
+        CHECK(ok, msg);
+    }
+
+    // Test 4: No per-request heap use once warm
+    printf("\nTest 4: Frozen dispatch allocations\n");
+    {
+        size_t before = arena_thread_heap_allocations();
+        for (int round = 0; round < 200; round++) {
+            for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) dispatch(&app, cases[i].raw);
+        }
+        CHECK(arena_thread_heap_allocations() == before, "no arena blocks malloc'd after warm-up");
+    }
+
+    // Test 5: Registering through the app drops the frozen chains
+    printf("\nTest 5: Thaw\n");
+    app.get(&app, "/late", h_health);
+    CHECK(app.frozen == NULL, "adding a route thaws the app");
+    dispatch(&app, "GET /late HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(trace, "all tail health") == 0, "late route served unfrozen");
+
+    app_thaw(&app);
+    for (int i = 0; i < app.router.layer_count; i++) {
+        free_route_pattern((RoutePattern *)app.router.layers[i].pattern);
+        free((char *)app.router.layers[i].mount_prefix);
+    }
+    free(app.router.layers);
+    route_tree_destroy(app.router.tree);
+    destroy_router(api);
+    destroy_router(v2);
+    close(out_fds[0]);
+    close(out_fds[1]);
+
+    return test_report("Frozen router");
+}
@@ -0,0 +1,62 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+// Shared by the C unit tests: a CHECK that counts failures, and running a
+// raw request through an app with the response read back from a pipe
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/core/app.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { printf("  ok: %s\n", msg); } \
+    else { printf("  FAIL: %s\n", msg); failures++; } \
+} while (0)
+
+// A pipe for responses: handlers write to fds[1], fds[0] reads without blocking
+static inline int test_response_pipe(int fds[2]) {
+    if (pipe(fds) != 0) return -1;
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    return 0;
+}
+
+// Parse `raw` and run it through the app, answering on `fd`
+static inline void test_dispatch(App *app, int fd, const char *raw) {
+    Request req;
+    request_init(&req, fd, raw);
+    app_handle_request(app, req.method, req.path, fd, &req);
+    request_destroy(&req);
+}
+
+// Everything written so far to the other end of a non-blocking `fd`, in
+// `out` (terminated); returns its length
+static inline size_t test_read_response(int fd, char *out, size_t size) {
+    size_t total = 0;
+    ssize_t n;
+    while (total < size - 1 && (n = read(fd, out + total, size - 1 - total)) > 0) total += (size_t)n;
+    out[total] = '\0';
+    return total;
+}
+
+// Status code of a response read by test_read_response, 0 without one
+static inline int test_status(const char *out) {
+    const char *status = out[0] ? strchr(out, ' ') : NULL;
+    return status ? atoi(status + 1) : 0;
+}
+
+// Print the verdict for the `name` tests; main's exit status
+static inline int test_report(const char *name) {
+    if (failures) {
+        printf("\n%s tests FAILED (%d)\n", name, failures);
+        return 1;
+    }
+    printf("\n%s tests PASSED\n", name);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/parsers/http_parser.h"
+#include "../src/http/request.h"
+#include "test_helpers.h"
+
+static int slice_is(const char *data, HttpSlice slice, const char *expected) {
+    return slice.length == strlen(expected) && memcmp(data + slice.offset, expected, slice.length) == 0;
+}
+
+static HttpParseResult parse_all(HttpParser *parser, const char *data) {
+    http_parser_init(parser);
+    return http_parser_execute(parser, data, strlen(data));
+}
+
+int main() {
+    printf("Testing HTTP request parser...\n");
+    HttpParser parser;
+
+    // Test 1: Views into the buffer
+    printf("\nTest 1: Request line and header views\n");
+    const char *simple = "GET /users/42?sort=asc&x=1 HTTP/1.1\r\nHost: example.com\r\nX-Empty:\r\n\r\n";
+    CHECK(parse_all(&parser, simple) == HTTP_PARSE_DONE, "complete head parsed");
+    CHECK(parser.consumed == strlen(simple), "consumed covers the whole head");
+    CHECK(slice_is(simple, parser.method, "GET"), "method view");
+    CHECK(slice_is(simple, parser.path, "/users/42"), "path view stops at '?'");
+    CHECK(slice_is(simple, parser.query, "sort=asc&x=1"), "query view without '?'");
+    CHECK(parser.version_minor == 1, "HTTP/1.1 version");
+    CHECK(parser.header_count == 2, "two headers");
+    CHECK(slice_is(simple, parser.headers[0].value, "example.com"), "header value view");
+    CHECK(parser.headers[1].value.length == 0, "empty header value");
+
+    // Test 2: Resuming one byte at a time
+    printf("\nTest 2: Byte-at-a-time feeding\n");
+    const char *post = "POST /echo HTTP/1.1\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhello";
+    size_t head_len = strlen(post) - 5;
+    HttpParseResult result = HTTP_PARSE_INCOMPLETE;
+    http_parser_init(&parser);
+    for (size_t len = 1; len <= strlen(post) && result == HTTP_PARSE_INCOMPLETE; len++) {
+        result = http_parser_execute(&parser, post, len);
+    }
+    CHECK(result == HTTP_PARSE_DONE, "head completes when fed incrementally");
+    CHECK(parser.consumed == head_len, "consumed stops before the body");
+    CHECK(parser.has_content_length && parser.content_length == 5, "Content-Length extracted");
+    CHECK(!http_parser_keep_alive(&parser), "Connection: close honoured");
+
+    // Test 3: Pipelined bytes are left alone
+    printf("\nTest 3: Pipelined requests\n");
+    const char *two = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n";
+    CHECK(parse_all(&parser, two) == HTTP_PARSE_DONE && parser.consumed == strlen(two) / 2,
+          "consumed reports only the first request");
+
+    // Test 4: Framing headers
+    printf("\nTest 4: Framing and connection semantics\n");
+    CHECK(parse_all(&parser, "POST / HTTP/1.1\r\ntransfer-encoding: gzip, chunked\r\n\r\n") == HTTP_PARSE_DONE &&
+          parser.chunked, "chunked as the final transfer coding");
+    CHECK(parse_all(&parser, "GET / HTTP/1.0\r\n\r\n") == HTTP_PARSE_DONE && !http_parser_keep_alive(&parser),
+          "HTTP/1.0 defaults to close");
+    CHECK(parse_all(&parser, "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n") == HTTP_PARSE_DONE &&
+          http_parser_keep_alive(&parser), "HTTP/1.0 keep-alive opt-in");
+    CHECK(parse_all(&parser, "GET / HTTP/1.1\nHost: x\n\n") == HTTP_PARSE_DONE, "bare LF line endings accepted");
+
+    // Test 5: Malformed heads
+    printf("\nTest 5: Malformed heads\n");
+    CHECK(parse_all(&parser, "POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n") == HTTP_PARSE_ERROR,
+          "conflicting Content-Length rejected");
+    CHECK(parse_all(&parser, "POST / HTTP/1.1\r\nContent-Length: 5x\r\n\r\n") == HTTP_PARSE_ERROR,
+          "non-numeric Content-Length rejected");
+    CHECK(parse_all(&parser, "GET / SPDY/3\r\n\r\n") == HTTP_PARSE_ERROR, "unknown protocol rejected");
+    CHECK(parse_all(&parser, "GET / HTTP/1.1\r\nBad Header: x\r\n\r\n") == HTTP_PARSE_ERROR,
+          "whitespace in header name rejected");
+    CHECK(parse_all(&parser, "GET / HTTP/1.1\r\nHost: x\r\n folded\r\n\r\n") == HTTP_PARSE_ERROR,
+          "obsolete line folding rejected");
+
+    // Test 6: Request built from the parsed head
+    printf("\nTest 6: Request views\n");
+    char long_value[300];
+    char raw[512];
+    memset(long_value, 'v', sizeof(long_value) - 1);
+    long_value[sizeof(long_value) - 1] = '\0';
+    snprintf(raw, sizeof(raw), "GET /q?name=a%%20b HTTP/1.1\r\nCookie: %s\r\n\r\n", long_value);
+
+    Request req;
+    request_init(&req, -1, raw);
+    CHECK(strcmp(req.method, "GET") == 0 && strcmp(req.path, "/q") == 0, "method and path");
+    CHECK(req.get_query(&req, "name") && strcmp(req.get_query(&req, "name"), "a b") == 0, "query decoded");
+    CHECK(req.get_header(&req, "cookie") && strlen(req.get_header(&req, "cookie")) == sizeof(long_value) - 1,
+          "header values over 128 bytes are kept");
+    request_destroy(&req);
+
+    // Test 7: Inline arrays spill into request storage
+    printf("\nTest 7: Request storage\n");
+    static char big[8192];
+    char body[2048];
+    size_t len = (size_t)snprintf(big, sizeof(big), "POST /s?");
+    for (int i = 0; i < 12; i++) {
+        len += (size_t)snprintf(big + len, sizeof(big) - len, "%sq%d=v%%2F%d", i ? "&" : "", i, i);
+    }
+    len += (size_t)snprintf(big + len, sizeof(big) - len, " HTTP/1.1\r\nContent-Length: %zu\r\n", sizeof(body));
+    for (int i = 0; i < 20; i++) {
+        len += (size_t)snprintf(big + len, sizeof(big) - len, "X-Header-%d: value-%d\r\n", i, i);
+    }
+    memset(body, 'b', sizeof(body) - 1);
+    body[sizeof(body) - 1] = '\0';
+    snprintf(big + len, sizeof(big) - len, "\r\n%s", body);
+
+    request_init(&req, -1, big);
+    CHECK(req.header_count == 21 && req.get_header(&req, "x-header-19") &&
+          strcmp(req.get_header(&req, "x-header-19"), "value-19") == 0, "headers past the inline slots kept");
+    CHECK(req.query_count == 12 && strcmp(req.get_query(&req, "q11"), "v/11") == 0, "query params past the inline slots kept");
+    CHECK(req.body_len == sizeof(body) - 1 && strcmp(req.body, body) == 0, "body copied into request storage");
+    CHECK(req.form_data == NULL, "form data not allocated until used");
+    CHECK(sizeof(Request) < 2048, "Request struct stays under 2KB");
+    request_destroy(&req);
+
+    return test_report("HTTP parser");
+}
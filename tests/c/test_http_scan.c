@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/parsers/http_scan.h"
+#include "../src/parsers/http_parser.h"
+#include "test_helpers.h"
+
+static size_t reference_scan(const char *data, size_t pos, size_t len, const char *set) {
+    while (pos < len && !strchr(set, data[pos])) pos++;
+    return pos;
+}
+
+// Every start offset and length up to 100 bytes with the match moved
+// through every position, so block boundaries and tails are all covered
+static int kernel_matches_reference(void) {
+    char buffer[100];
+
+    for (size_t hit = 0; hit <= sizeof(buffer); hit++) {
+        memset(buffer, 'x', sizeof(buffer));
+        if (hit < sizeof(buffer)) buffer[hit] = (hit % 3 == 0) ? '\r' : (hit % 3 == 1) ? '\n' : ':';
+
+        for (size_t pos = 0; pos <= sizeof(buffer); pos++) {
+            for (size_t len = pos; len <= sizeof(buffer); len++) {
+                if (http_scan_line_end(buffer, pos, len) != reference_scan(buffer, pos, len, "\r\n")) return 0;
+                if (http_scan_name_end(buffer, pos, len) != reference_scan(buffer, pos, len, ":\r\n")) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int main() {
+    printf("Testing HTTP byte scanners...\n");
+    HttpScanKernel kernels[] = { HTTP_SCAN_SCALAR, HTTP_SCAN_SSE42, HTTP_SCAN_AVX2 };
+    HttpScanKernel detected = http_scan_kernel();
+    char msg[128];
+
+    printf("CPU kernel: %s\n", http_scan_kernel_name(detected));
+
+    // Test 1: Auto-selected kernel is usable
+    printf("\nTest 1: Kernel selection\n");
+    CHECK(http_scan_set_kernel(HTTP_SCAN_SCALAR) == 0, "scalar kernel always available");
+    CHECK(http_scan_set_kernel(detected) == 0, "detected kernel can be selected");
+
+    // Test 2: Every supported kernel agrees with a byte-at-a-time scan
+    printf("\nTest 2: Kernels against the reference scan\n");
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        if (http_scan_set_kernel(kernels[i]) < 0) {
+            printf("  skip: %s not supported by this CPU\n", http_scan_kernel_name(kernels[i]));
+            continue;
+        }
+        snprintf(msg, sizeof(msg), "%s kernel matches the reference", http_scan_kernel_name(kernels[i]));
+        CHECK(kernel_matches_reference(), msg);
+    }
+
+    // Test 3: Parsing a head with long header values on each kernel
+    printf("\nTest 3: Parser on each kernel\n");
+    char cookie[2048];
+    char raw[4096];
+    memset(cookie, 'c', sizeof(cookie) - 1);
+    cookie[sizeof(cookie) - 1] = '\0';
+    int head_len = snprintf(raw, sizeof(raw),
+                            "GET / HTTP/1.1\r\nHost: example.com\r\nCookie: %s\r\nAuthorization: Bearer %.300s\r\n\r\n",
+                            cookie, cookie);
+
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        if (http_scan_set_kernel(kernels[i]) < 0) continue;
+        HttpParser parser;
+        http_parser_init(&parser);
+        int ok = http_parser_execute(&parser, raw, (size_t)head_len) == HTTP_PARSE_DONE &&
+                 parser.consumed == (size_t)head_len && parser.header_count == 3 &&
+                 parser.headers[1].value.length == sizeof(cookie) - 1 &&
+                 parser.headers[2].value.length == 7 + 300;
+        snprintf(msg, sizeof(msg), "%s kernel parses long header values", http_scan_kernel_name(kernels[i]));
+        CHECK(ok, msg);
+    }
+
+    return test_report("HTTP scanner");
+}
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/core/app.h"
+#include "../src/core/frozen_router.h"
+#include "test_helpers.h"
+
+#define DEEP_CHAIN 200
+// Handlers' frames differ in size; nesting them would take at least a
+// frame per handler, far more than this
+#define FLAT_SPREAD 256
+
+// Frame addresses seen by the handlers of one request
+static int calls = 0;
+static uintptr_t lowest, highest;
+
+static void note_frame(void) {
+    uintptr_t frame = (uintptr_t)__builtin_frame_address(0);
+    if (calls == 0 || frame < lowest) lowest = frame;
+    if (calls == 0 || frame > highest) highest = frame;
+    calls++;
+}
+
+static void mw_deep(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd;
+    note_frame();
+    next(context);
+}
+
+static void h_done(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    Response *res = (Response *)ctx->user_context;
+    note_frame();
+    res->send(res, "done");
+}
+
+// Pause/resume: the trace records what ran, in order
+static char trace[128];
+static void *paused = NULL;
+
+static void note(const char *tag) {
+    size_t used = strlen(trace);
+    snprintf(trace + used, sizeof(trace) - used, "%s%s", used ? " " : "", tag);
+}
+
+static void mw_before_after(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd;
+    note("a");
+    next(context);
+    note("a-after");
+}
+
+static void mw_pause(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    note("pause");
+    if (next_pause(context)) paused = context;
+}
+
+static void h_resumed(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    NextContext *ctx = (NextContext *)context;
+    Response *res = (Response *)ctx->user_context;
+    note(ctx->req->get_param(ctx->req, "id"));
+    res->send(res, "resumed");
+}
+
+static int out_fds[2];
+
+static int read_status(void) {
+    char out[512];
+    test_read_response(out_fds[0], out, sizeof(out));
+    return test_status(out);
+}
+
+// Dispatch one request through the deep chain; returns the frame spread
+static uintptr_t dispatch_deep(App *app, const char *raw, int *status) {
+    calls = 0;
+    test_dispatch(app, out_fds[1], raw);
+    *status = read_status();
+    return highest - lowest;
+}
+
+static void run_pause(App *app, const char *label) {
+    char msg[256];
+    Request req;
+    trace[0] = '\0';
+    paused = NULL;
+    request_init(&req, out_fds[1], "GET /jobs/7 HTTP/1.1\r\n\r\n");
+
+    int completed = app_handle_request(app, req.method, req.path, out_fds[1], &req);
+    snprintf(msg, sizeof(msg), "%s: chain pauses, nothing sent (%s)", label, trace);
+    CHECK(!completed && paused && req.paused_chain == paused && strcmp(trace, "a a-after pause") == 0 &&
+          read_status() == 0, msg);
+
+    // Later, from outside any handler
+    next_handler(paused);
+    snprintf(msg, sizeof(msg), "%s: resumed chain finishes (%s)", label, trace);
+    CHECK(strcmp(trace, "a a-after pause 7") == 0 && read_status() == 200 && req.paused_chain == NULL &&
+          req.arena.blocks == NULL && req.arena.initial_used == 0, msg);
+    request_destroy(&req);
+
+    // Completing instead skips the rest of the chain but still cleans up
+    trace[0] = '\0';
+    paused = NULL;
+    request_init(&req, out_fds[1], "GET /jobs/8 HTTP/1.1\r\n\r\n");
+    completed = app_handle_request(app, req.method, req.path, out_fds[1], &req);
+    if (!completed && paused) next_complete(paused);
+    snprintf(msg, sizeof(msg), "%s: next_complete ends a paused chain (%s)", label, trace);
+    CHECK(!completed && strcmp(trace, "a a-after pause") == 0 && read_status() == 0 &&
+          req.paused_chain == NULL && req.arena.initial_used == 0, msg);
+    request_destroy(&req);
+}
+
+static void destroy_app_routes(App *app) {
+    app_thaw(app);
+    for (int i = 0; i < app->router.layer_count; i++) {
+        free_route_pattern((RoutePattern *)app->router.layers[i].pattern);
+        free((char *)app->router.layers[i].mount_prefix);
+    }
+    free(app->router.layers);
+    route_tree_destroy(app->router.tree);
+}
+
+int main() {
+    printf("Testing the middleware trampoline...\n");
+    if (test_response_pipe(out_fds) != 0) return 1;
+
+    App app = create_app();
+    Router *inner = create_router();
+    for (int i = 0; i < DEEP_CHAIN; i++) app.use(&app, mw_deep);
+    app.get(&app, "/deep", h_done);
+    for (int i = 0; i < DEEP_CHAIN; i++) router_use(inner, "/", mw_deep);
+    router_get(inner, "/end", h_done);
+    app.mount(&app, "/inner", inner);
+
+    // Test 1: Stack depth does not grow with the chain
+    printf("\nTest 1: Deep chains\n");
+    {
+        int status = 0;
+        uintptr_t spread = dispatch_deep(&app, "GET /deep HTTP/1.1\r\n\r\n", &status);
+        CHECK(calls == DEEP_CHAIN + 1 && status == 200, "unfrozen: every handler runs");
+        CHECK(spread < FLAT_SPREAD, "unfrozen: every handler runs at the same stack depth");
+
+        spread = dispatch_deep(&app, "GET /inner/end HTTP/1.1\r\n\r\n", &status);
+        CHECK(calls == 2 * DEEP_CHAIN + 1 && status == 200 && spread < FLAT_SPREAD,
+              "unfrozen: a mounted router continues the same loop");
+
+        app_freeze(&app);
+        spread = dispatch_deep(&app, "GET /deep HTTP/1.1\r\n\r\n", &status);
+        CHECK(calls == DEEP_CHAIN + 1 && status == 200 && spread < FLAT_SPREAD, "frozen: flat stack");
+        spread = dispatch_deep(&app, "GET /inner/end HTTP/1.1\r\n\r\n", &status);
+        CHECK(calls == 2 * DEEP_CHAIN + 1 && status == 200 && spread < FLAT_SPREAD, "frozen: flat stack through the mount");
+        spread = dispatch_deep(&app, "GET /nowhere HTTP/1.1\r\n\r\n", &status);
+        CHECK(calls == DEEP_CHAIN && status == 404, "unmatched request still gets its 404 at the end");
+    }
+    destroy_app_routes(&app);
+    destroy_router(inner);
+
+    // Test 2: Pausing and resuming a chain
+    printf("\nTest 2: Pause and resume\n");
+    app = create_app();
+    app.use(&app, mw_before_after);
+    app.use(&app, mw_pause);
+    app.get(&app, "/jobs/:id", h_resumed);
+    run_pause(&app, "unfrozen");
+    app_freeze(&app);
+    run_pause(&app, "frozen");
+    destroy_app_routes(&app);
+
+    close(out_fds[0]);
+    close(out_fds[1]);
+
+    return test_report("Trampoline");
+}
@@ -9,14 +9,9 @@ int main() {
     // Test 1: JSON error allocation leak
     {
         printf("\nTest 1: JSON parsing with wrong content type\n");
-        Request req = {0};
-        req.client_fd = -1;
-        strcpy(req.body, "{\"key\": \"value\"}");
-        
         // Set wrong content type to trigger error allocation
-        req.header_count = 1;
-        strcpy(req.headers[0].key, "Content-Type");
-        strcpy(req.headers[0].value, "text/plain");
+        Request req;
+        request_init(&req, -1, "POST / HTTP/1.1\r\nContent-Type: text/plain\r\n\r\n{\"key\": \"value\"}");
         
         // This should allocate error message with strdup
         JsonValue *result = request_get_json(&req);
@@ -25,28 +20,25 @@ int main() {
         
         // Cleanup - this should free the strdup'd error message
         request_free_json(&req);
+        request_destroy(&req);
         printf("JSON cleanup completed\n");
     }
     
     // Test 2: Form data error allocation leak
     {
         printf("\nTest 2: Form parsing with wrong content type\n");
-        Request req = {0};
-        req.client_fd = -1;
-        strcpy(req.body, "key=value&key2=value2");
-        
         // Set wrong content type to trigger error allocation
-        req.header_count = 1;
-        strcpy(req.headers[0].key, "Content-Type");
-        strcpy(req.headers[0].value, "text/plain");
+        Request req;
+        request_init(&req, -1, "POST / HTTP/1.1\r\nContent-Type: text/plain\r\n\r\nkey=value&key2=value2");
         
         // This should allocate error message with strdup
         FormData *result = request_get_form(&req);
         printf("Form result: %s\n", result ? "success" : "failed (expected)");
-        printf("Error message: %s\n", req.form_data.error_message ? req.form_data.error_message : "none");
+        printf("Error message: %s\n", req.form_data && req.form_data->error_message ? req.form_data->error_message : "none");
         
         // Cleanup - this should free the strdup'd error message
         request_free_form(&req);
+        request_destroy(&req);
         printf("Form cleanup completed\n");
     }
     
@@ -55,14 +47,9 @@ int main() {
         printf("\nTest 3: Multiple requests with proper cleanup (simulating fixed app.c)\n");
         for (int i = 0; i < 3; i++) {
             Request *req = malloc(sizeof(Request));
-            memset(req, 0, sizeof(Request));
-            req->client_fd = -1;
-            strcpy(req->body, "{\"test\": true}");
             
             // Wrong content type to trigger JSON error
-            req->header_count = 1;
-            strcpy(req->headers[0].key, "Content-Type");
-            strcpy(req->headers[0].value, "text/plain");
+            request_init(req, -1, "POST / HTTP/1.1\r\nContent-Type: text/plain\r\n\r\n{\"test\": true}");
             
             JsonValue *json = request_get_json(req);
             FormData *form = request_get_form(req);
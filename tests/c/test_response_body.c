@@ -0,0 +1,141 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "../src/http/response.h"
+#include "../src/http/connection.h"
+#include "test_helpers.h"
+
+// Response bodies: binary bytes go out whole with an exact Content-Length,
+// owned buffers are released, and the C-string helpers still frame bodies
+
+static int released = 0;
+
+static void count_release(void *data) {
+    released++;
+    free(data);
+}
+
+// Read what the response wrote and split it at the end of the head
+static size_t read_response(int fd, char *buffer, size_t size, char **body) {
+    size_t total = test_read_response(fd, buffer, size);
+    char *end = memmem(buffer, total, "\r\n\r\n", 4);
+    *body = end ? end + 4 : buffer + total;
+    return total;
+}
+
+int main() {
+    printf("Testing response bodies...\n");
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    static char buffer[65536];
+    char *body;
+    size_t n;
+
+    // Test 1: Bytes with embedded NULs
+    printf("\nTest 1: Binary body\n");
+    const unsigned char png[] = { 0x89, 'P', 'N', 'G', 0x00, 0x0d, 0x0a, 0x00, 0xff, 0x00 };
+    Response *res = create_response(fds[0]);
+    res->set_header(res, "Content-Type", "image/png");
+    res->send_bytes(res, png, sizeof(png));
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(strstr(buffer, "Content-Length: 10\r\n") != NULL, "Content-Length counts past the NULs");
+    CHECK(strstr(buffer, "Content-Type: image/png\r\n") != NULL, "content type kept");
+    CHECK(body + sizeof(png) == buffer + n && memcmp(body, png, sizeof(png)) == 0, "every byte sent");
+    destroy_response(res);
+
+    // Test 2: Owned and borrowed buffers
+    printf("\nTest 2: Buffers\n");
+    size_t blob_len = 40000;
+    char *blob = malloc(blob_len);
+    for (size_t i = 0; i < blob_len; i++) blob[i] = (char)(i % 7 == 0 ? 0 : i);
+    char *copy = malloc(blob_len);
+    memcpy(copy, blob, blob_len);
+    res = create_response(fds[0]);
+    res->send_buffer(res, blob, blob_len, count_release);
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(released == 1, "owned buffer released once sent");
+    CHECK(strstr(buffer, "Content-Length: 40000\r\n") && body + blob_len == buffer + n &&
+          memcmp(body, copy, blob_len) == 0, "owned buffer sent whole");
+    destroy_response(res);
+
+    res = create_response(fds[0]);
+    res->send_buffer(res, copy, 3, NULL);
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(released == 1 && body + 3 == buffer + n && memcmp(body, copy, 3) == 0, "borrowed buffer left alone");
+    destroy_response(res);
+    free(copy);
+
+    // Test 3: Queued on the active connection
+    printf("\nTest 3: Event loop connection\n");
+    Connection *conn = connection_create(fds[0]);
+    connection_set_active(conn);
+    res = create_response(fds[0]);
+    res->send_bytes(res, png, sizeof(png));
+    connection_set_active(NULL);
+    CHECK(connection_has_pending_output(conn) && connection_flush(conn) == CONN_IO_OK, "bytes queued, then flushed");
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(strstr(buffer, "\r\nConnection: ") && body + sizeof(png) == buffer + n &&
+          memcmp(body, png, sizeof(png)) == 0, "binary body intact through the queue");
+    destroy_response(res);
+
+    // The handler's Connection header cannot keep open a closing connection
+    conn->keep_alive = 0;
+    connection_set_active(conn);
+    res = create_response(fds[0]);
+    res->set_header(res, "Connection", "keep-alive");
+    res->send(res, "bye");
+    connection_set_active(NULL);
+    connection_flush(conn);
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(strstr(buffer, "\r\nConnection: close\r\n") && !strstr(buffer, "keep-alive"),
+          "closing connection answered with Connection: close");
+    destroy_response(res);
+
+    conn->keep_alive = 1;
+    connection_set_active(conn);
+    res = create_response(fds[0]);
+    res->set_header(res, "Connection", "Close");
+    res->send(res, "bye");
+    connection_set_active(NULL);
+    connection_flush(conn);
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    char *first = strstr(buffer, "\r\nConnection: ");
+    CHECK(!conn->keep_alive && first && !strstr(first + 2, "\r\nConnection: "),
+          "handler's close honoured, header sent once");
+    destroy_response(res);
+    connection_destroy(conn);
+
+    // Test 4: The string helpers
+    printf("\nTest 4: String helpers\n");
+    res = create_response(fds[0]);
+    res->json(res, "{\"ok\":true}");
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(strstr(buffer, "Content-Type: application/json\r\n") && strstr(buffer, "Content-Length: 11\r\n") &&
+          body + 11 == buffer + n, "json framed");
+    destroy_response(res);
+
+    res = create_response(fds[0]);
+    res->send_status(res, 404);
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(strncmp(buffer, "HTTP/1.1 404 Not Found\r\n", 24) == 0 && body + 9 == buffer + n &&
+          memcmp(body, "Not Found", 9) == 0, "send_status framed");
+    destroy_response(res);
+
+    res = create_response(fds[0]);
+    res->send(res, "");
+    n = read_response(fds[1], buffer, sizeof(buffer), &body);
+    CHECK(strstr(buffer, "Content-Length: 0\r\n") && body == buffer + n, "empty body");
+    destroy_response(res);
+
+    close(fds[0]);
+    close(fds[1]);
+
+    return test_report("Response body");
+}
@@ -0,0 +1,189 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../src/core/app.h"
+#include "../src/core/frozen_router.h"
+#include "test_helpers.h"
+
+// The handler that ran and the parameter it read
+static __thread char seen[64];
+
+static void note(void *context, const char *tag, const char *param) {
+    NextContext *ctx = (NextContext *)context;
+    const char *value = param ? ctx->req->get_param(ctx->req, param) : NULL;
+    snprintf(seen, sizeof(seen), "%s%s%s", tag, value ? ":" : "", value ? value : "");
+}
+
+static void h_user(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    note(context, "user", "id");
+}
+
+static void h_me(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    note(context, "me", NULL);
+}
+
+static void h_file(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    note(context, "file", "name");
+}
+
+static void h_job(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    note(context, "job", NULL);
+}
+
+static int out_fds[2];
+
+// Dispatch one request; returns the status line code written, if any
+static int dispatch(App *app, int fd, const char *raw) {
+    char out[512];
+    seen[0] = '\0';
+    test_dispatch(app, fd, raw);
+    if (fd != out_fds[1]) return 0;
+
+    test_read_response(out_fds[0], out, sizeof(out));
+    int code = test_status(out);
+    if (code == 405 && !strstr(out, "Allow: POST\r\n")) code = -405;
+    return code;
+}
+
+static int stats_are(App *app, unsigned long hits, unsigned long misses) {
+    RouteCacheStats stats;
+    app_route_cache_stats(app, &stats);
+    if (stats.hits != hits || stats.misses != misses) {
+        printf("  (hits=%lu misses=%lu)\n", stats.hits, stats.misses);
+    }
+    return stats.hits == hits && stats.misses == misses;
+}
+
+#define THREADS 4
+#define THREAD_REQUESTS 100
+
+// Threads stay alive between the barriers so their shards can be counted
+static pthread_barrier_t dispatched, counted;
+
+static void *thread_main(void *arg) {
+    App *app = (App *)arg;
+    int *ok = malloc(sizeof(int));
+    *ok = 1;
+    for (int i = 0; i < THREAD_REQUESTS; i++) {
+        dispatch(app, -1, "GET /users/77 HTTP/1.1\r\n\r\n");
+        *ok = *ok && strcmp(seen, "user:77") == 0;
+    }
+    pthread_barrier_wait(&dispatched);
+    pthread_barrier_wait(&counted);
+    return ok;
+}
+
+int main() {
+    printf("Testing the route cache...\n");
+    if (test_response_pipe(out_fds) != 0) return 1;
+
+    App app = create_app();
+    app.get(&app, "/users/:id:number", h_user);
+    app.get(&app, "/files/:name", h_file);
+    app.post(&app, "/jobs", h_job);
+    router_add_layer(&app.router, "PURGE", "/files/:name", h_file);
+    app_set_route_cache(&app, 4);
+    app_freeze(&app);
+
+    // Test 1: Hits reproduce the route and parameters of the miss
+    printf("\nTest 1: Hits and misses\n");
+    CHECK(stats_are(&app, 0, 0), "a fresh freeze starts at zero");
+    dispatch(&app, out_fds[1], "GET /users/5 HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(seen, "user:5") == 0 && stats_are(&app, 0, 1), "first request misses");
+    dispatch(&app, out_fds[1], "GET /users/5?x=1 HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(seen, "user:5") == 0 && stats_are(&app, 1, 1), "repeat hits, with its parameter");
+    dispatch(&app, out_fds[1], "HEAD /users/5 HTTP/1.1\r\n\r\n");
+    CHECK(stats_are(&app, 1, 2), "another method is another entry");
+    int first = dispatch(&app, out_fds[1], "DELETE /jobs HTTP/1.1\r\n\r\n");
+    int second = dispatch(&app, out_fds[1], "DELETE /jobs HTTP/1.1\r\n\r\n");
+    CHECK(first == 405 && second == 405 && stats_are(&app, 2, 3), "405 and its Allow header cached");
+
+    // Test 2: Least recently used entries go first
+    printf("\nTest 2: Eviction\n");
+    dispatch(&app, out_fds[1], "GET /users/5 HTTP/1.1\r\n\r\n");
+    dispatch(&app, out_fds[1], "GET /files/a HTTP/1.1\r\n\r\n");
+    dispatch(&app, out_fds[1], "GET /files/b HTTP/1.1\r\n\r\n");
+    CHECK(stats_are(&app, 3, 5), "cache full: users/5, jobs, files/a, files/b");
+    dispatch(&app, out_fds[1], "GET /users/5 HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(seen, "user:5") == 0 && stats_are(&app, 4, 5), "recently used entry kept");
+    dispatch(&app, out_fds[1], "HEAD /users/5 HTTP/1.1\r\n\r\n");
+    CHECK(stats_are(&app, 4, 6), "entry evicted by later ones misses again");
+    dispatch(&app, out_fds[1], "GET /files/b HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(seen, "file:b") == 0 && stats_are(&app, 5, 6), "parameters survive eviction of neighbours");
+
+    // Test 3: Lookups that bypass the cache
+    printf("\nTest 3: Uncached lookups\n");
+    dispatch(&app, out_fds[1], "PURGE /files/a HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(seen, "file:a") == 0 && stats_are(&app, 5, 6), "extension methods are not cached");
+    {
+        char raw[512];
+        char name[ROUTE_CACHE_MAX_PATH + 1];
+        memset(name, 'n', sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        snprintf(raw, sizeof(raw), "GET /files/%s HTTP/1.1\r\n\r\n", name);
+        dispatch(&app, out_fds[1], raw);
+        dispatch(&app, out_fds[1], raw);
+        CHECK(strncmp(seen, "file:nnn", 8) == 0 && stats_are(&app, 5, 8), "long paths miss every time");
+    }
+
+    // Test 4: Registering a route drops the cache with the frozen router
+    printf("\nTest 4: Invalidation\n");
+    CHECK(dispatch(&app, out_fds[1], "GET /users/me HTTP/1.1\r\n\r\n") == 404 &&
+          dispatch(&app, out_fds[1], "GET /users/me HTTP/1.1\r\n\r\n") == 404, "404 cached");
+    app.get(&app, "/users/me", h_me);
+    CHECK(stats_are(&app, 0, 0), "thawed app reports nothing");
+    app_freeze(&app);
+    dispatch(&app, out_fds[1], "GET /users/me HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(seen, "me") == 0 && stats_are(&app, 0, 1), "new freeze starts over and sees the new route");
+
+    // Test 5: One shard per thread, summed in the stats
+    printf("\nTest 5: Threads\n");
+    {
+        pthread_t threads[THREADS];
+        int ok = 1;
+        pthread_barrier_init(&dispatched, NULL, THREADS + 1);
+        pthread_barrier_init(&counted, NULL, THREADS + 1);
+        for (int i = 0; i < THREADS; i++) pthread_create(&threads[i], NULL, thread_main, &app);
+        pthread_barrier_wait(&dispatched);
+        CHECK(stats_are(&app, THREADS * (THREAD_REQUESTS - 1), 1 + THREADS), "each thread misses once");
+        pthread_barrier_wait(&counted);
+        for (int i = 0; i < THREADS; i++) {
+            void *result = NULL;
+            pthread_join(threads[i], &result);
+            ok = ok && result && *(int *)result;
+            free(result);
+        }
+        pthread_barrier_destroy(&dispatched);
+        pthread_barrier_destroy(&counted);
+        CHECK(ok, "every thread saw its parameter");
+        // The threads have exited, taking their shards with them
+        CHECK(stats_are(&app, 0, 1), "exited threads' shards are released");
+    }
+
+    // Test 6: Caching off
+    printf("\nTest 6: Disabled\n");
+    app_set_route_cache(&app, 0);
+    app_freeze(&app);
+    dispatch(&app, out_fds[1], "GET /users/5 HTTP/1.1\r\n\r\n");
+    dispatch(&app, out_fds[1], "GET /users/5 HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(seen, "user:5") == 0 && stats_are(&app, 0, 0), "no counting without a cache");
+
+    app_thaw(&app);
+    for (int i = 0; i < app.router.layer_count; i++) {
+        free_route_pattern((RoutePattern *)app.router.layers[i].pattern);
+    }
+    free(app.router.layers);
+    route_tree_destroy(app.router.tree);
+    close(out_fds[0]);
+    close(out_fds[1]);
+
+    return test_report("Route cache");
+}
@@ -0,0 +1,189 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/core/app.h"
+#include "../src/core/route_snapshot.h"
+#include "test_helpers.h"
+
+// Route snapshots: patterns saved to a file and mapped back must match
+// exactly like freshly compiled ones, and damaged files must be refused
+
+static void h_ok(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next; (void)context;
+}
+
+static int even_only(const char *value, void *context, ValidationError *error) {
+    (void)context; (void)error;
+    return strlen(value) % 2 == 0;
+}
+
+static const char *patterns[] = {
+    "/", "/users", "/users/:id:number(min=1,max=1000)", "/posts/:slug:slug(regex=^[a-z]+-[0-9]+$)",
+    "/lang/:code:string(enum=en|fr|de)/docs", "/range/:n:number(range=5-10)", "/pages/:page?", "/files/*",
+    "/broken/:v:string(regex=[a-)"
+};
+
+static const char *paths[] = {
+    "/", "/users", "/users/42", "/users/0", "/users/1001", "/users/abc", "/posts/hello-42", "/posts/Hello-42",
+    "/posts/hello", "/lang/fr/docs", "/lang/es/docs", "/range/7", "/range/11", "/pages", "/pages/3",
+    "/files/a/b.txt", "/broken/x", "/api/items/9", "/api/items/x", "/nothing"
+};
+
+#define PATTERN_COUNT (int)(sizeof(patterns) / sizeof(patterns[0]))
+#define PATH_COUNT (int)(sizeof(paths) / sizeof(paths[0]))
+
+// The same routes on a fresh router, mounting `child` with its own
+static Router *build_router(RouteSnapshot *snapshot, Router **child) {
+    Router *router = create_router();
+    *child = create_router();
+    router_set_snapshot(router, snapshot);
+    router_set_snapshot(*child, snapshot);
+    for (int i = 0; i < PATTERN_COUNT; i++) router_get(router, patterns[i], h_ok);
+    router_post(router, "/users", h_ok);
+    router_get(*child, "/api/items/:id:number(max=99)", h_ok);
+    router_mount(router, "/", *child);
+    // Custom validators are code, so this one is never snapshotted
+    router_get(router, "/custom/:v", h_ok);
+    RoutePattern *custom = router->layers[router->layer_count - 1].pattern;
+    add_parameter_constraint(custom->segments[1].param, create_custom_constraint(even_only, NULL, NULL));
+    return router;
+}
+
+// Every layer gives the same verdict and parameters on both routers
+static int same_matches(Router *a, Router *b) {
+    int same = a->layer_count == b->layer_count;
+    for (int p = 0; p < PATH_COUNT && same; p++) {
+        for (int i = 0; i < a->layer_count && same; i++) {
+            ParamSlice sa[8], sb[8];
+            int na = 0, nb = 0;
+            if (a->layers[i].type == LAYER_ROUTER) continue;
+            int ma = layer_match_path(&a->layers[i], paths[p], sa, 8, &na, NULL);
+            int mb = layer_match_path(&b->layers[i], paths[p], sb, 8, &nb, NULL);
+            same = ma == mb && na == nb;
+            for (int s = 0; s < na && same; s++) {
+                same = strcmp(sa[s].name, sb[s].name) == 0 && sa[s].length == sb[s].length &&
+                       strncmp(sa[s].value, sb[s].value, sa[s].length) == 0;
+            }
+            if (!same) printf("  (%s: layer %d differs)\n", paths[p], i);
+        }
+    }
+    return same;
+}
+
+static int write_bytes(const char *path, const char *data, size_t size) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    ssize_t n = write(fd, data, size);
+    close(fd);
+    return n == (ssize_t)size ? 0 : -1;
+}
+
+static char *read_bytes(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(*size);
+    if (data && fread(data, 1, *size, f) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+int main() {
+    printf("Testing route snapshots...\n");
+    char file[64], damaged[80];
+    snprintf(file, sizeof(file), "/tmp/test_route_snapshot.%ld", (long)getpid());
+    snprintf(damaged, sizeof(damaged), "%s.damaged", file);
+
+    // Test 1: Saving
+    printf("\nTest 1: Save\n");
+    Router *child;
+    Router *compiled = build_router(NULL, &child);
+    Router *compiled_child = child;
+    int saved = route_snapshot_save(compiled, file);
+    CHECK(saved == PATTERN_COUNT + 1, "one pattern per path, custom validator left out");
+
+    // Test 2: Loading gives patterns matching like compiled ones
+    printf("\nTest 2: Load\n");
+    RouteSnapshot *snapshot = route_snapshot_open(file);
+    CHECK(snapshot && route_snapshot_count(snapshot) == saved, "snapshot opened");
+    RoutePattern *users = route_snapshot_find(snapshot, "/users/:id:number(min=1,max=1000)");
+    CHECK(users && users->in_snapshot && users->segment_count == 2 && users->segments[1].param->type == PARAM_NUMBER &&
+          users->segments[1].param->constraints->next->constraint.range.max_value == 1000,
+          "pattern found with its constraints");
+    CHECK(!route_snapshot_find(snapshot, "/users/:id") && !route_snapshot_find(snapshot, "/custom/:v"),
+          "unknown patterns not found");
+
+    Router *mapped = build_router(snapshot, &child);
+    CHECK(mapped->layers[1].pattern == route_snapshot_find(snapshot, "/users") &&
+          mapped->layers[PATTERN_COUNT].pattern == mapped->layers[1].pattern,
+          "routes take the snapshot's pattern, shared across methods");
+    CHECK(!((RoutePattern *)mapped->layers[mapped->layer_count - 1].pattern)->in_snapshot,
+          "pattern missing from the snapshot compiled");
+    RouteConstraint *regex = route_snapshot_find(snapshot, patterns[3])->segments[1].param->constraints;
+    CHECK(regex->regex_deferred && !regex->compiled_regex, "regex not compiled at load");
+    CHECK(same_matches(compiled, mapped), "same matches and parameters as compiled patterns");
+    CHECK(regex->compiled_regex != NULL, "regex compiled on first use");
+    RouteConstraint *broken = route_snapshot_find(snapshot, "/broken/:v:string(regex=[a-)")->segments[1].param->constraints;
+    CHECK(!broken->regex_deferred && !broken->compiled_regex, "invalid regex stays invalid");
+
+    // Test 3: Damaged or foreign files are refused
+    printf("\nTest 3: Validation\n");
+    size_t size = 0;
+    char *bytes = read_bytes(file, &size);
+    CHECK(bytes && size > 256, "snapshot read back");
+    if (bytes) {
+        bytes[size / 2] ^= 0x20;
+        write_bytes(damaged, bytes, size);
+        CHECK(route_snapshot_open(damaged) == NULL, "flipped byte fails the content hash");
+        bytes[size / 2] ^= 0x20;
+        write_bytes(damaged, bytes, size - 8);
+        CHECK(route_snapshot_open(damaged) == NULL, "truncated file refused");
+        bytes[0] = 'X';
+        write_bytes(damaged, bytes, size);
+        CHECK(route_snapshot_open(damaged) == NULL, "bad magic refused");
+        free(bytes);
+    }
+    CHECK(route_snapshot_open("/nonexistent/routes.snapshot") == NULL, "missing file gives no snapshot");
+    unlink(damaged);
+
+    // Test 4: Through the app
+    printf("\nTest 4: App\n");
+    App app = create_app();
+    CHECK(app_load_route_snapshot(&app, "/nonexistent/routes.snapshot") == -1, "no snapshot to load");
+    CHECK(app_load_route_snapshot(&app, file) == 0, "snapshot loaded");
+    app.get(&app, "/users/:id:number(min=1,max=1000)", h_ok);
+    CHECK(app.router.layers[app.router.layer_count - 1].pattern ==
+          route_snapshot_find(app.router.snapshot, "/users/:id:number(min=1,max=1000)"), "app routes use the snapshot");
+    Router *draft = app_draft_router(&app);
+    router_get(draft, "/files/*", h_ok);
+    CHECK(((RoutePattern *)draft->layers[1].pattern)->in_snapshot, "drafts use the app's snapshot");
+    destroy_router(draft);
+    int resaved = app_save_route_snapshot(&app, damaged);
+    CHECK(resaved == 2, "app routes saved");
+    unlink(damaged);
+
+    app_thaw(&app);
+    for (int i = 0; i < app.router.layer_count; i++) {
+        free_route_pattern((RoutePattern *)app.router.layers[i].pattern);
+    }
+    free(app.router.layers);
+    route_tree_destroy(app.router.tree);
+    destroy_router(mapped);
+    destroy_router(child);
+    destroy_router(compiled);
+    destroy_router(compiled_child);
+    RouteSnapshot *app_snapshot = app.router.snapshot;
+    route_snapshot_close(app_snapshot);
+    route_snapshot_close(snapshot);
+    unlink(file);
+
+    return test_report("Route snapshot");
+}
@@ -0,0 +1,185 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/core/app.h"
+#include "../src/core/route_table.h"
+#include "test_helpers.h"
+
+// A table generated by routegen from test_route_table.routes must take
+// every request exactly as the same routes registered on a router do:
+// same handler, same parameters, same 404/405.
+
+ROUTE_TABLE_DECLARE(test_routes);
+
+// The handler that ran and the parameters it saw
+static char seen[128];
+
+static void note(void *context, const char *tag) {
+    Request *req = ((NextContext *)context)->req;
+    size_t used = (size_t)snprintf(seen, sizeof(seen), "%s", tag);
+    for (int i = 0; i < req->param_count && used < sizeof(seen); i++) {
+        used += (size_t)snprintf(seen + used, sizeof(seen) - used, " %s=%s", req->params[i].key,
+                                 req->params[i].value);
+    }
+}
+
+// Handlers named in the manifest
+#define TABLE_HANDLER(fn, tag) \
+    void fn(int client_fd, void (*next)(void *), void *context); \
+    void fn(int client_fd, void (*next)(void *), void *context) { \
+        (void)client_fd; (void)next; \
+        note(context, tag); \
+    }
+
+TABLE_HANDLER(h_root, "root")
+TABLE_HANDLER(h_users, "users")
+TABLE_HANDLER(h_users_create, "users_create")
+TABLE_HANDLER(h_user, "user")
+TABLE_HANDLER(h_me, "me")
+TABLE_HANDLER(h_item, "item")
+TABLE_HANDLER(h_latest, "latest")
+TABLE_HANDLER(h_tag, "tag")
+TABLE_HANDLER(h_files, "files")
+TABLE_HANDLER(h_docs, "docs")
+TABLE_HANDLER(h_session, "session")
+TABLE_HANDLER(h_ping, "ping")
+TABLE_HANDLER(h_after, "after")
+
+static const char *requests[] = {
+    "GET /", "PATCH /", "GET /users", "POST /users", "DELETE /users",
+    "GET /users/me", "POST /users/me", "PUT /users/me", "GET /users/42", "GET /users//42", "POST /users/42",
+    "GET /items/7", "GET /items/latest", "GET /items/x", "PUT /items/7/tags/red", "PUT /items/x/tags/red",
+    "GET /items/7/tags/red", "GET /files", "GET /files/a", "GET /files/a/b/c/d/e", "POST /files/a",
+    "GET /docs/intro", "GET /docs/intro/x/y", "GET /docs/Not_A_Slug/x",
+    "DELETE /sessions/123e4567-e89b-12d3-a456-426614174000", "GET /sessions/123e4567-e89b-12d3-a456-426614174000",
+    "DELETE /sessions/nope", "HEAD /ping", "GET /ping", "GET /nothing", "GET /users/42/extra", "PURGE /users"
+};
+
+static int out_fds[2];
+
+// "<handler and params>|<status and Allow>" for one request
+static const char *dispatch(App *app, const char *request) {
+    static char result[256];
+    char raw[256], out[512];
+    snprintf(raw, sizeof(raw), "%s HTTP/1.1\r\n\r\n", request);
+    seen[0] = '\0';
+    test_dispatch(app, out_fds[1], raw);
+
+    const char *status = "";
+    if (test_read_response(out_fds[0], out, sizeof(out)) > 0) {
+        char *allow = strstr(out, "Allow: ");
+        if (allow) allow[strcspn(allow, "\r")] = '\0';
+        status = strncmp(out, "HTTP/1.1 404", 12) == 0 ? "404" : allow ? allow : "response";
+    }
+    snprintf(result, sizeof(result), "%s|%s", seen, status);
+    return result;
+}
+
+static const char *method_name(unsigned int methods) {
+    static const char *names[HTTP_METHOD_COUNT] = {
+        NULL, "GET", "HEAD", "POST", "PUT", "DELETE", "PATCH", "OPTIONS", "CONNECT", "TRACE"
+    };
+    for (int m = 1; m < HTTP_METHOD_COUNT; m++) {
+        if (methods == HTTP_METHOD_BIT(m)) return names[m];
+    }
+    return NULL;
+}
+
+// Every request, its path under `prefix`, answered the same by both apps
+static int same_answers(App *router_app, App *table_app, const char *prefix) {
+    int same = 1;
+    for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); i++) {
+        char request[160], expected[256];
+        int method_len = (int)strcspn(requests[i], " ");
+        snprintf(request, sizeof(request), "%.*s %s%s", method_len, requests[i], prefix, requests[i] + method_len + 1);
+        snprintf(expected, sizeof(expected), "%s", dispatch(router_app, request));
+        const char *got = dispatch(table_app, request);
+        if (strcmp(expected, got) != 0) {
+            printf("  (%s: router '%s', table '%s')\n", request, expected, got);
+            same = 0;
+        }
+    }
+    return same;
+}
+
+static void free_app(App *app) {
+    app_thaw(app);
+    for (int i = 0; i < app->router.layer_count; i++) {
+        free((char *)app->router.layers[i].mount_prefix);
+        free_route_pattern((RoutePattern *)app->router.layers[i].pattern);
+    }
+    free(app->router.layers);
+    route_tree_destroy(app->router.tree);
+}
+
+int main() {
+    printf("Testing generated route tables...\n");
+    if (test_response_pipe(out_fds) != 0) return 1;
+
+    // The same routes, registered one by one and served from the table
+    App router_app = create_app();
+    for (int i = 0; i < test_routes.route_count; i++) {
+        const RouteTableEntry *route = &test_routes.routes[i];
+        router_add_layer(&router_app.router, method_name(route->methods), route->path, route->handler);
+    }
+    router_app.get(&router_app, "/after", h_after);
+    App table_app = create_app();
+    table_app.use(&table_app, test_routes_handler);
+    table_app.get(&table_app, "/after", h_after);
+
+    // Test 1: The router's answers, as the table must reproduce them
+    printf("\nTest 1: Router baseline\n");
+    CHECK(strcmp(dispatch(&router_app, "GET /users/me"), "user id=me|") == 0, "earlier parameter route wins");
+    CHECK(strcmp(dispatch(&router_app, "POST /users/me"), "me|") == 0, "static route for another method");
+    CHECK(strcmp(dispatch(&router_app, "GET /items/latest"), "latest|") == 0, "typed parameter lets it through");
+    CHECK(strcmp(dispatch(&router_app, "PUT /items/7/tags/red"), "tag id=7 tag=red|") == 0, "two parameters");
+    CHECK(strcmp(dispatch(&router_app, "PUT /users/me"), "|Allow: GET, POST") == 0, "405 lists both routes");
+
+    // Test 2: The table, unfrozen and frozen
+    printf("\nTest 2: Generated table\n");
+    CHECK(test_routes.route_count == 13 && strcmp(test_routes.routes[3].path, "/users/:id") == 0,
+          "routes kept in manifest order");
+    CHECK(same_answers(&router_app, &table_app, ""), "unfrozen: same handler, parameters and status");
+    CHECK(strcmp(dispatch(&table_app, "GET /after"), "after|") == 0, "routes after the table still run");
+    app_freeze(&router_app);
+    app_freeze(&table_app);
+    CHECK(same_answers(&router_app, &table_app, ""), "frozen: same handler, parameters and status");
+    app_set_route_cache(&table_app, 16);
+    app_freeze(&table_app);
+    CHECK(same_answers(&router_app, &table_app, "") && same_answers(&router_app, &table_app, ""),
+          "with the route cache: same answers twice");
+
+    // Test 3: A table in a mounted router sees paths relative to the mount
+    printf("\nTest 3: Mounted table\n");
+    App mounted_router_app = create_app();
+    Router *routes = create_router();
+    for (int i = 0; i < test_routes.route_count; i++) {
+        const RouteTableEntry *route = &test_routes.routes[i];
+        router_add_layer(routes, method_name(route->methods), route->path, route->handler);
+    }
+    mounted_router_app.mount(&mounted_router_app, "/api", routes);
+    App mounted_table_app = create_app();
+    Router *table = create_router();
+    router_add_layer(table, "USE", "/", test_routes_handler);
+    mounted_table_app.mount(&mounted_table_app, "/api", table);
+    CHECK(strcmp(dispatch(&mounted_table_app, "GET /api/users/42"), "user id=42|") == 0, "route found under the mount");
+    CHECK(strcmp(dispatch(&mounted_table_app, "GET /users/42"), "|404") == 0, "not outside it");
+    CHECK(same_answers(&mounted_router_app, &mounted_table_app, "/api"), "unfrozen: same answers as the mounted router");
+    app_freeze(&mounted_router_app);
+    app_freeze(&mounted_table_app);
+    CHECK(same_answers(&mounted_router_app, &mounted_table_app, "/api"), "frozen: same answers as the mounted router");
+
+    free_app(&mounted_router_app);
+    free_app(&mounted_table_app);
+    destroy_router(routes);
+    destroy_router(table);
+    free_app(&router_app);
+    free_app(&table_app);
+    close(out_fds[0]);
+    close(out_fds[1]);
+
+    return test_report("Route table");
+}
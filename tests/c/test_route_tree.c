@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../src/core/router.h"
+#include "test_helpers.h"
+
+static void noop_handler(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next; (void)context;
+}
+
+// Reference: the linear scan every dispatch used to do
+static int linear_match(Router *router, const char *method, const char *path, int *matches) {
+    int count = 0;
+    for (int i = 0; i < router->layer_count; i++) {
+        if (layer_match(&router->layers[i], method, path)) matches[count++] = i;
+    }
+    return count;
+}
+
+// Does a captured slice hold the same parameter as the legacy match?
+static int same_param(const ParamSlice *slice, const RouteParam *param) {
+    return strcmp(slice->name, param->name) == 0 && strlen(param->value) == slice->length &&
+           strncmp(slice->value, param->value, slice->length) == 0;
+}
+
+// Compare tree dispatch with the linear scan, including the params captured
+static int same_as_linear(Router *router, const char *method, const char *path) {
+    int *expected = malloc(router->layer_count * sizeof(int));
+    LayerMatch *actual = malloc(router->layer_count * sizeof(LayerMatch));
+    RouteMatch **expected_params = calloc(router->layer_count, sizeof(RouteMatch *));
+    int route_matches = 0;
+    int ok = 1;
+    Request req;
+    request_init(&req, -1, "GET / HTTP/1.1\r\n\r\n");
+
+    int expected_count = linear_match(router, method, path, expected);
+    for (int i = 0; i < expected_count; i++) {
+        // Parameters as the original matcher captures them
+        RoutePattern *pattern = (RoutePattern *)router->layers[expected[i]].pattern;
+        if (pattern) {
+            expected_params[i] = malloc(sizeof(RouteMatch));
+            *expected_params[i] = route_pattern_match(pattern, path);
+        }
+    }
+    int actual_count = router_match(router, method, path, actual, &route_matches, &req);
+
+    if (actual_count != expected_count) {
+        printf("    %s %s: %d layers from the tree, %d expected\n", method, path, actual_count, expected_count);
+        ok = 0;
+    }
+    for (int i = 0; ok && i < actual_count; i++) {
+        RouteMatch *want = expected_params[i];
+        int want_count = want ? want->param_count : 0;
+        if (actual[i].layer != expected[i]) {
+            printf("    %s %s: layer %d at position %d, expected %d\n", method, path, actual[i].layer, i, expected[i]);
+            ok = 0;
+            break;
+        }
+        if (actual[i].slice_count != want_count) ok = 0;
+        for (int p = 0; ok && p < want_count; p++) {
+            ok = same_param(&req.route_slices[actual[i].slice_start + p], &want->params[p]);
+        }
+        if (!ok) printf("    %s %s: params differ for layer %d\n", method, path, actual[i].layer);
+    }
+
+    for (int i = 0; i < expected_count; i++) {
+        if (expected_params[i]) {
+            free_route_match(expected_params[i]);
+            free(expected_params[i]);
+        }
+    }
+    request_destroy(&req);
+    free(expected_params);
+    free(expected);
+    free(actual);
+    return ok;
+}
+
+int main() {
+    printf("Testing radix-tree route lookup...\n");
+    char msg[256];
+
+    // Test 1: Every kind of layer, checked against the linear scan
+    printf("\nTest 1: Lookup matches the linear scan\n");
+    Router *router = create_router();
+    Router *child = create_router();
+    router_get(child, "/status", noop_handler);
+
+    router_use(router, NULL, noop_handler);
+    router_get(router, "/", noop_handler);
+    router_get(router, "/users", noop_handler);
+    router_get(router, "/users/", noop_handler);
+    router_get(router, "/users/new", noop_handler);
+    router_get(router, "/users/:id:number", noop_handler);
+    router_get(router, "/users/:name", noop_handler);
+    router_post(router, "/users/:id:number", noop_handler);
+    router_get(router, "/users/:id:number/posts/:post?", noop_handler);
+    router_get(router, "/users/:id/posts/latest", noop_handler);
+    router_get(router, "/api/v1/items/:slug:slug", noop_handler);
+    router_get(router, "/api/v1/items/:id:uuid", noop_handler);
+    router_get(router, "/api/v1/orders", noop_handler);
+    router_get(router, "/api/v2/orders", noop_handler);
+    router_get(router, "/api/v1/orders/:id:number(min=1,max=100)", noop_handler);
+    router_get(router, "/files/*", noop_handler);
+    router_get(router, "/files/*/meta", noop_handler);
+    router_get(router, "/a/:x?/b", noop_handler);
+    router_get(router, "/opt/:page:number?", noop_handler);
+    router_use(router, "/admin/:section", noop_handler);
+    router_get(router, "/admin/:section", noop_handler);
+    router_mount(router, "/mounted", child);
+    router_get(router, "/*", noop_handler);
+
+    const char *methods[] = { "GET", "POST" };
+    const char *paths[] = {
+        "/", "/users", "/users/", "/users/new", "/users/42", "/users/bob", "/users/42/posts",
+        "/users/42/posts/7", "/users/bob/posts/latest", "/users/42/posts/latest", "/api/v1/items/my-item",
+        "/api/v1/items/123e4567-e89b-12d3-a456-426614174000", "/api/v1/items/bad!slug", "/api/v1/orders",
+        "/api/v2/orders", "/api/v3/orders", "/api/v1/orders/5", "/api/v1/orders/500", "/api/v1/orders/x",
+        "/files", "/files/a/b/c", "/files/x/meta", "/a/b", "/a/c/b", "/a", "/opt", "/opt/3", "/opt/x",
+        "/admin", "/admin/users", "/admin/users/1", "/mounted/status", "/mountedx", "//users//42",
+        "/unknown/path/deep",
+    };
+
+    for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++) {
+        for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); p++) {
+            snprintf(msg, sizeof(msg), "%s %s", methods[m], paths[p]);
+            CHECK(same_as_linear(router, methods[m], paths[p]), msg);
+        }
+    }
+
+    // Test 2: Literal edges are compressed and split on divergence
+    printf("\nTest 2: Compressed literal edges\n");
+    {
+        Router *r = create_router();
+        router_get(r, "/api/v1/users/list", noop_handler);
+        RouteTreeNode *root = r->tree->root;
+        CHECK(root->static_count == 1 && root->statics[0]->label_count == 4, "single route is one edge");
+
+        router_get(r, "/api/v1/orders", noop_handler);
+        RouteTreeNode *api = root->statics[0];
+        CHECK(api->label_count == 2 && api->static_count == 2, "diverging route splits the edge");
+        CHECK(same_as_linear(r, "GET", "/api/v1/users/list") && same_as_linear(r, "GET", "/api/v1/orders") &&
+              same_as_linear(r, "GET", "/api/v1"), "lookups after the split");
+        destroy_router(r);
+    }
+
+    // Test 3: Several hundred routes
+    printf("\nTest 3: Large route table\n");
+    {
+        Router *r = create_router();
+        char (*patterns)[64] = malloc(600 * sizeof(*patterns));
+        for (int i = 0; i < 200; i++) {
+            snprintf(patterns[i * 3], 64, "/service%d/items", i);
+            snprintf(patterns[i * 3 + 1], 64, "/service%d/items/:id:number", i);
+            snprintf(patterns[i * 3 + 2], 64, "/service%d/items/:id/*", i);
+            router_get(r, patterns[i * 3], noop_handler);
+            router_get(r, patterns[i * 3 + 1], noop_handler);
+            router_post(r, patterns[i * 3 + 2], noop_handler);
+        }
+        int ok = 1;
+        for (int i = 0; i < 200 && ok; i += 7) {
+            char path[96];
+            snprintf(path, sizeof(path), "/service%d/items/%d", i, i);
+            ok = same_as_linear(r, "GET", path);
+            snprintf(path, sizeof(path), "/service%d/items/abc/x/y", i);
+            ok = ok && same_as_linear(r, "POST", path);
+        }
+        CHECK(ok, "600 routes match the linear scan");
+
+        LayerMatch *matches = malloc(r->layer_count * sizeof(LayerMatch));
+        int route_matches = 0;
+        int count = router_match(r, "GET", "/service150/items/9", matches, &route_matches, NULL);
+        CHECK(count == 1 && matches[0].layer == 451 && route_matches == 1, "lookup finds the one matching layer");
+        free(matches);
+        destroy_router(r);
+        free(patterns);
+    }
+
+    // Test 4: Matching straight into path slices
+    printf("\nTest 4: Parameter slices\n");
+    {
+        ParamSlice slices[4];
+        RoutePattern *posts = compile_route_pattern("/users/:id:number/posts/:post?");
+        RoutePattern *files = compile_route_pattern("/files/*");
+        RoutePattern *ranged = compile_route_pattern("/orders/:id:number(min=1,max=100)");
+        const char *path = "/users/42/posts/7";
+
+        int count = route_pattern_match_slices(posts, path, slices, 4);
+        CHECK(count == 2 && slices[0].value == path + 7 && slices[0].length == 2 &&
+              strcmp(slices[0].name, "id") == 0, "slices point into the path");
+        CHECK(count == 2 && slices[1].length == 1 && slices[1].value[0] == '7', "optional parameter captured");
+        CHECK(route_pattern_match_slices(posts, "/users/42/posts", slices, 4) == 1, "optional parameter skipped");
+        CHECK(route_pattern_match_slices(posts, "/users/x/posts", slices, 4) == -1, "type check rejects");
+        CHECK(route_pattern_match_slices(files, "/files/a/b", slices, 4) == 0, "wildcard takes the rest");
+        CHECK(route_pattern_match_slices(posts, "/users/42/posts/7", slices, 1) == 2 &&
+              slices[0].length == 2, "captures past max_slices are counted, not written");
+
+        count = route_pattern_match_slices(ranged, "/orders/500", slices, 4);
+        CHECK(count == 1 && !validate_route_slices(ranged, slices, count, NULL), "constraints checked on slices");
+        count = route_pattern_match_slices(ranged, "/orders/50", slices, 4);
+        CHECK(count == 1 && validate_route_slices(ranged, slices, count, NULL), "valid value passes constraints");
+
+        free_route_pattern(posts);
+        free_route_pattern(files);
+        free_route_pattern(ranged);
+
+        // More parameters than a request holds: the last one's constraint
+        // could not be checked, so the route never matches
+        char many[256] = "/x", path_ok[128] = "/x", path_bad[160];
+        for (int i = 0; i < REQUEST_MAX_ROUTE_SLICES; i++) {
+            size_t used = strlen(many), path_used = strlen(path_ok);
+            snprintf(many + used, sizeof(many) - used, "/:p%d", i);
+            snprintf(path_ok + path_used, sizeof(path_ok) - path_used, "/%d", i);
+        }
+        snprintf(path_bad, sizeof(path_bad), "%s/999", path_ok);
+        strcat(path_ok, "/3");
+        strcat(many, "/:q:number(max=5)");
+        Router *r = create_router();
+        router_get(r, many, noop_handler);
+        router_use(r, many, noop_handler);
+        LayerMatch matches[2];
+        ParamSlice all[REQUEST_MAX_ROUTE_SLICES];
+        int route_matches = 0, slice_count = 0;
+        CHECK(router_match(r, "GET", path_bad, matches, &route_matches, NULL) == 0 &&
+              router_match(r, "GET", path_ok, matches, &route_matches, NULL) == 0,
+              "route and middleware with too many parameters never match");
+        CHECK(!layer_match_path(&r->layers[0], path_ok, all, REQUEST_MAX_ROUTE_SLICES, &slice_count, NULL) &&
+              !layer_match_path(&r->layers[1], path_ok, all, REQUEST_MAX_ROUTE_SLICES, &slice_count, NULL),
+              "layers refuse captures past max_slices");
+        destroy_router(r);
+    }
+
+    // Test 5: Typed parameter and regex constraint checks
+    printf("\nTest 5: Parameter validators\n");
+    {
+        CHECK(validate_parameter_value("123e4567-e89b-12d3-a456-426614174000", PARAM_UUID) &&
+              validate_parameter_value("123E4567-E89B-12D3-A456-426614174000", PARAM_UUID), "UUIDs accepted");
+        CHECK(!validate_parameter_value("123e4567-e89b-12d3-a456-42661417400", PARAM_UUID) &&
+              !validate_parameter_value("123e4567xe89b-12d3-a456-426614174000", PARAM_UUID) &&
+              !validate_parameter_value("g23e4567-e89b-12d3-a456-426614174000", PARAM_UUID), "malformed UUIDs rejected");
+        CHECK(validate_parameter_value("42", PARAM_NUMBER) && validate_parameter_value("-7", PARAM_NUMBER) &&
+              validate_parameter_value(" +3", PARAM_NUMBER) && validate_parameter_value("", PARAM_NUMBER),
+              "numbers accepted as strtol would");
+        CHECK(!validate_parameter_value("4x", PARAM_NUMBER) && !validate_parameter_value("-", PARAM_NUMBER) &&
+              !validate_parameter_value("5 ", PARAM_NUMBER), "partial numbers rejected");
+        CHECK(validate_parameter_value("\t8", PARAM_NUMBER) && !validate_parameter_value("\xa0" "8", PARAM_NUMBER),
+              "only spaces and tabs lead a number, whatever the locale");
+        CHECK(validate_parameter_value("my_item-2", PARAM_SLUG) && !validate_parameter_value("a b", PARAM_SLUG) &&
+              !validate_parameter_value("", PARAM_SLUG) && !validate_parameter_value("caf\xc3\xa9", PARAM_SLUG),
+              "slugs are ASCII letters, digits, '-' and '_'");
+
+        RoutePattern *code = compile_route_pattern_with_constraints("/codes/:code:string(regex=^[A-Z]{3}[0-9]{2}$)");
+        RouteConstraint *regex = code->segments[1].param->constraints;
+        CHECK(regex && regex->type == CONSTRAINT_REGEX && regex->compiled_regex, "regex compiled with the route");
+        ParamSlice slices[1];
+        int count = route_pattern_match_slices(code, "/codes/ABC12", slices, 1);
+        CHECK(count == 1 && validate_route_slices(code, slices, count, NULL), "regex constraint passes");
+        count = route_pattern_match_slices(code, "/codes/abc12", slices, 1);
+        CHECK(count == 1 && !validate_route_slices(code, slices, count, NULL), "regex constraint fails");
+        free_route_pattern(code);
+
+        RouteConstraint *broken = create_regex_constraint("([", NULL);
+        RouteParam param = { "p", PARAM_STRING, 0, "x", broken };
+        ValidationError error = {0};
+        CHECK(broken && !broken->compiled_regex && !validate_parameter_constraints(&param, &error),
+              "invalid regex rejects every value");
+        free_validation_error(&error);
+        free_constraint(broken);
+    }
+
+    // Test 6: Every path is compiled once, at registration
+    printf("\nTest 6: Patterns compiled at registration\n");
+    {
+        Router *r = create_router();
+        router_use(r, "/", noop_handler);
+        router_get(r, "/health", noop_handler);
+        router_get(r, "/users/:id", noop_handler);
+        int compiled = 1;
+        for (int i = 0; i < r->layer_count; i++) compiled = compiled && r->layers[i].pattern;
+        CHECK(compiled, "static, parameter and middleware paths all compiled");
+        CHECK(((RoutePattern *)r->layers[1].pattern)->is_static &&
+              !((RoutePattern *)r->layers[2].pattern)->is_static, "plain paths marked static");
+
+        LayerMatch matches[3];
+        int route_matches = 0;
+        int count = router_match(r, "GET", "/health", matches, &route_matches, NULL);
+        CHECK(count == 2 && matches[0].layer == 0 && matches[1].layer == 1, "middleware on a plain path runs for every request");
+        route_matches = 0;
+        CHECK(router_match(r, "GET", "/health/", matches, &route_matches, NULL) == 1 && route_matches == 0,
+              "plain paths still compare exactly");
+        destroy_router(r);
+    }
+
+    // Test 7: Methods parsed once and matched by bitmask; 405 with Allow
+    printf("\nTest 7: Method masks\n");
+    {
+        CHECK(http_method_parse("GET", 3) == HTTP_METHOD_GET && http_method_parse("PATCH", 5) == HTTP_METHOD_PATCH &&
+              http_method_parse("PUTS", 4) == HTTP_METHOD_OTHER && http_method_parse("get", 3) == HTTP_METHOD_OTHER &&
+              http_method_parse("GETX", 3) == HTTP_METHOD_GET, "known methods parsed, others are OTHER");
+        Request parsed;
+        request_init(&parsed, -1, "DELETE /items/1 HTTP/1.1\r\n\r\n");
+        CHECK(parsed.method_id == HTTP_METHOD_DELETE, "request head sets method_id");
+        request_destroy(&parsed);
+
+        Router *r = create_router();
+        router_use(r, "/", noop_handler);
+        router_get(r, "/items/:id:number", noop_handler);
+        router_put(r, "/items/:id:number", noop_handler);
+        router_add_layer(r, "PURGE", "/items/:id:number", noop_handler);
+        router_post(r, "/items", noop_handler);
+        CHECK(r->layers[0].type == LAYER_MIDDLEWARE && r->layers[0].methods == HTTP_METHODS_ALL &&
+              r->layers[1].methods == HTTP_METHOD_BIT(HTTP_METHOD_GET), "masks set at registration");
+
+        LayerMatch matches[5];
+        int route_matches = 0;
+        router_match(r, "PURGE", "/items/7", matches, &route_matches, NULL);
+        CHECK(route_matches == 1, "extension methods compared by name");
+        route_matches = 0;
+        router_match(r, "BREW", "/items/7", matches, &route_matches, NULL);
+        CHECK(route_matches == 0, "unknown extension method matches no route");
+
+        unsigned int allowed = router_allowed_methods(r, "/items/7", NULL);
+        CHECK(allowed == (HTTP_METHOD_BIT(HTTP_METHOD_GET) | HTTP_METHOD_BIT(HTTP_METHOD_PUT) |
+                          HTTP_METHOD_BIT(HTTP_METHOD_OTHER)), "allowed methods for a parameter path");
+        CHECK(router_allowed_methods(r, "/items/abc", NULL) == 0, "constraints apply to the allowed set");
+
+        char allow[64];
+        http_method_list(allowed, allow, sizeof(allow));
+        CHECK(strcmp(allow, "GET, PUT") == 0, "Allow lists the standard methods in order");
+
+        int fds[2];
+        char out[512] = {0};
+        if (pipe(fds) == 0) {
+            router_send_unmatched(fds[1], allowed, NULL);
+            ssize_t n = read(fds[0], out, sizeof(out) - 1);
+            if (n > 0) out[n] = '\0';
+            CHECK(strstr(out, " 405 ") && strstr(out, "Allow: GET, PUT\r\n"), "405 with an Allow header");
+            router_send_unmatched(fds[1], router_allowed_methods(r, "/nowhere", NULL), NULL);
+            n = read(fds[0], out, sizeof(out) - 1);
+            out[n > 0 ? n : 0] = '\0';
+            CHECK(strstr(out, " 404 ") && !strstr(out, "Allow:"), "unknown path is still a 404");
+            close(fds[0]);
+            close(fds[1]);
+        }
+        destroy_router(r);
+    }
+
+    destroy_router(router);
+    destroy_router(child);
+
+    return test_report("Route tree");
+}
@@ -0,0 +1,237 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../src/core/app.h"
+#include "test_helpers.h"
+
+// Publishing new routers while requests are in flight. Run under ASan
+// (and TSan, make test-tsan) to catch a table freed under a request.
+
+#define THREADS 4
+#define ROUNDS 2000
+#define PUBLISHES 100
+
+// What the handlers of one request saw, in order
+static __thread char trace[64];
+
+static void note(const char *tag) {
+    size_t used = strlen(trace);
+    snprintf(trace + used, sizeof(trace) - used, "%s%s", used ? " " : "", tag);
+}
+
+#define TAG_HANDLER(fn, tag, calls_next) \
+    static void fn(int client_fd, void (*next)(void *), void *context) { \
+        (void)client_fd; \
+        note(tag); \
+        if (calls_next) next(context); \
+    }
+
+TAG_HANDLER(h_v1, "v1", 0)
+TAG_HANDLER(h_v2, "v2", 0)
+TAG_HANDLER(h_after, "after", 0)
+TAG_HANDLER(mw_a, "A", 1)
+TAG_HANDLER(h_a, "a", 0)
+TAG_HANDLER(mw_b, "B", 1)
+TAG_HANDLER(h_b, "b", 0)
+
+// Holds its request on the old table until the main thread lets it go
+static pthread_barrier_t entered, released;
+
+static void mw_slow(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd;
+    note("slow");
+    pthread_barrier_wait(&entered);
+    pthread_barrier_wait(&released);
+    next(context);
+}
+
+static void *paused = NULL;
+
+static void mw_pause(int client_fd, void (*next)(void *), void *context) {
+    (void)client_fd; (void)next;
+    note("pause");
+    if (next_pause(context)) paused = context;
+}
+
+static int null_fd;
+
+// Dispatch into a caller's Request, which a paused chain keeps using
+static int dispatch(App *app, Request *req, const char *raw) {
+    trace[0] = '\0';
+    request_init(req, null_fd, raw);
+    return app_handle_request(app, req->method, req->path, null_fd, req);
+}
+
+static void dispatch_once(App *app, const char *raw) {
+    trace[0] = '\0';
+    test_dispatch(app, null_fd, raw);
+}
+
+static void *slow_main(void *arg) {
+    dispatch_once((App *)arg, "GET /slow HTTP/1.1\r\n\r\n");
+    char *seen = malloc(sizeof(trace));
+    memcpy(seen, trace, sizeof(trace));
+    return seen;
+}
+
+// Every request must run the middleware and handler of one version
+static int hot_stop = 0;
+
+static void *hot_main(void *arg) {
+    int *bad = calloc(1, sizeof(int));
+    for (int i = 0; i < ROUNDS || !__atomic_load_n(&hot_stop, __ATOMIC_ACQUIRE); i++) {
+        dispatch_once((App *)arg, "GET /hot HTTP/1.1\r\n\r\n");
+        if (strcmp(trace, "A a") != 0 && strcmp(trace, "B b") != 0) (*bad)++;
+    }
+    return bad;
+}
+
+static Router *draft_with(App *app, const char *path, Handler handler) {
+    Router *draft = app_draft_router(app);
+    router_get(draft, path, handler);
+    return draft;
+}
+
+int main() {
+    printf("Testing router publishing...\n");
+    null_fd = open("/dev/null", O_WRONLY);
+
+    App app = create_app();
+    app.get(&app, "/v1", h_v1);
+    app_freeze(&app);
+
+    // Test 1: New requests see the published routes
+    printf("\nTest 1: Publish\n");
+    dispatch_once(&app, "GET /v1 HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(trace, "v1") == 0, "app's own routes before publishing");
+    CHECK(app_publish_router(&app, draft_with(&app, "/v2", h_v2)) == 0, "draft published");
+    dispatch_once(&app, "GET /v2 HTTP/1.1\r\n\r\n");
+    CHECK(strcmp(trace, "v2") == 0, "published route served");
+    dispatch_once(&app, "GET /v1 HTTP/1.1\r\n\r\n");
+    CHECK(trace[0] == '\0', "old route gone");
+    CHECK(app_reclaim_routers(&app) == 0, "idle old table freed at once");
+
+    // Test 2: A request in flight finishes on the table it started on
+    printf("\nTest 2: Draining\n");
+    {
+        Router *draft = app_draft_router(&app);
+        router_use(draft, "/slow", mw_slow);
+        router_get(draft, "/slow", h_after);
+        app_publish_router(&app, draft);
+
+        pthread_t thread;
+        pthread_barrier_init(&entered, NULL, 2);
+        pthread_barrier_init(&released, NULL, 2);
+        pthread_create(&thread, NULL, slow_main, &app);
+        pthread_barrier_wait(&entered);
+
+        app_publish_router(&app, draft_with(&app, "/slow", h_v2));
+        CHECK(app_reclaim_routers(&app) == 1, "table kept while a request uses it");
+        dispatch_once(&app, "GET /slow HTTP/1.1\r\n\r\n");
+        CHECK(strcmp(trace, "v2") == 0, "new requests use the new table meanwhile");
+
+        pthread_barrier_wait(&released);
+        char *seen = NULL;
+        pthread_join(thread, (void **)&seen);
+        CHECK(seen && strcmp(seen, "slow after") == 0, "in-flight request finished its old chain");
+        free(seen);
+        CHECK(app_reclaim_routers(&app) == 0, "table freed once drained");
+        pthread_barrier_destroy(&entered);
+        pthread_barrier_destroy(&released);
+    }
+
+    // Test 3: A paused chain pins its table
+    printf("\nTest 3: Paused chains\n");
+    {
+        Router *draft = app_draft_router(&app);
+        router_use(draft, "/job", mw_pause);
+        router_get(draft, "/job", h_after);
+        app_publish_router(&app, draft);
+
+        Request req;
+        int completed = dispatch(&app, &req, "GET /job HTTP/1.1\r\n\r\n");
+        app_publish_router(&app, draft_with(&app, "/job", h_v2));
+        CHECK(!completed && paused && app_reclaim_routers(&app) == 1, "paused chain keeps the table");
+        next_handler(paused);
+        CHECK(strcmp(trace, "pause after") == 0, "resumed on the old table");
+        CHECK(app_reclaim_routers(&app) == 0, "table freed once the chain completed");
+        request_destroy(&req);
+    }
+
+    // Test 4: The app's own routes change while a chain is paused
+    printf("\nTest 4: App changes while paused\n");
+    {
+        Router *draft = app_draft_router(&app);
+        router_get(draft, "/job", mw_pause);
+        router_get(draft, "/job", h_after);
+        router_get(draft, "/v2", h_v2);
+        app_publish_router(&app, draft);
+
+        Request req;
+        int layers = app.router.layer_count;
+        paused = NULL;
+        int completed = dispatch(&app, &req, "GET /job HTTP/1.1\r\n\r\n");
+        app_set_route_cache(&app, 8);
+        app.get(&app, "/v1", h_v1);
+        app_freeze(&app);
+        CHECK(!completed && paused && app_reclaim_routers(&app) == 0, "published table left in place");
+        CHECK(app.router.layer_count == layers, "registering on the app refused");
+        next_handler(paused);
+        CHECK(strcmp(trace, "pause after") == 0, "paused chain resumed on it");
+        request_destroy(&req);
+        dispatch_once(&app, "GET /v2 HTTP/1.1\r\n\r\n");
+        CHECK(strcmp(trace, "v2") == 0, "published routes still served");
+        dispatch_once(&app, "GET /v1 HTTP/1.1\r\n\r\n");
+        CHECK(trace[0] == '\0', "app's own routes not refrozen");
+
+        paused = NULL;
+        completed = dispatch(&app, &req, "GET /job HTTP/1.1\r\n\r\n");
+        app_thaw(&app);
+        CHECK(!completed && paused && app_reclaim_routers(&app) == 1, "thawed table kept for the paused chain");
+        next_handler(paused);
+        CHECK(strcmp(trace, "pause after") == 0, "resumed on the thawed table");
+        CHECK(app_reclaim_routers(&app) == 0, "thawed table freed once the chain completed");
+        request_destroy(&req);
+        dispatch_once(&app, "GET /v1 HTTP/1.1\r\n\r\n");
+        CHECK(strcmp(trace, "v1") == 0, "thawing went back to the app's routes");
+    }
+
+    // Test 5: Publishing continuously under load
+    printf("\nTest 5: Publishing under load\n");
+    {
+        pthread_t threads[THREADS];
+        for (int i = 0; i <= PUBLISHES; i++) {
+            if (i == 1) {
+                for (int t = 0; t < THREADS; t++) pthread_create(&threads[t], NULL, hot_main, &app);
+            }
+            Router *draft = app_draft_router(&app);
+            router_use(draft, "/hot", i % 2 ? mw_b : mw_a);
+            router_get(draft, "/hot", i % 2 ? h_b : h_a);
+            app_publish_router(&app, draft);
+        }
+        __atomic_store_n(&hot_stop, 1, __ATOMIC_RELEASE);
+        int bad = 0;
+        for (int i = 0; i < THREADS; i++) {
+            int *result = NULL;
+            pthread_join(threads[i], (void **)&result);
+            bad += result ? *result : 1;
+            free(result);
+        }
+        CHECK(bad == 0, "every request ran a single version's chain");
+        CHECK(app_reclaim_routers(&app) == 0, "every replaced table freed");
+    }
+
+    app_thaw(&app);
+    for (int i = 0; i < app.router.layer_count; i++) {
+        free_route_pattern((RoutePattern *)app.router.layers[i].pattern);
+    }
+    free(app.router.layers);
+    route_tree_destroy(app.router.tree);
+    close(null_fd);
+
+    return test_report("Router swap");
+}
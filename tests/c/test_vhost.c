@@ -0,0 +1,145 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/core/app.h"
+#include "../src/core/vhost.h"
+#include "test_helpers.h"
+
+// Virtual hosts: routes served by Host header, unfrozen and frozen
+
+// The handler that answered the last request
+static const char *seen;
+
+#define TAG_HANDLER(fn, tag) \
+    static void fn(int client_fd, void (*next)(void *), void *context) { \
+        (void)client_fd; (void)next; (void)context; \
+        seen = tag; \
+    }
+
+TAG_HANDLER(h_default, "default")
+TAG_HANDLER(h_health, "health")
+TAG_HANDLER(h_api_users, "api-users")
+TAG_HANDLER(h_wild_root, "wild-root")
+TAG_HANDLER(h_wild_shared, "wild-shared")
+TAG_HANDLER(h_deep, "deep")
+
+static int out_fds[2];
+
+// The handler that took a request for `host` ("" when none did), or
+// "404" when the app answered it with a 404
+static const char *dispatch(App *app, const char *host, const char *path) {
+    static char raw[256];
+    char out[512];
+    if (host) snprintf(raw, sizeof(raw), "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n", path, host);
+    else snprintf(raw, sizeof(raw), "GET %s HTTP/1.1\r\n\r\n", path);
+
+    seen = "";
+    test_dispatch(app, out_fds[1], raw);
+    test_read_response(out_fds[0], out, sizeof(out));
+    return test_status(out) == 404 ? "404" : seen;
+}
+
+static int serves(App *app, const char *host, const char *path, const char *expected) {
+    const char *got = dispatch(app, host, path);
+    if (strcmp(got, expected) != 0) {
+        printf("  (%s %s: got '%s', expected '%s')\n", host ? host : "no host", path, got, expected);
+    }
+    return strcmp(got, expected) == 0;
+}
+
+// The same answers whether or not the app is frozen
+static void check_hosts(App *app) {
+    CHECK(serves(app, "api.example.com", "/users", "api-users"), "exact host served its route");
+    CHECK(serves(app, "API.Example.COM:8080", "/users", "api-users"), "case and port ignored");
+    CHECK(serves(app, "api.example.com.", "/users", "api-users"), "trailing dot ignored");
+    CHECK(serves(app, "api.example.com", "/shared", "wild-shared"), "wildcard routes reach the exact host");
+    CHECK(serves(app, "api.example.com", "/health", "health"), "app routes reach every host");
+    CHECK(serves(app, "www.example.com", "/users", "404"), "other hosts do not see a host's routes");
+    CHECK(serves(app, "www.example.com", "/", "wild-root"), "wildcard takes a subdomain");
+    CHECK(serves(app, "a.b.example.com", "/", "wild-root"), "wildcard takes nested subdomains");
+    CHECK(serves(app, "x.b.example.com", "/deep", "deep"), "narrower wildcard served its route");
+    CHECK(serves(app, "b.example.com", "/deep", "404"), "narrower wildcard leaves its bare domain");
+    CHECK(serves(app, "example.com", "/", "default"), "wildcard leaves the bare domain");
+    CHECK(serves(app, "example.org", "/", "default"), "unknown host gets the app's routes");
+    CHECK(serves(app, NULL, "/", "default"), "missing Host gets the app's routes");
+    CHECK(serves(app, NULL, "/users", "404"), "missing Host sees no host's routes");
+}
+
+int main() {
+    printf("Testing virtual hosts...\n");
+    if (test_response_pipe(out_fds) != 0) return 1;
+
+    // Test 1: Patterns
+    printf("\nTest 1: Patterns\n");
+    {
+        char *pattern = vhost_pattern_normalize("*.Example.COM.");
+        CHECK(pattern && strcmp(pattern, "*.example.com") == 0, "patterns stored lower case, without the dot");
+        CHECK(vhost_pattern_matches(pattern, "a.example.com", 13) &&
+              !vhost_pattern_matches(pattern, "example.com", 11) &&
+              !vhost_pattern_matches(pattern, "aexample.com", 12), "wildcard needs a whole label");
+        CHECK(vhost_pattern_covers(pattern, "*.b.example.com") && !vhost_pattern_covers("*.b.example.com", pattern),
+              "a wider wildcard covers a narrower one");
+        CHECK(vhost_host_length("[::1]:8080") == 5 && vhost_host_length("a.com.:80") == 5, "ports stripped");
+        CHECK(!vhost_pattern_normalize("*example.com") && !vhost_pattern_normalize("a.*.com") &&
+              !vhost_pattern_normalize("*."), "malformed wildcards refused");
+        free(pattern);
+    }
+
+    App app = create_app();
+    Router *api = create_router();
+    Router *wild = create_router();
+    Router *deep = create_router();
+    router_get(api, "/users", h_api_users);
+    router_get(wild, "/", h_wild_root);
+    router_get(wild, "/shared", h_wild_shared);
+    router_get(deep, "/deep", h_deep);
+    app.vhost(&app, "api.example.com", api);
+    app.vhost(&app, "*.example.com", wild);
+    app.vhost(&app, "*.b.example.com", deep);
+    int layers = app.router.layer_count;
+    app.vhost(&app, "*example.com", deep);
+    app.get(&app, "/", h_default);
+    app.get(&app, "/health", h_health);
+
+    // Test 2: Unfrozen dispatch filters by host
+    printf("\nTest 2: Unfrozen\n");
+    CHECK(app.router.layer_count == layers + 2, "invalid pattern not mounted");
+    check_hosts(&app);
+
+    // Test 3: Frozen dispatch picks a table per host
+    printf("\nTest 3: Frozen\n");
+    app_freeze(&app);
+    CHECK(app.frozen != NULL, "app frozen with virtual hosts");
+    check_hosts(&app);
+
+    // Test 4: Cached lookups stay with their host
+    printf("\nTest 4: Route cache\n");
+    app_set_route_cache(&app, 16);
+    app_freeze(&app);
+    CHECK(serves(&app, "api.example.com", "/users", "api-users") &&
+          serves(&app, "api.example.com", "/users", "api-users"), "host's route cached");
+    CHECK(serves(&app, "www.example.com", "/users", "404"), "same path on another host not taken from it");
+    RouteCacheStats stats;
+    app_route_cache_stats(&app, &stats);
+    CHECK(stats.hits == 1 && stats.misses == 2, "hosts counted in the app's stats");
+    check_hosts(&app);
+
+    app_thaw(&app);
+    for (int i = 0; i < app.router.layer_count; i++) {
+        free((char *)app.router.layers[i].mount_prefix);
+        free(app.router.layers[i].host);
+        free_route_pattern((RoutePattern *)app.router.layers[i].pattern);
+    }
+    free(app.router.layers);
+    route_tree_destroy(app.router.tree);
+    destroy_router(api);
+    destroy_router(wild);
+    destroy_router(deep);
+    close(out_fds[0]);
+    close(out_fds[1]);
+
+    return test_report("Virtual host");
+}
@@ -0,0 +1,622 @@
+// routegen: compile a route manifest to a C route table
+// ====================================================
+// Reads "METHOD /path handler" lines (blank lines and '#' comments are
+// skipped) and writes a C source defining `const RouteTable <name>` and
+// the middleware `<name>_handler` serving it (see src/core/route_table.h).
+// Paths are parsed here with the router's own compile_route_pattern, so
+// the generated matcher takes exactly what the router would; routes the
+// generated code cannot express (optional parameters, constraints, a
+// wildcard before the end) are refused and belong on a Router.
+//
+// Usage: routegen [-n name] manifest [output.c]
+
+#define _GNU_SOURCE
+#include "src/core/route.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 1024
+#define DEFER_TO_MATCHER -2      // Static slot: a parameterized route wins, ask the matcher
+
+typedef struct {
+    HttpMethod method;
+    char *path;
+    char *handler;
+    int line;
+    RoutePattern *pattern;
+    int fixed;                   // Segments before the wildcard, or all of them
+} ManifestRoute;
+
+typedef struct {
+    ManifestRoute *routes;
+    int count;
+    int capacity;
+} Manifest;
+
+static const char *method_names[HTTP_METHOD_COUNT] = {
+    [HTTP_METHOD_GET] = "GET", [HTTP_METHOD_HEAD] = "HEAD", [HTTP_METHOD_POST] = "POST",
+    [HTTP_METHOD_PUT] = "PUT", [HTTP_METHOD_DELETE] = "DELETE", [HTTP_METHOD_PATCH] = "PATCH",
+    [HTTP_METHOD_OPTIONS] = "OPTIONS", [HTTP_METHOD_CONNECT] = "CONNECT", [HTTP_METHOD_TRACE] = "TRACE"
+};
+
+static int is_identifier(const char *name) {
+    if (!isalpha((unsigned char)name[0]) && name[0] != '_') return 0;
+    for (const char *c = name; *c; c++) {
+        if (!isalnum((unsigned char)*c) && *c != '_') return 0;
+    }
+    return 1;
+}
+
+// Can the generated matcher express the pattern? Sets route->fixed.
+static const char *unsupported(ManifestRoute *route) {
+    const RoutePattern *pattern = route->pattern;
+    route->fixed = pattern->segment_count;
+    if (pattern->param_count > REQUEST_MAX_ROUTE_SLICES) return "too many parameters";
+    for (int i = 0; i < pattern->segment_count; i++) {
+        const RouteSegment *segment = &pattern->segments[i];
+        if (segment->type == SEGMENT_OPTIONAL) return "optional parameters are not supported";
+        if (segment->param && segment->param->constraints) return "constraints are not supported";
+        if (segment->type == SEGMENT_WILDCARD) {
+            if (i != pattern->segment_count - 1) return "a wildcard must end the path";
+            route->fixed = i;
+        }
+    }
+    return NULL;
+}
+
+static int manifest_read(Manifest *manifest, const char *file_name) {
+    FILE *file = fopen(file_name, "r");
+    char line[MAX_LINE];
+    int line_number = 0;
+    if (!file) {
+        perror(file_name);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        char *method = strtok(line, " \t\r\n");
+        if (!method) continue;
+        char *path = strtok(NULL, " \t\r\n");
+        char *handler = strtok(NULL, " \t\r\n");
+        if (!path || !handler || strtok(NULL, " \t\r\n")) {
+            fprintf(stderr, "%s:%d: expected \"METHOD /path handler\"\n", file_name, line_number);
+            goto fail;
+        }
+        HttpMethod method_id = http_method_parse(method, strlen(method));
+        if (method_id == HTTP_METHOD_OTHER) {
+            fprintf(stderr, "%s:%d: unknown method '%s'\n", file_name, line_number, method);
+            goto fail;
+        }
+        if (path[0] != '/' || !is_identifier(handler)) {
+            fprintf(stderr, "%s:%d: bad path or handler name\n", file_name, line_number);
+            goto fail;
+        }
+
+        if (manifest->count == manifest->capacity) {
+            int capacity = manifest->capacity ? manifest->capacity * 2 : 64;
+            ManifestRoute *routes = realloc(manifest->routes, capacity * sizeof(ManifestRoute));
+            if (!routes) goto fail;
+            manifest->routes = routes;
+            manifest->capacity = capacity;
+        }
+        ManifestRoute *route = &manifest->routes[manifest->count];
+        route->method = method_id;
+        route->path = strdup(path);
+        route->handler = strdup(handler);
+        route->line = line_number;
+        route->pattern = compile_route_pattern(path);
+        if (!route->path || !route->handler || !route->pattern) {
+            fprintf(stderr, "%s:%d: could not compile '%s'\n", file_name, line_number, path);
+            free(route->path);
+            free(route->handler);
+            free_route_pattern(route->pattern);
+            goto fail;
+        }
+        manifest->count++;
+        const char *problem = unsupported(route);
+        if (problem) {
+            fprintf(stderr, "%s:%d: %s: %s (register it on a Router instead)\n", file_name, line_number, path,
+                    problem);
+            goto fail;
+        }
+    }
+    fclose(file);
+    return 0;
+
+fail:
+    fclose(file);
+    return -1;
+}
+
+// Must match the hashing the generated lookup does: FNV-1a of the path,
+// then a displacement per bucket mixed in to pick the slot
+static uint32_t path_hash(const char *path, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (const char *c = path; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t slot_mix(uint32_t hash) {
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    hash *= 0x846ca68bu;
+    return hash ^ (hash >> 16);
+}
+
+// Static paths placed by hash and displace: the path's hash picks a bucket,
+// and the bucket's displacement is the one that sends all its paths to
+// free slots
+typedef struct {
+    uint32_t seed;
+    int buckets;
+    int slots;
+    uint32_t *displace;          // Per bucket
+    int *slot_key;               // Per slot: route whose path is there, or -1
+} PerfectHash;
+
+// First route of the manifest taking (method, path), as the router picks
+static int first_route(const Manifest *manifest, HttpMethod method, const char *path, unsigned int *allowed) {
+    for (int i = 0; i < manifest->count; i++) {
+        const ManifestRoute *route = &manifest->routes[i];
+        if (!route_pattern_matches(route->pattern, path)) continue;
+        if (route->method == method) return i;
+        *allowed |= HTTP_METHOD_BIT(route->method);
+    }
+    return -1;
+}
+
+// What a static route compares request paths with
+static const char *static_path(const Manifest *manifest, int route) {
+    return manifest->routes[route].pattern->original_pattern;
+}
+
+// Distinct static paths, each as the index of its first route
+static int *static_keys(const Manifest *manifest, int *count) {
+    int *keys = malloc((manifest->count > 0 ? manifest->count : 1) * sizeof(int));
+    *count = 0;
+    if (!keys) return NULL;
+    for (int i = 0; i < manifest->count; i++) {
+        if (!manifest->routes[i].pattern->is_static) continue;
+        int known = 0;
+        for (int k = 0; k < *count && !known; k++) {
+            known = strcmp(static_path(manifest, keys[k]), static_path(manifest, i)) == 0;
+        }
+        if (!known) keys[(*count)++] = i;
+    }
+    return keys;
+}
+
+static int bucket_size_order(const void *a, const void *b, void *sizes) {
+    return ((int *)sizes)[*(const int *)b] - ((int *)sizes)[*(const int *)a];
+}
+
+static int perfect_try(const Manifest *manifest, const int *keys, int key_count, PerfectHash *hash) {
+    uint32_t mask = (uint32_t)hash->buckets - 1;
+    int *sizes = calloc(hash->buckets, sizeof(int));
+    int *start = calloc(hash->buckets + 1, sizeof(int));
+    int *order = malloc(hash->buckets * sizeof(int));
+    uint32_t *hashes = malloc(key_count * sizeof(uint32_t));
+    int *members = malloc(key_count * sizeof(int));   // Key indexes grouped by bucket
+    int *slots = malloc(key_count * sizeof(int));
+    int placed = 0;
+    if (!sizes || !start || !order || !hashes || !members || !slots) goto done;
+
+    for (int k = 0; k < key_count; k++) {
+        hashes[k] = path_hash(static_path(manifest, keys[k]), hash->seed);
+        sizes[hashes[k] & mask]++;
+    }
+    for (int b = 0; b < hash->buckets; b++) start[b + 1] = start[b] + sizes[b];
+    // `order` serves as the fill cursors until it is sorted
+    memcpy(order, start, hash->buckets * sizeof(int));
+    for (int k = 0; k < key_count; k++) members[order[hashes[k] & mask]++] = k;
+    for (int b = 0; b < hash->buckets; b++) order[b] = b;
+    // Fullest buckets first, while most slots are free
+    qsort_r(order, hash->buckets, sizeof(int), bucket_size_order, sizes);
+    for (int s = 0; s < hash->slots; s++) hash->slot_key[s] = -1;
+
+    for (int o = 0; o < hash->buckets && sizes[order[o]] > 0; o++) {
+        int bucket = order[o], fits = 0;
+        for (uint32_t displace = 0; displace < 1000000 && !fits; displace++) {
+            int count = 0;
+            fits = 1;
+            for (int m = start[bucket]; m < start[bucket + 1] && fits; m++) {
+                int slot = slot_mix(hashes[members[m]] ^ displace) & (hash->slots - 1);
+                if (hash->slot_key[slot] >= 0) {
+                    fits = 0;
+                } else {
+                    hash->slot_key[slot] = keys[members[m]];
+                    slots[count++] = slot;
+                }
+            }
+            if (fits) hash->displace[bucket] = displace;
+            else while (count > 0) hash->slot_key[slots[--count]] = -1;
+        }
+        if (!fits) goto done;
+    }
+    placed = 1;
+
+done:
+    free(sizes);
+    free(start);
+    free(order);
+    free(hashes);
+    free(members);
+    free(slots);
+    return placed ? 0 : -1;
+}
+
+static int perfect_build(const Manifest *manifest, const int *keys, int key_count, PerfectHash *hash) {
+    hash->buckets = 1;
+    while (hash->buckets * 2 < key_count) hash->buckets *= 2;
+    hash->slots = 1;
+    while (hash->slots < key_count * 2) hash->slots *= 2;
+    hash->displace = calloc(hash->buckets, sizeof(uint32_t));
+    hash->slot_key = malloc(hash->slots * sizeof(int));
+    if (!hash->displace || !hash->slot_key) return -1;
+    // A new seed if two paths share a full hash or a bucket will not fit
+    for (hash->seed = 1; hash->seed < 64; hash->seed++) {
+        if (perfect_try(manifest, keys, key_count, hash) == 0) return 0;
+    }
+    return -1;
+}
+
+static void emit_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', out);
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+static void emit_static_table(FILE *out, const Manifest *manifest, const char *name, const PerfectHash *hash) {
+    fprintf(out, "// Static paths: a displacement per bucket of the path hash, then one slot\n");
+    fprintf(out, "static const uint32_t %s_displace[%d] = {", name, hash->buckets);
+    for (int b = 0; b < hash->buckets; b++) {
+        fprintf(out, "%s%uu", b % 8 ? ", " : (b ? ",\n    " : "\n    "), hash->displace[b]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static const struct {\n    const char *path;\n    size_t length;\n");
+    fprintf(out, "    int route[HTTP_METHOD_COUNT];   // Per method; %d: a parameterized route\n", DEFER_TO_MATCHER);
+    fprintf(out, "    unsigned int allowed;\n} %s_static[%d] = {\n", name, hash->slots);
+    for (int s = 0; s < hash->slots; s++) {
+        if (hash->slot_key[s] < 0) {
+            fprintf(out, "    { NULL, 0, { 0 }, 0 },\n");
+            continue;
+        }
+        const char *path = static_path(manifest, hash->slot_key[s]);
+        unsigned int allowed = 0;
+        fprintf(out, "    { ");
+        emit_string(out, path);
+        fprintf(out, ", %zu, {", strlen(path));
+        for (int m = 0; m < HTTP_METHOD_COUNT; m++) {
+            int route = m == HTTP_METHOD_OTHER ? -1 : first_route(manifest, (HttpMethod)m, path, &allowed);
+            if (route >= 0 && !manifest->routes[route].pattern->is_static) route = DEFER_TO_MATCHER;
+            fprintf(out, "%s%d", m ? ", " : " ", route);
+        }
+        fprintf(out, " }, 0x%xu },\n", allowed);
+    }
+    fprintf(out, "};\n\n");
+}
+
+// Literal first segment of a parameterized route, or NULL when any
+// segment can come first
+static const char *first_literal(const ManifestRoute *route) {
+    const RouteSegment *first = &route->pattern->segments[0];
+    return route->fixed > 0 && first->type == SEGMENT_LITERAL ? first->literal_value : NULL;
+}
+
+// The comparisons for one parameterized route against seg[]/len[], from
+// segment `from` on (those before are already known to match)
+static void emit_route_match(FILE *out, const ManifestRoute *route, int index, int from, int indent) {
+    static const char *types[] = { "PARAM_STRING", "PARAM_NUMBER", "PARAM_SLUG", "PARAM_UUID", "PARAM_ANY" };
+    const RoutePattern *pattern = route->pattern;
+    int conditions = 0;
+    fprintf(out, "%*s// %s %s\n%*s", indent, "", method_names[route->method], route->path, indent, "");
+    for (int i = from; i < route->fixed; i++) {
+        const RouteSegment *segment = &pattern->segments[i];
+        fprintf(out, conditions++ ? " &&\n%*s    " : "if (", indent, "");
+        if (segment->type == SEGMENT_LITERAL) {
+            size_t length = strlen(segment->literal_value);
+            fprintf(out, "len[%d] == %zu && memcmp(seg[%d], ", i, length, i);
+            emit_string(out, segment->literal_value);
+            fprintf(out, ", %zu) == 0", length);
+        } else if (segment->param->type == PARAM_STRING || segment->param->type == PARAM_ANY) {
+            fprintf(out, "len[%d] > 0", i);
+        } else {
+            fprintf(out, "validate_parameter_slice(seg[%d], len[%d], %s)", i, i, types[segment->param->type]);
+        }
+    }
+    fprintf(out, "%s{\n", conditions ? ") " : "");
+    fprintf(out, "%*s    if (method == HTTP_METHOD_%s) {\n", indent, "", method_names[route->method]);
+    int captured = 0;
+    for (int i = 0; i < route->fixed; i++) {
+        const RouteSegment *segment = &pattern->segments[i];
+        if (segment->type != SEGMENT_PARAMETER) continue;
+        fprintf(out, "%*s        slices[%d].name = ", indent, "", captured);
+        emit_string(out, segment->param->name);
+        fprintf(out, ";\n%*s        slices[%d].value = seg[%d];\n", indent, "", captured, i);
+        fprintf(out, "%*s        slices[%d].length = len[%d];\n", indent, "", captured, i);
+        captured++;
+    }
+    if (captured) fprintf(out, "%*s        *slice_count = %d;\n", indent, "", captured);
+    fprintf(out, "%*s        return %d;\n%*s    }\n", indent, "", index, indent, "");
+    fprintf(out, "%*s    *allowed |= HTTP_METHOD_BIT(HTTP_METHOD_%s);\n%*s}\n", indent, "",
+            method_names[route->method], indent, "");
+}
+
+// The routes a first segment equal to `literal` can take: its own, and
+// those starting with a parameter, in manifest order
+static void emit_literal_group(FILE *out, const Manifest *manifest, const int *routes, int count,
+                               const char *literal, int indent) {
+    fprintf(out, "%*sif (memcmp(seg[0], ", indent, "");
+    emit_string(out, literal);
+    fprintf(out, ", %zu) == 0) {\n", strlen(literal));
+    for (int r = 0; r < count; r++) {
+        const ManifestRoute *route = &manifest->routes[routes[r]];
+        const char *first = first_literal(route);
+        if (!first) emit_route_match(out, route, routes[r], 0, indent + 4);
+        else if (strcmp(first, literal) == 0) emit_route_match(out, route, routes[r], 1, indent + 4);
+    }
+    fprintf(out, "%*s    return -1;\n%*s}\n", indent, "", indent, "");
+}
+
+// Distinct first-segment literals of one length: a switch on the character
+// telling most of them apart, down to a few compares per path
+static void emit_literal_tree(FILE *out, const Manifest *manifest, const int *routes, int count,
+                              const char **literals, int literal_count, int indent) {
+    if (literal_count <= 4) {
+        for (int l = 0; l < literal_count; l++) {
+            emit_literal_group(out, manifest, routes, count, literals[l], indent);
+        }
+        return;
+    }
+
+    size_t length = strlen(literals[0]), best = 0;
+    int best_distinct = 0;
+    for (size_t pos = 0; pos < length; pos++) {
+        unsigned char seen[256] = { 0 };
+        int distinct = 0;
+        for (int l = 0; l < literal_count; l++) {
+            distinct += !seen[(unsigned char)literals[l][pos]];
+            seen[(unsigned char)literals[l][pos]] = 1;
+        }
+        if (distinct > best_distinct) {
+            best_distinct = distinct;
+            best = pos;
+        }
+    }
+
+    const char **subset = malloc(literal_count * sizeof(const char *));
+    unsigned char done[256] = { 0 };
+    if (!subset) return;
+    fprintf(out, "%*sswitch (seg[0][%zu]) {\n", indent, "", best);
+    for (int l = 0; l < literal_count; l++) {
+        unsigned char c = (unsigned char)literals[l][best];
+        if (done[c]) continue;
+        done[c] = 1;
+        int subset_count = 0;
+        for (int o = l; o < literal_count; o++) {
+            if ((unsigned char)literals[o][best] == c) subset[subset_count++] = literals[o];
+        }
+        if (c == '\'' || c == '\\') fprintf(out, "%*scase '\\%c':\n", indent, "", c);
+        else if (isprint(c)) fprintf(out, "%*scase '%c':\n", indent, "", c);
+        else fprintf(out, "%*scase %d:\n", indent, "", (int)(signed char)c);
+        emit_literal_tree(out, manifest, routes, count, subset, subset_count, indent + 4);
+        fprintf(out, "%*s    break;\n", indent, "");
+    }
+    fprintf(out, "%*s}\n", indent, "");
+    free(subset);
+}
+
+// One segment count's routes, in manifest order. Routes starting with
+// different literals never take the same path, so a first segment only
+// tries its own routes and those starting with a parameter.
+static void emit_count_case(FILE *out, const Manifest *manifest, const int *routes, int count) {
+    const char **literals = malloc(count * sizeof(const char *));
+    int literal_count = 0;
+    if (!literals) return;
+    for (int r = 0; r < count; r++) {
+        const char *literal = first_literal(&manifest->routes[routes[r]]);
+        int known = !literal;
+        for (int l = 0; l < literal_count && !known; l++) known = strcmp(literals[l], literal) == 0;
+        if (!known) literals[literal_count++] = literal;
+    }
+
+    if (literal_count > 0) {
+        const char **same_length = malloc(literal_count * sizeof(const char *));
+        if (!same_length) {
+            free(literals);
+            return;
+        }
+        fprintf(out, "        switch (len[0]) {\n");
+        for (int l = 0; l < literal_count; l++) {
+            size_t length = strlen(literals[l]);
+            int first_of_length = 1, same_count = 0;
+            for (int e = 0; e < l && first_of_length; e++) first_of_length = strlen(literals[e]) != length;
+            if (!first_of_length) continue;
+            for (int o = l; o < literal_count; o++) {
+                if (strlen(literals[o]) == length) same_length[same_count++] = literals[o];
+            }
+            fprintf(out, "        case %zu:\n", length);
+            emit_literal_tree(out, manifest, routes, count, same_length, same_count, 12);
+            fprintf(out, "            break;\n");
+        }
+        fprintf(out, "        }\n");
+        free(same_length);
+    }
+    for (int r = 0; r < count; r++) {
+        const ManifestRoute *route = &manifest->routes[routes[r]];
+        if (!first_literal(route)) emit_route_match(out, route, routes[r], 0, 8);
+    }
+    free(literals);
+}
+
+static int emit_matcher(FILE *out, const Manifest *manifest, const char *name) {
+    int most = 0, parameterized = 0;
+    int *routes = malloc((manifest->count > 0 ? manifest->count : 1) * sizeof(int));
+    if (!routes) return -1;
+    for (int i = 0; i < manifest->count; i++) {
+        const ManifestRoute *route = &manifest->routes[i];
+        if (route->pattern->is_static) continue;
+        parameterized++;
+        if (route->fixed > most) most = route->fixed;
+    }
+
+    fprintf(out, "// Parameterized paths, by segment count and first segment\n");
+    fprintf(out, "static int %s_match(HttpMethod method, const char *path, ParamSlice *slices, int *slice_count,\n",
+            name);
+    fprintf(out, "%*sunsigned int *allowed) {\n", (int)(strlen(name) + 18), "");
+    if (parameterized == 0) {
+        fprintf(out, "    (void)method; (void)path; (void)slices; (void)slice_count; (void)allowed;\n");
+        fprintf(out, "    return -1;\n}\n\n");
+        free(routes);
+        return 0;
+    }
+    fprintf(out, "    const char *seg[%d];\n    size_t len[%d];\n    size_t pos = 0;\n    int count = 0;\n",
+            most + 1, most + 1);
+    fprintf(out, "    while (count <= %d && path_next_segment(path, &pos, &seg[count], &len[count])) count++;\n\n",
+            most);
+    fprintf(out, "    switch (count) {\n");
+    for (int n = 0; n <= most + 1; n++) {
+        // Routes with exactly n segments, and wildcards needing at most n
+        int count = 0;
+        for (int i = 0; i < manifest->count; i++) {
+            const ManifestRoute *route = &manifest->routes[i];
+            if (route->pattern->is_static) continue;
+            if (route->fixed == n || (route->pattern->has_wildcards && route->fixed <= n)) routes[count++] = i;
+        }
+        if (count == 0) continue;
+        if (n <= most) fprintf(out, "    case %d:\n", n);
+        else fprintf(out, "    default:   // More segments than any fixed route: wildcards only\n");
+        emit_count_case(out, manifest, routes, count);
+        fprintf(out, "        break;\n");
+    }
+    fprintf(out, "    }\n    return -1;\n}\n\n");
+    free(routes);
+    return 0;
+}
+
+static int emit(FILE *out, const Manifest *manifest, const char *name, const char *manifest_name) {
+    int key_count = 0;
+    int *keys = static_keys(manifest, &key_count);
+    PerfectHash hash = { 0, 0, 0, NULL, NULL };
+    int status = 0;
+    if (!keys) return -1;
+    if (key_count > 0 && perfect_build(manifest, keys, key_count, &hash) < 0) {
+        fprintf(stderr, "routegen: could not place the static paths\n");
+        status = -1;
+        goto done;
+    }
+
+    fprintf(out, "// Generated by routegen from %s; do not edit.\n", manifest_name);
+    int parameterized = 0;
+    for (int i = 0; i < manifest->count; i++) parameterized += !manifest->routes[i].pattern->is_static;
+    fprintf(out, "// %d routes: %d static paths, %d parameterized routes.\n\n", manifest->count, key_count,
+            parameterized);
+    fprintf(out, "#include \"route_table.h\"\n#include \"route.h\"\n#include <stdint.h>\n#include <string.h>\n\n");
+
+    // One declaration per handler
+    for (int i = 0; i < manifest->count; i++) {
+        int seen = 0;
+        for (int j = 0; j < i && !seen; j++) seen = strcmp(manifest->routes[j].handler, manifest->routes[i].handler) == 0;
+        if (!seen) {
+            fprintf(out, "void %s(int client_fd, void (*next)(void *), void *context);\n",
+                    manifest->routes[i].handler);
+        }
+    }
+    fprintf(out, "\nstatic const RouteTableEntry %s_routes[%d] = {\n", name, manifest->count > 0 ? manifest->count : 1);
+    for (int i = 0; i < manifest->count; i++) {
+        const ManifestRoute *route = &manifest->routes[i];
+        fprintf(out, "    { HTTP_METHOD_BIT(HTTP_METHOD_%s), ", method_names[route->method]);
+        emit_string(out, route->path);
+        fprintf(out, ", %s },\n", route->handler);
+    }
+    if (manifest->count == 0) fprintf(out, "    { 0, NULL, NULL },\n");
+    fprintf(out, "};\n\n");
+
+    if (key_count > 0) emit_static_table(out, manifest, name, &hash);
+    if (emit_matcher(out, manifest, name) < 0) {
+        status = -1;
+        goto done;
+    }
+
+    fprintf(out, "static int %s_lookup(HttpMethod method, const char *path, ParamSlice *slices, int *slice_count,\n",
+            name);
+    fprintf(out, "%*sunsigned int *allowed) {\n", (int)(strlen(name) + 19), "");
+    fprintf(out, "    *slice_count = 0;\n    *allowed = 0;\n");
+    if (key_count > 0) {
+        fprintf(out, "    uint32_t hash = 2166136261u ^ %uu;\n    size_t length = 0;\n", hash.seed);
+        fprintf(out, "    for (; path[length]; length++) {\n");
+        fprintf(out, "        hash ^= (unsigned char)path[length];\n        hash *= 16777619u;\n    }\n");
+        fprintf(out, "    hash ^= %s_displace[hash & %du];\n", name, hash.buckets - 1);
+        fprintf(out, "    hash ^= hash >> 16;\n    hash *= 0x7feb352du;\n    hash ^= hash >> 15;\n");
+        fprintf(out, "    hash *= 0x846ca68bu;\n    hash ^= hash >> 16;\n");
+        fprintf(out, "    uint32_t slot = hash & %du;\n", hash.slots - 1);
+        fprintf(out, "    if (%s_static[slot].length == length && %s_static[slot].path &&\n", name, name);
+        fprintf(out, "        memcmp(%s_static[slot].path, path, length) == 0) {\n", name);
+        fprintf(out, "        int route = %s_static[slot].route[method];\n", name);
+        fprintf(out, "        if (route != %d) {\n", DEFER_TO_MATCHER);
+        fprintf(out, "            if (route < 0) *allowed = %s_static[slot].allowed;\n", name);
+        fprintf(out, "            return route;\n        }\n    }\n");
+    }
+    fprintf(out, "    return %s_match(method, path, slices, slice_count, allowed);\n}\n\n", name);
+
+    fprintf(out, "const RouteTable %s = { \"%s\", %s_routes, %d, %s_lookup };\n\n", name, name, name,
+            manifest->count, name);
+    fprintf(out, "void %s_handler(int client_fd, void (*next)(void *), void *context) {\n", name);
+    fprintf(out, "    route_table_dispatch(&%s, client_fd, next, context);\n}\n", name);
+    if (ferror(out)) status = -1;
+
+done:
+    free(hash.displace);
+    free(hash.slot_key);
+    free(keys);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    const char *name = "routes";
+    int arg = 1;
+    if (arg + 1 < argc && strcmp(argv[arg], "-n") == 0) {
+        name = argv[arg + 1];
+        arg += 2;
+    }
+    if (arg >= argc || argc - arg > 2 || !is_identifier(name)) {
+        fprintf(stderr, "usage: routegen [-n name] manifest [output.c]\n");
+        return 2;
+    }
+
+    Manifest manifest = { NULL, 0, 0 };
+    int status = manifest_read(&manifest, argv[arg]) == 0 ? 0 : 1;
+    if (status == 0) {
+        FILE *out = arg + 1 < argc ? fopen(argv[arg + 1], "w") : stdout;
+        if (!out) {
+            perror(argv[arg + 1]);
+            status = 1;
+        } else {
+            if (emit(out, &manifest, name, argv[arg]) < 0) status = 1;
+            if (out != stdout && fclose(out) != 0) status = 1;
+            if (status != 0) fprintf(stderr, "routegen: could not write the table\n");
+        }
+    }
+
+    for (int i = 0; i < manifest.count; i++) {
+        free(manifest.routes[i].path);
+        free(manifest.routes[i].handler);
+        free_route_pattern(manifest.routes[i].pattern);
+    }
+    free(manifest.routes);
+    return status;
+}